@@ -0,0 +1,186 @@
+#include "area_downscale.h"
+#include "morph_binary_bitpacked.h"
+#include <string.h>
+
+// 竖直累加用 SSE2 / NEON（两者分别是 x86-64 与 AArch64 的基线指令集，无需运行时分派）
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define AREA_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define AREA_NEON 1
+#endif
+
+// BT.601 亮度系数（Q14，与 OpenCV BGR2GRAY 相同）：R 4899、G 9617、B 1868，和为 16384
+#define AREA_LUMA_SHIFT 14
+#define AREA_LUMA_R 4899u
+#define AREA_LUMA_G 9617u
+#define AREA_LUMA_B 1868u
+
+static int area_channels(area_src_format fmt) {
+    switch (fmt) {
+    case AREA_SRC_GRAY: return 1;
+    case AREA_SRC_BGR:
+    case AREA_SRC_RGB:  return 3;
+    case AREA_SRC_BGRA:
+    case AREA_SRC_RGBA: return 4;
+    default:            return 0;
+    }
+}
+
+// 目标坐标 d 对应的源区间 [*lo,*hi)，至少包含一个源像素
+static void area_span(int d, int src_n, int dst_n, int* lo, int* hi) {
+    int a = (int)((long long)d * src_n / dst_n);
+    int b = (int)((long long)(d + 1) * src_n / dst_n);
+    if (b <= a) b = a + 1;
+    if (b > src_n) { b = src_n; a = b - 1; }
+    *lo = a;
+    *hi = b;
+}
+
+static int area_args_ok(const uint8_t* src, int src_w, int src_h, int src_stride, area_src_format fmt,
+                        int dst_w, int dst_h, int row_begin, int row_end) {
+    int ch = area_channels(fmt);
+    if (!src || ch == 0) return 0;
+    if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) return 0;
+    if (dst_w > AREA_DOWNSCALE_MAX_DST_W) return 0;
+    if (src_stride < src_w * ch) return 0;
+    if (row_begin < 0 || row_end > dst_h || row_begin > row_end) return 0;
+    return 1;
+}
+
+// 列和暂存区（uint16 元素个数）：源行按目标列边界切段，每段先竖直累加再水平求和
+#define AREA_COLSUM_MAX 8192
+// uint16 列和最多容纳 257 行 255（257*255 = 65535）
+#define AREA_COLSUM_MAX_ROWS 257
+
+static uint8_t area_luma(uint32_t s0, uint32_t s1, uint32_t s2, uint32_t c0, uint32_t c2, uint32_t n) {
+    // 大图（如 8K）时矩形和乘系数会超过 32 位，换算用 64 位
+    uint64_t den = (uint64_t)n << AREA_LUMA_SHIFT;
+    uint64_t luma = (uint64_t)c0 * s0 + (uint64_t)AREA_LUMA_G * s1 + (uint64_t)c2 * s2;
+    return (uint8_t)((luma + (den >> 1)) / den);
+}
+
+// 通用路径：直接对每个源矩形逐像素求和（源矩形特别高或特别宽、列和暂存区放不下时使用）
+static uint8_t area_pixel_direct(const uint8_t* src, int src_stride, int ch, int x0, int x1, int y0, int y1,
+                                 uint32_t c0, uint32_t c2) {
+    uint32_t s0 = 0, s1 = 0, s2 = 0;
+    uint32_t n = (uint32_t)((x1 - x0) * (y1 - y0));
+    for (int y = y0; y < y1; y++) {
+        const uint8_t* p = src + (size_t)y * src_stride + (size_t)x0 * ch;
+        for (int x = x0; x < x1; x++, p += ch) {
+            s0 += p[0];
+            if (ch > 1) {
+                s1 += p[1];
+                s2 += p[2];
+            }
+        }
+    }
+    if (ch == 1) return (uint8_t)((s0 + (n >> 1)) / n);
+    return area_luma(s0, s1, s2, c0, c2, n);
+}
+
+// colsum[i] += row[i]，i ∈ [0,n)：u8 零扩展到 u16 后相加
+static void area_accumulate_row(uint16_t* colsum, const uint8_t* row, int n) {
+    int i = 0;
+#if defined(AREA_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i lo = _mm_loadu_si128((const __m128i*)(colsum + i));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(colsum + i + 8));
+        _mm_storeu_si128((__m128i*)(colsum + i), _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero)));
+        _mm_storeu_si128((__m128i*)(colsum + i + 8), _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero)));
+    }
+#elif defined(AREA_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(row + i);
+        vst1q_u16(colsum + i, vaddw_u8(vld1q_u16(colsum + i), vget_low_u8(v)));
+        vst1q_u16(colsum + i + 8, vaddw_u8(vld1q_u16(colsum + i + 8), vget_high_u8(v)));
+    }
+#endif
+    for (; i < n; i++) colsum[i] = (uint16_t)(colsum[i] + row[i]);
+}
+
+// 计算一整行目标灰度：先把 [y0,y1) 源行逐字节竖直累加成列和（连续内存，SIMD 一次 16 字节），
+// 再按目标列区间水平求和，最后每个目标像素只做一次亮度换算与取整
+static void area_row(const uint8_t* src, int src_w, int src_h, int src_stride, area_src_format fmt,
+                     const int* x0, const int* x1, int dst_w, int dst_h, int dy, uint8_t* out) {
+    uint16_t colsum[AREA_COLSUM_MAX];
+    int ch = area_channels(fmt);
+    int bgr = (fmt == AREA_SRC_BGR || fmt == AREA_SRC_BGRA);
+    uint32_t c0 = bgr ? AREA_LUMA_B : AREA_LUMA_R; // 通道 0/2 的系数按 BGR/RGB 顺序对应
+    uint32_t c2 = bgr ? AREA_LUMA_R : AREA_LUMA_B;
+    int y0, y1;
+    (void)src_w;
+    area_span(dy, src_h, dst_h, &y0, &y1);
+
+    int dx = 0;
+    while (dx < dst_w) {
+        // 本段覆盖目标列 [dx,end)，对应源列 [sx,x1[end-1])
+        int sx = x0[dx];
+        int end = dx;
+        while (end < dst_w && (x1[end] - sx) * ch <= AREA_COLSUM_MAX) end++;
+        if (end == dx || y1 - y0 > AREA_COLSUM_MAX_ROWS) {
+            out[dx] = area_pixel_direct(src, src_stride, ch, x0[dx], x1[dx], y0, y1, c0, c2);
+            dx++;
+            continue;
+        }
+
+        int n = (x1[end - 1] - sx) * ch;
+        const uint8_t* base = src + (size_t)sx * ch;
+        memset(colsum, 0, (size_t)n * sizeof(uint16_t));
+        for (int y = y0; y < y1; y++) {
+            area_accumulate_row(colsum, base + (size_t)y * src_stride, n);
+        }
+
+        for (; dx < end; dx++) {
+            const uint16_t* c = colsum + (size_t)(x0[dx] - sx) * ch;
+            int w = x1[dx] - x0[dx];
+            uint32_t area = (uint32_t)(w * (y1 - y0));
+            if (ch == 1) {
+                uint32_t s0 = 0;
+                for (int x = 0; x < w; x++) s0 += c[x];
+                out[dx] = (uint8_t)((s0 + (area >> 1)) / area);
+            } else {
+                uint32_t s0 = 0, s1 = 0, s2 = 0;
+                for (int x = 0; x < w; x++, c += ch) {
+                    s0 += c[0];
+                    s1 += c[1];
+                    s2 += c[2];
+                }
+                out[dx] = area_luma(s0, s1, s2, c0, c2, area);
+            }
+        }
+    }
+}
+
+int area_downscale_gray_rows(const uint8_t* src, int src_w, int src_h, int src_stride, area_src_format fmt,
+                             uint8_t* dst, int dst_w, int dst_h, int dst_stride,
+                             int row_begin, int row_end) {
+    int x0[AREA_DOWNSCALE_MAX_DST_W], x1[AREA_DOWNSCALE_MAX_DST_W];
+    if (!dst || dst_stride < dst_w) return -1;
+    if (!area_args_ok(src, src_w, src_h, src_stride, fmt, dst_w, dst_h, row_begin, row_end)) return -1;
+    for (int dx = 0; dx < dst_w; dx++) area_span(dx, src_w, dst_w, &x0[dx], &x1[dx]);
+    for (int dy = row_begin; dy < row_end; dy++) {
+        area_row(src, src_w, src_h, src_stride, fmt, x0, x1, dst_w, dst_h, dy, dst + (size_t)dy * dst_stride);
+    }
+    return 0;
+}
+
+int area_downscale_threshold_rows(const uint8_t* src, int src_w, int src_h, int src_stride, area_src_format fmt,
+                                  uint8_t threshold, uint32_t* dst_bits, int dst_w, int dst_h,
+                                  int row_begin, int row_end) {
+    int x0[AREA_DOWNSCALE_MAX_DST_W], x1[AREA_DOWNSCALE_MAX_DST_W];
+    uint8_t gray[AREA_DOWNSCALE_MAX_DST_W];
+    int wpw = words_per_row(dst_w);
+    if (!dst_bits) return -1;
+    if (!area_args_ok(src, src_w, src_h, src_stride, fmt, dst_w, dst_h, row_begin, row_end)) return -1;
+    for (int dx = 0; dx < dst_w; dx++) area_span(dx, src_w, dst_w, &x0[dx], &x1[dx]);
+    for (int dy = row_begin; dy < row_end; dy++) {
+        // 灰度只存在于这一行暂存区，随即用 SIMD 阈值打包
+        area_row(src, src_w, src_h, src_stride, fmt, x0, x1, dst_w, dst_h, dy, gray);
+        pack_gray_threshold_to_bits(gray, dst_w, 1, dst_w, threshold, dst_bits + (size_t)dy * wpw);
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef AREA_DOWNSCALE_H
+#define AREA_DOWNSCALE_H
+
+/*
+  本模块把全分辨率相机帧一步缩小到处理尺寸（188×120），输出灰度或位打包二值图。
+
+  设计说明：
+  - 区域平均：每个目标像素对应源图中 [x0,x1)×[y0,y1) 的整数矩形，
+    x0 = dx*src_w/dst_w，x1 = (dx+1)*src_w/dst_w（至少 1 个像素，放大时退化为最近邻）。
+  - 先对矩形内各通道求和，再做一次 BT.601 亮度换算（系数与 cv::COLOR_BGR2GRAY 相同，Q14），
+    亮度是线性运算，因此与“先全分辨率转灰度再区域平均”的结果一致，但每个目标像素只换算一次。
+  - 支持单通道（灰度或 YUV 的 Y 平面，按 stride 读取）、BGR/RGB、BGRA/RGBA（alpha 忽略）。
+  - 行分块：row_begin/row_end 指定目标行区间，不同区间之间互不依赖，
+    调用者可以把目标行切成若干块交给多个线程（如 cv::parallel_for_）并行处理。
+  - 位打包输出与 morph_binary_bitpacked 的布局一致：bit = (灰度 > threshold)。
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 目标宽度上限（列区间表放在栈上） */
+#define AREA_DOWNSCALE_MAX_DST_W 1024
+
+typedef enum {
+    AREA_SRC_GRAY = 0, /* 单通道灰度 / Y 平面 */
+    AREA_SRC_BGR,
+    AREA_SRC_RGB,
+    AREA_SRC_BGRA,
+    AREA_SRC_RGBA
+} area_src_format;
+
+/* 缩小到灰度：写 dst 的 [row_begin,row_end) 行（行跨度 dst_stride 字节）；参数非法返回 -1 */
+int area_downscale_gray_rows(const uint8_t* src, int src_w, int src_h, int src_stride, area_src_format fmt,
+                             uint8_t* dst, int dst_w, int dst_h, int dst_stride,
+                             int row_begin, int row_end);
+
+/* 缩小并阈值化：直接写位打包行（每行 words_per_row(dst_w) 个 word），不落地灰度图；参数非法返回 -1 */
+int area_downscale_threshold_rows(const uint8_t* src, int src_w, int src_h, int src_stride, area_src_format fmt,
+                                  uint8_t threshold, uint32_t* dst_bits, int dst_w, int dst_h,
+                                  int row_begin, int row_end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AREA_DOWNSCALE_H
@@ -0,0 +1,917 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include "pipeline_context.h"
+#include "morph_binary_bitpacked.h"
+#include "area_downscale.h"
+#include "kalman.h"
+#include "frame_archive.h"
+#include "chain_code.h"
+#ifdef HAVE_OPENCV
+#include <opencv2/opencv.hpp>
+#endif
+
+namespace fs = std::filesystem;
+
+// image_internal 内核微基准
+//   bench_image_internal [--data DIR] [--max-real N] [--synthetic N] [--warmup N] [--reps N] [--filter S]
+//                        [--json out.json] [--baseline base.json] [--tolerance 0.10] [--self-check N]
+// 语料：data/*/output.mp4 各解码一次（区域平均缩小到 188x120 灰度，需 OpenCV），加上 --synthetic 帧合成赛道；
+//       之后所有基准都只在内存里的语料上循环，不再有解码开销。
+// 每个基准先空跑 --warmup 遍语料，再计时 --reps 遍，报告每帧纳秒数的中位数 / 最小值 / 最大值。
+// --json 写出结果；--baseline 读取之前保存的 JSON，中位数比基线慢超过 --tolerance（比例）时标记回归，退出码为 1。
+// --self-check N 只跑 N 例形态学差分自检（各实现与四遍参考逐位比较），构建后自动执行一次。
+
+static const int W = image_w;
+static const int H = image_h;
+static const uint8_t BINARY_THRESHOLD = 128;
+static const int WORDS = PIPELINE_MORPH_WORDS;
+
+struct Options {
+    fs::path dataDir = "data";
+    int maxReal = 300;   // 每个视频最多取的帧数
+    int synthetic = 300;
+    int warmup = 3;
+    int reps = 15;
+    std::string filter;
+    fs::path json;
+    fs::path baseline;
+    double tolerance = 0.10;
+    int selfCheck = 0;   // >0 时只运行形态学差分自检
+};
+
+struct Result {
+    std::string name;
+    double median_ns = 0, min_ns = 0, max_ns = 0;
+    int frames = 0;
+};
+
+// 语料：每帧一份 188x120 灰度（行跨度 W）与其阈值打包结果，外加整条流水线跑一遍后留下的中间量
+struct Frame {
+    std::vector<uint8_t> gray;
+    std::vector<uint32_t> packed;   // 阈值打包输入
+    std::vector<uint32_t> traced;   // 形态学 + 填黑框之后（八邻域的输入）
+    std::vector<uint16_t> dir_l, dir_r;
+    BorderStats border;
+    kalman_real z[2];               // 卡尔曼观测（有第一角点时取其位置，否则沿用上一帧）
+    std::vector<uint8_t> delta;     // 相对语料中上一帧的 .ipf 增量编码（第一帧相对全 0）
+};
+
+// ---------------- 语料 ----------------
+
+// 合成赛道：白色赛道 + 十字 / 环岛 / 弯道 / 分叉 + 椒盐噪声，灰度带一点渐变
+static void synth_frame(int k, uint8_t *gray) {
+    std::mt19937 rng(k * 7919u + 13u);
+    const int kind = k % 6;
+    const double phase = k * 0.07;
+    for (int y = 0; y < H; ++y) {
+        double t = (H - 1 - y) / (double)(H - 1);
+        double center = W / 2 + 40 * std::sin(phase + t * (kind == 1 ? 3.0 : 1.2)) * t;
+        double half = 80 - 55 * t;
+        int l = (int)(center - half), r = (int)(center + half);
+        for (int x = 0; x < W; ++x) {
+            bool w = x >= l && x <= r;
+            if (kind == 2 && y > 40 && y < 65) w = true;                         // 十字
+            if (kind == 3 && y > 30 && y < 70 && x > r && x < r + 30) w = true;   // 右环
+            if (kind == 4 && y > 30 && y < 70 && x < l && x > l - 30) w = true;   // 左环
+            if (kind == 5 && y < 50) w = w && (x < 80 || x > 110);               // 分叉
+            gray[y * W + x] = (uint8_t)(w ? 200 + (y & 31) : 40 + (x & 31));
+        }
+    }
+    int noise = (int)(rng() % 200);
+    for (int i = 0; i < noise; ++i) {
+        int y = (int)(rng() % H), x = (int)(rng() % W);
+        gray[y * W + x] = (uint8_t)(255 - gray[y * W + x]);
+    }
+}
+
+#ifdef HAVE_OPENCV
+static int load_real_frames(const Options &opt, std::vector<Frame> &corpus) {
+    std::vector<fs::path> videos;
+    std::error_code ec;
+    for (fs::directory_iterator it(opt.dataDir, ec), end; !ec && it != end; it.increment(ec)) {
+        fs::path v = it->path() / "output.mp4";
+        if (it->is_directory() && fs::exists(v)) videos.push_back(v);
+    }
+    std::sort(videos.begin(), videos.end());
+    int loaded = 0;
+    for (const fs::path &v : videos) {
+        cv::VideoCapture cap(v.string());
+        if (!cap.isOpened()) {
+            std::cerr << "警告: 无法打开视频，跳过: " << v << std::endl;
+            continue;
+        }
+        cv::Mat m;
+        for (int n = 0; n < opt.maxReal && cap.read(m); ++n) {
+            area_src_format fmt = m.channels() == 1 ? AREA_SRC_GRAY : (m.channels() == 4 ? AREA_SRC_BGRA : AREA_SRC_BGR);
+            Frame f;
+            f.gray.resize((size_t)W * H);
+            if (m.depth() != CV_8U ||
+                area_downscale_gray_rows(m.data, m.cols, m.rows, (int)m.step, fmt, f.gray.data(), W, H, W, 0, H) != 0) {
+                break;
+            }
+            corpus.push_back(std::move(f));
+            ++loaded;
+        }
+    }
+    return loaded;
+}
+#endif
+
+// 打包并跑一遍流水线，记录各内核的输入
+static void prepare_corpus(std::vector<Frame> &corpus) {
+    std::unique_ptr<PipelineContext> ctx(new PipelineContext);
+    pipeline_context_init(ctx.get());
+    ctx->log_enabled = 0;
+    std::vector<uint8_t> out((size_t)W * H);
+    std::vector<uint32_t> tmp(WORDS);
+    kalman_real last[2] = {KALMAN_FROM_INT(W / 2), KALMAN_FROM_INT(H / 2)};
+    std::vector<uint32_t> prev(WORDS, 0);
+    for (Frame &f : corpus) {
+        f.packed.resize(WORDS);
+        pack_gray_threshold_to_bits(f.gray.data(), W, H, W, BINARY_THRESHOLD, f.packed.data());
+        f.delta.resize(IPF_DELTA_BOUND(WORDS));
+        f.delta.resize(ipf_delta_encode(prev.data(), f.packed.data(), WORDS, f.delta.data()));
+        prev = f.packed;
+        f.traced.resize(WORDS);
+        open_close_bitpacked_fused(f.packed.data(), tmp.data(), f.traced.data(), W, H);
+        image_draw_rectan_bits(f.traced.data());
+
+        image_process_packed_ctx(ctx.get(), f.packed.data(), out.data());
+        f.dir_l.assign(ctx->dir_l, ctx->dir_l + ctx->data_stastics_l);
+        f.dir_r.assign(ctx->dir_r, ctx->dir_r + ctx->data_stastics_r);
+        f.border = ctx->border_stats;
+        if (ctx->first_corner) {
+            last[0] = KALMAN_FROM_INT(ctx->firstcorner_pos[0]);
+            last[1] = KALMAN_FROM_INT(ctx->firstcorner_pos[1]);
+        }
+        f.z[0] = last[0];
+        f.z[1] = last[1];
+    }
+}
+
+// ---------------- 计时 ----------------
+
+static volatile uint64_t g_sink; // 防止结果被优化掉
+
+// reset 在每遍之前调用（不计时），body(f) 处理一帧并返回一个校验值
+template <class Reset, class Body>
+static Result run_bench(const std::string &name, const Options &opt, const std::vector<Frame> &corpus, Reset reset,
+                        Body body) {
+    using clock = std::chrono::steady_clock;
+    Result r;
+    r.name = name;
+    r.frames = (int)corpus.size();
+    std::vector<double> ns;
+    uint64_t acc = 0;
+    for (int rep = 0; rep < opt.warmup + opt.reps; ++rep) {
+        reset();
+        auto t0 = clock::now();
+        for (const Frame &f : corpus) acc += body(f);
+        auto t1 = clock::now();
+        if (rep >= opt.warmup) {
+            ns.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)corpus.size());
+        }
+    }
+    g_sink = g_sink + acc;
+    std::sort(ns.begin(), ns.end());
+    r.median_ns = ns[ns.size() / 2];
+    r.min_ns = ns.front();
+    r.max_ns = ns.back();
+    return r;
+}
+
+// ---------------- JSON ----------------
+
+static bool write_json(const fs::path &p, const std::vector<Result> &results, int real, int synthetic) {
+    std::ofstream ofs(p, std::ios::trunc);
+    if (!ofs) return false;
+    ofs << std::fixed << std::setprecision(1);
+    ofs << "{\n";
+    ofs << "  \"simd\": \"" << morph_simd_backend() << "\",\n";
+#ifdef IMAGEPROC_FIXED_POINT
+    ofs << "  \"profile\": \"fixed\",\n";
+#else
+    ofs << "  \"profile\": \"float\",\n";
+#endif
+    ofs << "  \"corpus\": { \"real\": " << real << ", \"synthetic\": " << synthetic << " },\n";
+    ofs << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        ofs << "    { \"name\": \"" << r.name << "\", \"frames\": " << r.frames << ", \"median_ns\": " << r.median_ns
+            << ", \"min_ns\": " << r.min_ns << ", \"max_ns\": " << r.max_ns << " }"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    ofs << "  ]\n}\n";
+    return (bool)ofs;
+}
+
+// 只读本工具写出的格式：逐个取 "name" 与其后的 "median_ns"
+static bool load_baseline(const fs::path &p, std::map<std::string, double> &base) {
+    std::ifstream ifs(p);
+    if (!ifs) return false;
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    const std::string s = ss.str();
+    size_t pos = 0;
+    while ((pos = s.find("\"name\"", pos)) != std::string::npos) {
+        size_t q0 = s.find('"', s.find(':', pos) + 1);
+        size_t q1 = s.find('"', q0 + 1);
+        size_t m = s.find("\"median_ns\"", q1);
+        if (q0 == std::string::npos || q1 == std::string::npos || m == std::string::npos) break;
+        base[s.substr(q0 + 1, q1 - q0 - 1)] = std::strtod(s.c_str() + s.find(':', m) + 1, nullptr);
+        pos = m;
+    }
+    return true;
+}
+
+// ---------------- 自检 ----------------
+
+// 形态学差分自检：随机尺寸 / 密度的位图上，四遍 open_close_bitpacked 作为参考，
+// 与单遍 fused、行同步流式接口、寄存器驻留 SIMD（可用时）、位切片整批版本（2..64 帧）逐位比较。
+// 构建后由 CMake 自动运行（BENCH_SELF_CHECK），返回不一致的用例数。
+static int run_self_check(int cases) {
+    std::mt19937 rng(20240601u);
+    int failures = 0;
+    std::vector<uint64_t> work;
+    for (int c = 0; c < cases; ++c) {
+        // 前几例覆盖边界尺寸，其余随机；宽度超过流式缓冲时 fused 走四遍回退
+        const int w = c < 4 ? (c % 2 ? 1 : W) : (int)(rng() % (MORPH_STREAM_MAX_WPR * 32 + 64)) + 1;
+        const int h = c < 4 ? (c < 2 ? 1 : H) : (int)(rng() % (H + 10)) + 1;
+        const int n = total_words(w, h);
+        const int wpr = words_per_row(w);
+        const uint32_t density = rng() % 100;
+        const uint32_t tail = (w & 31) ? ((1u << (w & 31)) - 1u) : 0xFFFFFFFFu;
+        // 每像素以 d% 的概率为白；一次 rng() 取 4 个字节各决定一个像素
+        auto random_frame = [&](uint32_t *dst, uint32_t d) {
+            const uint32_t t = d * 256u / 100u;
+            for (int y = 0; y < h; ++y) {
+                for (int i = 0; i < wpr; ++i) {
+                    uint32_t v = 0;
+                    for (int b = 0; b < 32; b += 4) {
+                        uint32_t r = (uint32_t)rng();
+                        for (int k = 0; k < 4; ++k) v |= (uint32_t)(((r >> (8 * k)) & 0xFFu) < t) << (b + k);
+                    }
+                    dst[(size_t)y * wpr + i] = (i == wpr - 1) ? (v & tail) : v;
+                }
+            }
+        };
+
+        std::vector<uint32_t> src(n), tmp(n), ref(n), got(n);
+        random_frame(src.data(), density);
+        open_close_bitpacked(src.data(), tmp.data(), ref.data(), w, h);
+
+        auto expect = [&](const char *what) {
+            if (got != ref) {
+                std::fprintf(stderr, "自检失败: %s 与 open_close_bitpacked 不一致（%dx%d，密度 %u%%）\n",
+                             what, w, h, density);
+                ++failures;
+            }
+        };
+
+        std::fill(got.begin(), got.end(), 0xA5A5A5A5u);
+        open_close_bitpacked_fused(src.data(), tmp.data(), got.data(), w, h);
+        expect("open_close_bitpacked_fused");
+
+        MorphOpenCloseStream st;
+        std::fill(got.begin(), got.end(), 0xA5A5A5A5u);
+        if (morph_stream_init(&st, w, h, got.data()) == 0) {
+            int last = -1;
+            for (int y = 0; y < h; ++y) last = morph_stream_push_row(&st, src.data() + (size_t)y * wpr);
+            if (last != h - 1) {
+                std::fprintf(stderr, "自检失败: morph_stream 只输出到第 %d 行（%dx%d）\n", last, w, h);
+                ++failures;
+            }
+            expect("morph_stream_push_row");
+        }
+
+        std::fill(got.begin(), got.end(), 0xA5A5A5A5u);
+        if (open_close_bitpacked_simd(src.data(), got.data(), w, h) == 0) expect("open_close_bitpacked_simd");
+
+        // 位切片整批：每例 2..64 帧（每三例一次满批，其余为不满的批），逐帧与参考比较，覆盖全部 lane 的转置
+        {
+            const int nb = (c % 3 == 0) ? MORPH_BATCH_LANES : 2 + (int)(rng() % (MORPH_BATCH_LANES - 2));
+            std::vector<uint32_t> frames((size_t)nb * n), batch_out((size_t)nb * n, 0xA5A5A5A5u);
+            std::copy(src.begin(), src.end(), frames.begin());
+            for (int f = 1; f < nb; ++f) random_frame(frames.data() + (size_t)f * n, rng() % 100);
+            work.resize(morph_batch_workspace_words(w, h));
+            morph_open_close_batch(frames.data(), batch_out.data(), nb, w, h, work.data());
+            for (int f = 0; f < nb; ++f) {
+                open_close_bitpacked(frames.data() + (size_t)f * n, tmp.data(), ref.data(), w, h);
+                got.assign(batch_out.begin() + (ptrdiff_t)f * n, batch_out.begin() + (ptrdiff_t)(f + 1) * n);
+                if (got != ref) {
+                    std::fprintf(stderr, "自检失败: morph_open_close_batch 第 %d/%d 帧与 open_close_bitpacked 不一致（%dx%d）\n",
+                                 f, nb, w, h);
+                    ++failures;
+                    break;
+                }
+            }
+        }
+    }
+    std::cout << "形态学自检: " << cases << " 例，失败 " << failures << " 例" << std::endl;
+    return failures;
+}
+
+// 链码往返自检：合成赛道上跑流水线，每边的 points + dir 经 chain_encode 后
+// 文本（chain_format → chain_parse，userlog / replay_check 的路径）与二进制（serialize → deserialize）各往返一次，
+// 还原出的点集与生长方向必须逐点一致，chain_point 随机访问与反向迭代也逐点比较；
+// 另外人为制造一次跳步（ok = 0，文本只带生长方向），并确认截断的文本被 chain_parse 拒绝。返回不一致的边数。
+static int run_chain_check(int frames) {
+    std::unique_ptr<PipelineContext> ctx(new PipelineContext);
+    pipeline_context_init(ctx.get());
+    ctx->log_enabled = 0;
+    std::vector<uint8_t> gray((size_t)W * H), out((size_t)W * H);
+    std::vector<uint32_t> packed(WORDS);
+    std::mt19937 rng(20240611u);
+    chain_code c, back;
+    char text[CHAIN_TEXT_MAX], again[CHAIN_TEXT_MAX];
+    uint8_t bin[CHAIN_SERIAL_MAX];
+    uint16_t pts[CHAIN_MAX_POINTS][2], dirs[CHAIN_MAX_POINTS];
+    long long sides = 0, points = 0, tails = 0, bad = 0;
+    int failures = 0;
+    auto fail = [&](int k, int side, const char *what) {
+        if (failures < 5) std::fprintf(stderr, "自检失败: 链码 第 %d 帧%s边 %s\n", k, side ? "右" : "左", what);
+        ++failures;
+    };
+    for (int k = 0; k < frames; ++k) {
+        synth_frame(k, gray.data());
+        pack_gray_threshold_to_bits(gray.data(), W, H, W, BINARY_THRESHOLD, packed.data());
+        image_process_packed_ctx(ctx.get(), packed.data(), out.data());
+        for (int side = 0; side < 2; ++side) {
+            const uint16_t(*p)[2] = side ? ctx->points_r : ctx->points_l;
+            const uint16_t *d = side ? ctx->dir_r : ctx->dir_l;
+            const uint16_t n = side ? ctx->data_stastics_r : ctx->data_stastics_l;
+            chain_encode(&c, p, d, n);
+            ++sides;
+            points += n;
+            tails += c.tail != 0;
+            // 文本往返
+            if (chain_format(&c, text, sizeof(text)) < 0 || chain_parse(&back, text) < 0 ||
+                chain_format(&back, again, sizeof(again)) < 0 || std::strcmp(text, again) != 0) {
+                fail(k, side, "文本往返不一致");
+                continue;
+            }
+            if ((chain_decode(&back, c.ok ? pts : nullptr, dirs) < 0 && c.ok) ||
+                (c.ok && std::memcmp(pts, p, n * sizeof(pts[0])) != 0) || std::memcmp(dirs, d, n * sizeof(dirs[0])) != 0) {
+                fail(k, side, "chain_parse 还原的点集 / 生长方向不一致");
+                continue;
+            }
+            if (!c.ok) {
+                ++bad; // 追踪出现跳步：只有生长方向可比（上面已比较）
+                continue;
+            }
+            // 二进制往返
+            const size_t len = chain_serialize(&c, bin, sizeof(bin));
+            if (len == 0 || chain_deserialize(&back, bin, len) < 0 || chain_decode(&back, pts, dirs) < 0 ||
+                std::memcmp(pts, p, n * sizeof(pts[0])) != 0 || std::memcmp(dirs, d, n * sizeof(dirs[0])) != 0) {
+                fail(k, side, "二进制往返不一致");
+                continue;
+            }
+            // 随机访问与反向迭代
+            bool ok = true;
+            for (int t = 0; t < 8 && n > 0 && ok; ++t) {
+                const uint16_t i = (uint16_t)(rng() % n);
+                uint8_t x, y;
+                ok = chain_point(&c, i, &x, &y) == 0 && x == p[i][0] && y == p[i][1] && chain_dir(&c, i) == d[i];
+            }
+            chain_iter it;
+            if (ok && n > 0 && chain_iter_at(&it, &c, (uint16_t)(n - 1)) == 0) {
+                do {
+                    ok = it.x == p[it.i][0] && it.y == p[it.i][1] && chain_iter_dir(&it) == d[it.i];
+                } while (ok && chain_iter_prev(&it));
+                ok = ok && it.i == 0;
+            }
+            if (!ok) {
+                fail(k, side, "chain_point / 反向迭代与数组不一致");
+                continue;
+            }
+            // 截断的文本必须被拒绝（日志行被截断时不能还原出错误的 dir）
+            const size_t cut = std::strlen(text) * (1 + rng() % 7) / 8;
+            text[cut] = '\0';
+            if (n > 1 && cut > 0 && chain_parse(&back, text) == 0) fail(k, side, "截断的文本没有被拒绝");
+        }
+        // 人为制造的两种情形（合成赛道上很少出现）：末尾停住的原地点；中途跳步（坐标不可用，文本只保留生长方向）
+        const uint16_t n = ctx->data_stastics_l;
+        if (n > 2 && n + 3 <= CHAIN_MAX_POINTS) {
+            std::memcpy(pts, ctx->points_l, n * sizeof(pts[0]));
+            std::memcpy(dirs, ctx->dir_l, n * sizeof(dirs[0]));
+            for (int t = 0; t < 3; ++t) {
+                std::memcpy(pts[n + t], pts[n - 1], sizeof(pts[0]));
+                dirs[n + t] = (uint16_t)(rng() % 8);
+            }
+            uint16_t want[CHAIN_MAX_POINTS][2], want_dirs[CHAIN_MAX_POINTS];
+            std::memcpy(want, pts, (n + 3) * sizeof(pts[0]));
+            std::memcpy(want_dirs, dirs, (n + 3) * sizeof(dirs[0]));
+            chain_encode(&c, want, want_dirs, (uint16_t)(n + 3));
+            if (c.tail != 3 || chain_format(&c, text, sizeof(text)) < 0 || chain_parse(&back, text) < 0 ||
+                chain_decode(&back, pts, dirs) < 0 || std::memcmp(pts, want, (n + 3) * sizeof(pts[0])) != 0 ||
+                std::memcmp(dirs, want_dirs, (n + 3) * sizeof(dirs[0])) != 0) {
+                fail(k, 0, "带末尾原地点的链往返不一致");
+            }
+            want[n / 2][0] = (uint16_t)(want[n / 2][0] + 5);
+            chain_encode(&c, want, want_dirs, n);
+            if (c.ok || chain_format(&c, text, sizeof(text)) < 0 || chain_parse(&back, text) < 0 || back.ok ||
+                back.count != n || chain_decode(&back, nullptr, dirs) != -1 ||
+                std::memcmp(dirs, want_dirs, n * sizeof(dirs[0])) != 0) {
+                fail(k, 0, "跳步链的生长方向往返不一致");
+            }
+        }
+    }
+    chain_encode(&c, nullptr, nullptr, 0);
+    if (chain_format(&c, text, sizeof(text)) < 0 || chain_parse(&back, text) < 0 || back.count != 0) fail(-1, 0, "空链往返失败");
+    std::cout << "链码自检: " << frames << " 帧 " << sides << " 条边（" << points << " 点，" << tails
+              << " 条带末尾原地点，" << bad << " 条有跳步），失败 " << failures << " 条" << std::endl;
+    return failures;
+}
+
+static double kalman_to_double(kalman_real v) {
+#ifdef IMAGEPROC_FIXED_POINT
+    return (double)v / (1 << KALMAN_Q);
+#else
+    return (double)v;
+#endif
+}
+
+// KalmanBank 自检：32 路各配一个独立的 KalmanFilter 作参考，生命周期按 kalman.h 的约定逐路模拟
+// （有观测且未激活 → 初始化；门控拒绝或无观测 → 丢失计数，达到 max_loss 停用；定期主动 release）。
+// 轨迹含连续丢帧（超过 max_loss）与远离预测的离群观测（必被门控拒绝），每帧比较状态、协方差、激活位与丢失计数。
+// 两边只差运算顺序带来的舍入：浮点按 1e-3 相对误差比较，定点见 close()。返回不一致的帧数。
+static int run_kalman_bank_check(int frames) {
+    const int n = KALMAN_BANK_MAX;
+    const uint8_t max_loss = 5;
+    const kalman_real q = KALMAN_CONST(1.0f), r = KALMAN_CONST(20.0f), gate = KALMAN_CONST(9.21f);
+    std::mt19937 rng(20240607u);
+    KalmanBank bank;
+    kalman_bank_init(&bank, (uint8_t)n, q, r, max_loss, gate);
+    std::vector<KalmanFilter> ref(n);
+    std::vector<int> active(n, 0), loss(n, 0), drop(n, 0);
+    std::vector<double> px(n), py(n), vx(n), vy(n);
+    for (int i = 0; i < n; ++i) {
+        px[i] = 20 + rng() % 140;
+        py[i] = 10 + rng() % 100;
+        vx[i] = ((int)(rng() % 7) - 3) * 0.5;
+        vy[i] = ((int)(rng() % 5) - 2) * 0.5;
+    }
+    long long starts = 0, rejects = 0, expiries = 0, releases = 0;
+    int failures = 0;
+    auto close = [](kalman_real a, kalman_real b) {
+#ifdef IMAGEPROC_FIXED_POINT
+        // KalmanFilter 定点版的增益只有 Q12 精度（K 约 0.05~0.2），误差随更新累积：放宽到 1/8 像素 + 3%
+        int64_t d = (int64_t)a - b;
+        int64_t m = b < 0 ? -(int64_t)b : b;
+        return (d < 0 ? -d : d) <= KALMAN_CONST(0.125f) + m / 32;
+#else
+        return std::fabs(a - b) <= 1e-3f * std::max(1.0f, std::fabs(b));
+#endif
+    };
+    for (int t = 0; t < frames; ++t) {
+        kalman_real zx[KALMAN_BANK_MAX], zy[KALMAN_BANK_MAX];
+        uint32_t valid = 0;
+        for (int i = 0; i < n; ++i) {
+            // 真值匀速运动，碰边反弹；观测 = 取整真值 ± 2，偶尔整段丢失或出现离群点
+            px[i] += vx[i];
+            py[i] += vy[i];
+            if (px[i] < 5 || px[i] > W - 5) vx[i] = -vx[i];
+            if (py[i] < 5 || py[i] > H - 5) vy[i] = -vy[i];
+            if (drop[i] > 0) {
+                --drop[i];
+            } else if (rng() % 100 < 3) {
+                drop[i] = 2 + (int)(rng() % 8); // 一半以上超过 max_loss
+            } else {
+                int ox = (int)px[i] + (int)(rng() % 5) - 2, oy = (int)py[i] + (int)(rng() % 5) - 2;
+                if (rng() % 100 < 3) ox += 60;   // 离群
+                zx[i] = KALMAN_FROM_INT(ox);
+                zy[i] = KALMAN_FROM_INT(oy);
+                valid |= 1u << i;
+            }
+            if (!(valid & (1u << i))) zx[i] = zy[i] = KALMAN_CONST(0.0f);
+        }
+
+        kalman_bank_predict(&bank, KALMAN_CONST(1.0f));
+        const uint32_t rejected = kalman_bank_update(&bank, zx, zy, valid);
+
+        uint32_t want_rejected = 0;
+        for (int i = 0; i < n; ++i) {
+            if (!active[i]) {
+                if (valid & (1u << i)) {
+                    kalman_init(&ref[i], zx[i], zy[i], q, r);
+                    active[i] = 1;
+                    loss[i] = 0;
+                    ++starts;
+                }
+                continue;
+            }
+            kalman_predict(&ref[i], KALMAN_CONST(1.0f));
+            bool accept = (valid >> i) & 1u;
+            if (accept) {
+                const double ex = kalman_to_double(zx[i]) - kalman_to_double(ref[i].x[0]);
+                const double ey = kalman_to_double(zy[i]) - kalman_to_double(ref[i].x[1]);
+                const double d2 = ex * ex / kalman_to_double(ref[i].P[0][0] + r) +
+                                  ey * ey / kalman_to_double(ref[i].P[1][1] + r);
+                if (d2 > kalman_to_double(gate)) {
+                    accept = false;
+                    want_rejected |= 1u << i;
+                    ++rejects;
+                }
+            }
+            if (accept) {
+                kalman_real z[2] = {zx[i], zy[i]};
+                kalman_update(&ref[i], z);
+                loss[i] = 0;
+            } else if (++loss[i] >= max_loss) {
+                active[i] = 0;
+                loss[i] = 0;
+                ++expiries;
+            }
+        }
+
+        uint32_t want_active = 0;
+        for (int i = 0; i < n; ++i) want_active |= (uint32_t)active[i] << i;
+        bool ok = rejected == want_rejected && bank.active == want_active;
+        for (int i = 0; ok && i < n; ++i) {
+            if (!active[i]) continue;
+            const KalmanFilter &k = ref[i];
+            ok = bank.loss[i] == loss[i] && close(bank.x[i], k.x[0]) && close(bank.y[i], k.x[1]) &&
+                 close(bank.vx[i], k.x[2]) && close(bank.vy[i], k.x[3]) && close(bank.px_pp[i], k.P[0][0]) &&
+                 close(bank.px_pv[i], k.P[0][2]) && close(bank.px_vv[i], k.P[2][2]) &&
+                 close(bank.py_pp[i], k.P[1][1]) && close(bank.py_pv[i], k.P[1][3]) && close(bank.py_vv[i], k.P[3][3]);
+            if (!ok) {
+                std::fprintf(stderr, "自检失败: KalmanBank 第 %d 帧第 %d 路与 KalmanFilter 不一致（x %.4f / %.4f，y %.4f / %.4f）\n",
+                             t, i, kalman_to_double(bank.x[i]), kalman_to_double(k.x[0]), kalman_to_double(bank.y[i]),
+                             kalman_to_double(k.x[1]));
+            }
+        }
+        if (!ok) {
+            if (rejected != want_rejected || bank.active != want_active) {
+                std::fprintf(stderr, "自检失败: KalmanBank 第 %d 帧 门控 %08x / %08x，激活 %08x / %08x\n", t,
+                             rejected, want_rejected, bank.active, want_active);
+            }
+            if (++failures >= 5) break;
+        }
+
+        // 定期主动停用几路（元素切换时的用法）
+        if (t % 97 == 96) {
+            const uint32_t mask = (uint32_t)rng() & (uint32_t)rng();
+            kalman_bank_release(&bank, mask);
+            for (int i = 0; i < n; ++i) {
+                if ((mask >> i) & 1u) {
+                    releases += active[i];
+                    active[i] = 0;
+                    loss[i] = 0;
+                }
+            }
+        }
+    }
+    std::cout << "KalmanBank 自检: " << frames << " 帧 × " << n << " 路（启动 " << starts << "，门控拒绝 " << rejects
+              << "，丢失停用 " << expiries << "，主动停用 " << releases << "），失败 " << failures << " 帧" << std::endl;
+    if (starts == 0 || rejects == 0 || expiries == 0 || releases == 0) {
+        std::fprintf(stderr, "自检失败: KalmanBank 场景没有覆盖全部生命周期分支\n");
+        ++failures;
+    }
+    return failures;
+}
+
+// ---------------- main ----------------
+
+static void print_usage() {
+    std::cerr << "用法: bench_image_internal [--data DIR] [--max-real N] [--synthetic N] [--warmup N] [--reps N]" << std::endl;
+    std::cerr << "                            [--filter S] [--json out.json] [--baseline base.json] [--tolerance 0.10]" << std::endl;
+    std::cerr << "                            [--self-check N]" << std::endl;
+    std::cerr << "  --data       - 真实帧目录，读取其下 */output.mp4（默认 data，需 OpenCV）" << std::endl;
+    std::cerr << "  --max-real   - 每个视频最多取的帧数（默认 300）" << std::endl;
+    std::cerr << "  --synthetic  - 合成帧数（默认 300）" << std::endl;
+    std::cerr << "  --warmup     - 每个基准的预热遍数（默认 3）" << std::endl;
+    std::cerr << "  --reps       - 每个基准的计时遍数（默认 15）" << std::endl;
+    std::cerr << "  --filter     - 只运行名称包含该子串的基准" << std::endl;
+    std::cerr << "  --json       - 结果写入 JSON" << std::endl;
+    std::cerr << "  --baseline   - 与之前的 JSON 对比，中位数变慢超过 tolerance 时退出码为 1" << std::endl;
+    std::cerr << "  --self-check - 只运行 N 例形态学差分自检、N 帧链码往返自检与 10N 帧 KalmanBank 自检（不跑基准），有不一致时退出码为 1" << std::endl;
+}
+
+static bool parse_args(int argc, char **argv, Options &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "参数缺少取值: " << a << std::endl;
+            return false;
+        }
+        try {
+            if (a == "--data") opt.dataDir = argv[++i];
+            else if (a == "--max-real") opt.maxReal = std::stoi(argv[++i]);
+            else if (a == "--synthetic") opt.synthetic = std::stoi(argv[++i]);
+            else if (a == "--warmup") opt.warmup = std::stoi(argv[++i]);
+            else if (a == "--reps") opt.reps = std::stoi(argv[++i]);
+            else if (a == "--filter") opt.filter = argv[++i];
+            else if (a == "--json") opt.json = argv[++i];
+            else if (a == "--baseline") opt.baseline = argv[++i];
+            else if (a == "--tolerance") opt.tolerance = std::stod(argv[++i]);
+            else if (a == "--self-check") opt.selfCheck = std::stoi(argv[++i]);
+            else {
+                std::cerr << "未知参数: " << a << std::endl;
+                return false;
+            }
+        } catch (...) {
+            return false;
+        }
+    }
+    return opt.selfCheck >= 0 && opt.maxReal >= 0 && opt.synthetic >= 0 && opt.warmup >= 0 && opt.reps > 0 && opt.tolerance >= 0;
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage();
+        return 2;
+    }
+    if (opt.selfCheck > 0) {
+        const int failures = run_self_check(opt.selfCheck) + run_chain_check(opt.selfCheck) +
+                             run_kalman_bank_check(opt.selfCheck * 10);
+        return failures ? 1 : 0;
+    }
+
+    std::vector<Frame> corpus;
+    int real = 0;
+#ifdef HAVE_OPENCV
+    real = load_real_frames(opt, corpus);
+#else
+    std::cerr << "提示: 未链接 OpenCV，只使用合成帧" << std::endl;
+#endif
+    for (int k = 0; k < opt.synthetic; ++k) {
+        Frame f;
+        f.gray.resize((size_t)W * H);
+        synth_frame(k, f.gray.data());
+        corpus.push_back(std::move(f));
+    }
+    if (corpus.empty()) {
+        std::cerr << "错误: 语料为空" << std::endl;
+        return 3;
+    }
+    prepare_corpus(corpus);
+    std::cout << "语料: 真实 " << real << " 帧 + 合成 " << opt.synthetic << " 帧，SIMD: " << morph_simd_backend()
+              << "，预热 " << opt.warmup << " 遍，计时 " << opt.reps << " 遍" << std::endl;
+    size_t delta_bytes = 0;
+    for (const Frame &f : corpus) delta_bytes += f.delta.size();
+    std::cout << ".ipf 增量编码: 平均 " << delta_bytes / corpus.size() << " 字节/帧（原样 "
+              << WORDS * sizeof(uint32_t) << "）" << std::endl;
+
+    std::unique_ptr<PipelineContext> ctx(new PipelineContext);
+    pipeline_context_init(ctx.get());
+    ctx->log_enabled = 0;
+    std::vector<uint32_t> bits(WORDS), tmp(WORDS), out(WORDS);
+    std::vector<uint8_t> u8((size_t)W * H);
+    const uint16_t corner1[6] = {4, 3, 2, 1, 1, 1}; // 同 image.c 的 arr.corner1
+    KalmanFilter kf;
+    auto no_reset = [] {};
+    auto kalman_reset = [&] {
+        kalman_init(&kf, KALMAN_FROM_INT(W / 2), KALMAN_FROM_INT(H / 2), KALMAN_CONST(1.0f), KALMAN_CONST(20.0f));
+    };
+
+    std::vector<Result> results;
+    auto want = [&](const char *name) { return opt.filter.empty() || std::strstr(name, opt.filter.c_str()); };
+    auto add = [&](Result r) {
+        std::printf("%-28s %10.1f ns/帧  (min %.1f, max %.1f)\n", r.name.c_str(), r.median_ns, r.min_ns, r.max_ns);
+        results.push_back(std::move(r));
+    };
+
+    if (want("pack_gray_threshold"))
+        add(run_bench("pack_gray_threshold", opt, corpus, no_reset, [&](const Frame &f) {
+            pack_gray_threshold_to_bits(f.gray.data(), W, H, W, BINARY_THRESHOLD, bits.data());
+            return (uint64_t)bits[WORDS / 2];
+        }));
+    if (want("unpack_bits_u8"))
+        add(run_bench("unpack_bits_u8", opt, corpus, no_reset, [&](const Frame &f) {
+            unpack_bits_to_binary_u8(f.packed.data(), W, H, u8.data(), W);
+            return (uint64_t)u8[W * H / 2];
+        }));
+    if (want("erode3x3"))
+        add(run_bench("erode3x3", opt, corpus, no_reset, [&](const Frame &f) {
+            erode3x3_bitpacked(f.packed.data(), out.data(), W, H);
+            return (uint64_t)out[WORDS / 2];
+        }));
+    if (want("dilate3x3"))
+        add(run_bench("dilate3x3", opt, corpus, no_reset, [&](const Frame &f) {
+            dilate3x3_bitpacked(f.packed.data(), out.data(), W, H);
+            return (uint64_t)out[WORDS / 2];
+        }));
+    if (want("open_close"))
+        add(run_bench("open_close", opt, corpus, no_reset, [&](const Frame &f) {
+            open_close_bitpacked(f.packed.data(), tmp.data(), out.data(), W, H);
+            return (uint64_t)out[WORDS / 2];
+        }));
+    if (want("open_close_fused"))
+        add(run_bench("open_close_fused", opt, corpus, no_reset, [&](const Frame &f) {
+            open_close_bitpacked_fused(f.packed.data(), tmp.data(), out.data(), W, H);
+            return (uint64_t)out[WORDS / 2];
+        }));
+    if (want("morph_open_close_batch") || want("open_close_bitsliced")) {
+        // 帧批量位切片：语料按 64 帧一组连续存放，每组最后一帧处计算整组，耗时摊到每帧
+        const size_t lanes = MORPH_BATCH_LANES;
+        const size_t sliced_words = (size_t)W * H;
+        std::vector<uint32_t> all(corpus.size() * WORDS), batch_out(lanes * WORDS);
+        std::vector<uint64_t> ws(morph_batch_workspace_words(W, H));
+        std::vector<uint64_t> sliced(((corpus.size() + lanes - 1) / lanes) * sliced_words), sliced_out(sliced_words);
+        for (size_t i = 0; i < corpus.size(); ++i) std::copy(corpus[i].packed.begin(), corpus[i].packed.end(), all.begin() + i * WORDS);
+        for (size_t b = 0; b < corpus.size(); b += lanes) {
+            morph_batch_pack(all.data() + b * WORDS, (int)std::min(lanes, corpus.size() - b), W, H,
+                             sliced.data() + (b / lanes) * sliced_words);
+        }
+        auto batch_end = [&](const Frame &f, size_t &first) {
+            const size_t i = (size_t)(&f - corpus.data());
+            first = i - i % lanes;
+            return i % lanes == lanes - 1 || i + 1 == corpus.size();
+        };
+        if (want("morph_open_close_batch"))
+            // pack → open_close_bitsliced → unpack（离线回放实际走的路径）
+            add(run_bench("morph_open_close_batch", opt, corpus, no_reset, [&](const Frame &f) {
+                size_t first;
+                if (!batch_end(f, first)) return (uint64_t)0;
+                morph_open_close_batch(all.data() + first * WORDS, batch_out.data(), (int)(&f - corpus.data() - first + 1),
+                                       W, H, ws.data());
+                return (uint64_t)batch_out[WORDS / 2];
+            }));
+        if (want("open_close_bitsliced"))
+            // 只有位切片内核（输入已转置好）
+            add(run_bench("open_close_bitsliced", opt, corpus, no_reset, [&](const Frame &f) {
+                size_t first;
+                if (!batch_end(f, first)) return (uint64_t)0;
+                open_close_bitsliced(sliced.data() + (first / lanes) * sliced_words, sliced_out.data(), W, H,
+                                     ws.data() + 2 * sliced_words);
+                return (uint64_t)sliced_out[sliced_words / 2];
+            }));
+    }
+    if (want("precise_edge_detection"))
+        add(run_bench("precise_edge_detection", opt, corpus, no_reset, [&](const Frame &f) {
+            precise_edge_detection_bitpacked(f.packed.data(), tmp.data(), out.data(), W, H);
+            return (uint64_t)out[WORDS / 2];
+        }));
+    if (want("search_l_r"))
+        add(run_bench("search_l_r", opt, corpus, no_reset, [&](const Frame &f) {
+            // 与 image_process 相同：三行找起点，找到后八邻域
+            PipelineContext *c = ctx.get();
+            c->data_stastics_l = 0;
+            c->data_stastics_r = 0;
+            if (get_start_point_bits(c, f.traced.data(), H - 3) || get_start_point_bits(c, f.traced.data(), H - 5) ||
+                get_start_point_bits(c, f.traced.data(), H - 7)) {
+                search_l_r_bits(c, (uint16_t)USE_num, f.traced.data(), &c->data_stastics_l, &c->data_stastics_r,
+                                c->start_point_l[0], c->start_point_l[1], c->start_point_r[0], c->start_point_r[1],
+                                &c->hightest);
+            }
+            return (uint64_t)c->data_stastics_l + c->data_stastics_r;
+        }));
+    if (want("match_strict_sequence"))
+        add(run_bench("match_strict_sequence", opt, corpus, no_reset, [&](const Frame &f) {
+            match_result a = match_strict_sequence_with_gaps(f.dir_l.data(), f.dir_l.size(), corner1, 6, 4, 0, 1);
+            match_result b = match_strict_sequence_with_gaps(f.dir_r.data(), f.dir_r.size(), corner1, 6, 4, 0, -1);
+            return (uint64_t)a.matched + b.matched + a.end + b.start;
+        }));
+    if (want("calculate_border_variance"))
+        add(run_bench("calculate_border_variance", opt, corpus, no_reset, [&](const Frame &f) {
+            border_variance a = calculate_border_variance(ctx.get(), 0, 60, &f.border.left);
+            border_variance b = calculate_border_variance(ctx.get(), 20, 110, &f.border.right);
+            return (uint64_t)(int64_t)(a + b);
+        }));
+    if (want("kalman_predict_update"))
+        add(run_bench("kalman_predict_update", opt, corpus, kalman_reset, [&](const Frame &f) {
+            kalman_real z[2] = {f.z[0], f.z[1]};
+            kalman_predict(&kf, KALMAN_CONST(1.0f));
+            kalman_update(&kf, z);
+            return (uint64_t)KALMAN_TO_INT(kf.x[0]);
+        }));
+    if (want("kalman_steady"))
+        add(run_bench("kalman_steady", opt, corpus, [&] {
+            kalman_reset();
+            kalman_steady_enable(&kf, KALMAN_CONST(1.0f), 1);
+        }, [&](const Frame &f) {
+            kalman_real z[2] = {f.z[0], f.z[1]};
+            kalman_predict(&kf, KALMAN_CONST(1.0f));
+            kalman_update(&kf, z);
+            return (uint64_t)KALMAN_TO_INT(kf.x[0]);
+        }));
+    {
+        // 32 路同时跟踪：同一观测加逐路偏移；kalman_filter_x32 为 32 个独立 KalmanFilter，对照 KalmanBank 的 SoA 版本
+        const int lanes = KALMAN_BANK_MAX;
+        std::vector<KalmanFilter> kfs(lanes);
+        KalmanBank bank;
+        auto lane_z = [](const Frame &f, int i, kalman_real *zx, kalman_real *zy) {
+            *zx = f.z[0] + KALMAN_FROM_INT(i);
+            *zy = f.z[1] + KALMAN_FROM_INT(i & 7);
+        };
+        if (want("kalman_filter_x32"))
+            add(run_bench("kalman_filter_x32", opt, corpus, [&] {
+                for (int i = 0; i < lanes; ++i)
+                    kalman_init(&kfs[i], KALMAN_FROM_INT(W / 2 + i), KALMAN_FROM_INT(H / 2), KALMAN_CONST(1.0f),
+                                KALMAN_CONST(20.0f));
+            }, [&](const Frame &f) {
+                uint64_t sum = 0;
+                for (int i = 0; i < lanes; ++i) {
+                    kalman_real z[2];
+                    lane_z(f, i, &z[0], &z[1]);
+                    kalman_predict(&kfs[i], KALMAN_CONST(1.0f));
+                    kalman_update(&kfs[i], z);
+                    sum += (uint64_t)KALMAN_TO_INT(kfs[i].x[0]);
+                }
+                return sum;
+            }));
+        if (want("kalman_bank"))
+            add(run_bench("kalman_bank", opt, corpus, [&] {
+                kalman_bank_init(&bank, (uint8_t)lanes, KALMAN_CONST(1.0f), KALMAN_CONST(20.0f), 5, KALMAN_CONST(0.0f));
+            }, [&](const Frame &f) {
+                kalman_real zx[KALMAN_BANK_MAX], zy[KALMAN_BANK_MAX];
+                for (int i = 0; i < lanes; ++i) lane_z(f, i, &zx[i], &zy[i]);
+                kalman_bank_predict(&bank, KALMAN_CONST(1.0f));
+                kalman_bank_update(&bank, zx, zy, 0xFFFFFFFFu);
+                uint64_t sum = 0;
+                for (int i = 0; i < lanes; ++i) sum += (uint64_t)KALMAN_TO_INT(bank.x[i]);
+                return sum;
+            }));
+    }
+    if (want("ipf_delta_encode")) {
+        const uint32_t *prev = nullptr;
+        std::vector<uint8_t> enc(IPF_DELTA_BOUND(WORDS));
+        add(run_bench("ipf_delta_encode", opt, corpus, [&] { prev = nullptr; }, [&](const Frame &f) {
+            size_t n = prev ? ipf_delta_encode(prev, f.packed.data(), WORDS, enc.data()) : 0;
+            prev = f.packed.data();
+            return (uint64_t)n;
+        }));
+    }
+    if (want("ipf_delta_decode"))
+        // 与顺序回放相同：在同一缓冲区原地解码，不变的 word 跳过
+        add(run_bench("ipf_delta_decode", opt, corpus, [&] { std::fill(bits.begin(), bits.end(), 0u); },
+                      [&](const Frame &f) {
+            ipf_delta_decode(f.delta.data(), f.delta.size(), bits.data(), bits.data(), WORDS);
+            return (uint64_t)bits[WORDS / 2];
+        }));
+    if (want("image_process"))
+        add(run_bench("image_process", opt, corpus, [&] {
+            // 每遍从同一初始状态开始（跨帧状态与逐帧顺序相关）
+            pipeline_context_init(ctx.get());
+            ctx->log_enabled = 0;
+        }, [&](const Frame &f) {
+            image_process_packed_ctx(ctx.get(), f.packed.data(), u8.data());
+            return (uint64_t)ctx->left_straight + ctx->cross_flag + ctx->first_corner;
+        }));
+    if (want("image_process_temporal")) {
+        // 同上但开启追踪时域复用；与 image_process 的差即差异膨胀 + 步状态记录的开销减去沿用步数省下的追踪，
+        // 整帧沿用 / 部分沿用的帧数与沿用步数占比一并打印（最后一遍的统计）
+        add(run_bench("image_process_temporal", opt, corpus, [&] {
+            pipeline_context_init(ctx.get());
+            ctx->log_enabled = 0;
+            ctx->temporal_enabled = 1;
+        }, [&](const Frame &f) {
+            image_process_packed_ctx(ctx.get(), f.packed.data(), u8.data());
+            return (uint64_t)ctx->left_straight + ctx->cross_flag + ctx->first_corner;
+        }));
+        const uint32_t tries = ctx->temporal_hits + ctx->temporal_partial + ctx->temporal_misses;
+        const uint32_t steps = ctx->temporal_steps_reused + ctx->temporal_steps_traced;
+        std::printf("%-28s 整帧沿用 %u、部分沿用 %u / %u 帧，沿用步数 %.1f%%\n", "  temporal", ctx->temporal_hits,
+                    ctx->temporal_partial, tries, steps ? 100.0 * ctx->temporal_steps_reused / steps : 0.0);
+    }
+
+    if (!opt.json.empty()) {
+        if (!write_json(opt.json, results, real, opt.synthetic)) {
+            std::cerr << "错误: 无法写入: " << opt.json << std::endl;
+            return 3;
+        }
+        std::cout << "结果: " << opt.json << std::endl;
+    }
+
+    if (!opt.baseline.empty()) {
+        std::map<std::string, double> base;
+        if (!load_baseline(opt.baseline, base)) {
+            std::cerr << "错误: 无法读取基线: " << opt.baseline << std::endl;
+            return 3;
+        }
+        int regressions = 0;
+        std::cout << "与基线对比（容差 " << opt.tolerance * 100 << "%）:" << std::endl;
+        for (const Result &r : results) {
+            auto it = base.find(r.name);
+            if (it == base.end() || it->second <= 0) {
+                std::printf("  %-28s 基线中没有\n", r.name.c_str());
+                continue;
+            }
+            double ratio = r.median_ns / it->second;
+            bool bad = ratio > 1.0 + opt.tolerance;
+            regressions += bad;
+            std::printf("  %-28s %10.1f -> %10.1f ns/帧  %+6.1f%%%s\n", r.name.c_str(), it->second, r.median_ns,
+                        (ratio - 1.0) * 100.0, bad ? "  回归" : "");
+        }
+        if (regressions) {
+            std::cout << regressions << " 项回归" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
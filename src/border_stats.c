@@ -0,0 +1,199 @@
+#include "border_stats.h"
+#include <string.h>
+
+void border_prefix_build(border_prefix* p, const uint8_t* border)
+{
+    uint32_t sy = 0, siy = 0, syy = 0;
+    int i;
+    p->sy[0] = 0;
+    p->siy[0] = 0;
+    p->syy[0] = 0;
+    for (i = 0; i < image_h; i++)
+    {
+        uint32_t y = border[i];
+        sy += y;
+        siy += (uint32_t)i * y;
+        syy += y * y;
+        p->sy[i + 1] = sy;
+        p->siy[i + 1] = siy;
+        p->syy[i + 1] = syy;
+    }
+}
+
+void border_stats_build(BorderStats* bs, const uint8_t* l_border, const uint8_t* r_border, const uint8_t* center_line)
+{
+    if (l_border) border_prefix_build(&bs->left, l_border);
+    if (r_border) border_prefix_build(&bs->right, r_border);
+    if (center_line) border_prefix_build(&bs->center, center_line);
+}
+
+// 区间 [begin,end) 的 n 倍缩放中心化量（见头文件），以及 Σi、Σy
+typedef struct {
+    int64_t n, si, sy, a, b, c;
+} border_moments;
+
+static int border_range(int* begin, int* end)
+{
+    if (*end > image_h) *end = image_h;
+    if (*begin < 0 || *end <= *begin) return 0;
+    return 1;
+}
+
+static border_moments border_prefix_moments(const border_prefix* p, int begin, int end)
+{
+    border_moments m;
+    int64_t n = end - begin;
+    // Σi 与 Σi² 用闭式：Σ_{i<k} i = k(k-1)/2，Σ_{i<k} i² = (k-1)k(2k-1)/6
+    int64_t si = ((int64_t)end * (end - 1) - (int64_t)begin * (begin - 1)) / 2;
+    int64_t sii = ((int64_t)(end - 1) * end * (2 * end - 1) - (int64_t)(begin - 1) * begin * (2 * begin - 1)) / 6;
+    int64_t sy = (int64_t)p->sy[end] - p->sy[begin];
+    int64_t siy = (int64_t)p->siy[end] - p->siy[begin];
+    int64_t syy = (int64_t)p->syy[end] - p->syy[begin];
+    m.n = n;
+    m.si = si;
+    m.sy = sy;
+    m.a = n * sii - si * si;
+    m.b = n * siy - si * sy;
+    m.c = n * syy - sy * sy;
+    return m;
+}
+
+border_fit border_prefix_fit(const border_prefix* p, int begin, int end)
+{
+    border_fit f;
+    border_moments m;
+    memset(&f, 0, sizeof(f));
+    if (!border_range(&begin, &end)) return f;
+    m = border_prefix_moments(p, begin, end);
+    f.ok = 1;
+    f.n = (uint8_t)m.n;
+    if (m.a == 0)
+    {
+        f.degenerate = 1;
+        f.intercept = (float)m.sy;
+        return f;
+    }
+    f.slope = (float)((double)m.b / (double)m.a);
+    f.intercept = (float)(((double)m.sy * m.a - (double)m.b * m.si) / ((double)m.n * m.a));
+    f.variance = (float)((double)(m.a * m.c - m.b * m.b) / ((double)m.a * m.n * m.n));
+    return f;
+}
+
+// num/den 的 Q16.16（den > 0），结果饱和到 int32
+static int32_t border_div_q(int64_t num, int64_t den)
+{
+    int64_t ip = num / den, rem = num % den;
+    int64_t q;
+    if (ip > (INT32_MAX >> BORDER_STATS_Q)) return INT32_MAX;
+    if (ip < (INT32_MIN >> BORDER_STATS_Q)) return INT32_MIN;
+    q = (ip << BORDER_STATS_Q) + (rem << BORDER_STATS_Q) / den;
+    if (q > INT32_MAX) return INT32_MAX;
+    if (q < INT32_MIN) return INT32_MIN;
+    return (int32_t)q;
+}
+
+border_fit_q border_prefix_fit_q(const border_prefix* p, int begin, int end)
+{
+    border_fit_q f;
+    border_moments m;
+    int64_t num, den;
+    memset(&f, 0, sizeof(f));
+    if (!border_range(&begin, &end)) return f;
+    m = border_prefix_moments(p, begin, end);
+    f.ok = 1;
+    f.n = (uint8_t)m.n;
+    if (m.a == 0)
+    {
+        f.degenerate = 1;
+        f.intercept_q = border_div_q(m.sy, 1);
+        return f;
+    }
+    f.slope_q = border_div_q(m.b, m.a);
+    f.intercept_q = border_div_q(m.sy * m.a - m.b * m.si, m.n * m.a);
+    // 方差非负且不超过 255²，整数部分左移 16 位仍在 uint32 内
+    num = m.a * m.c - m.b * m.b;
+    den = m.a * m.n * m.n;
+    f.variance_q = (uint32_t)(((uint64_t)(num / den) << BORDER_STATS_Q) + (uint64_t)(((num % den) << BORDER_STATS_Q) / den));
+    return f;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BORDER_POPCNT64(x) __builtin_popcountll(x)
+#define BORDER_CTZ64(x) __builtin_ctzll(x)
+#define BORDER_CLZ64(x) __builtin_clzll(x)
+#else
+static int border_popcnt64(uint64_t x) { int n = 0; while (x) { x &= x - 1; n++; } return n; }
+static int border_ctz64(uint64_t x) { int n = 0; while (!(x & 1u)) { x >>= 1; n++; } return n; }
+static int border_clz64(uint64_t x) { int n = 0; while (!(x >> 63)) { x <<= 1; n++; } return n; }
+#define BORDER_POPCNT64(x) border_popcnt64(x)
+#define BORDER_CTZ64(x) border_ctz64(x)
+#define BORDER_CLZ64(x) border_clz64(x)
+#endif
+
+// 行 [0,n) 的掩码，n ∈ [0,128]
+static border_lost_mask border_lost_prefix(int n)
+{
+    border_lost_mask r;
+    if (n <= 0) { r.w[0] = 0; r.w[1] = 0; }
+    else if (n < 64) { r.w[0] = (1ull << n) - 1; r.w[1] = 0; }
+    else if (n == 64) { r.w[0] = ~0ull; r.w[1] = 0; }
+    else if (n < 128) { r.w[0] = ~0ull; r.w[1] = (1ull << (n - 64)) - 1; }
+    else { r.w[0] = ~0ull; r.w[1] = ~0ull; }
+    return r;
+}
+
+void border_lost_fill(border_lost_mask* m)
+{
+    *m = border_lost_prefix(image_h);
+}
+
+border_lost_mask border_lost_range(const border_lost_mask* m, int begin, int end)
+{
+    border_lost_mask lo, hi, r;
+    if (end > image_h) end = image_h;
+    lo = border_lost_prefix(begin);
+    hi = border_lost_prefix(end);
+    r.w[0] = m->w[0] & hi.w[0] & ~lo.w[0];
+    r.w[1] = m->w[1] & hi.w[1] & ~lo.w[1];
+    return r;
+}
+
+int border_lost_count(const border_lost_mask* m, int begin, int end)
+{
+    border_lost_mask r;
+    if (end <= begin) return 0;
+    r = border_lost_range(m, begin, end);
+    return BORDER_POPCNT64(r.w[0]) + BORDER_POPCNT64(r.w[1]);
+}
+
+int border_lost_lowest(const border_lost_mask* m)
+{
+    if (m->w[0]) return BORDER_CTZ64(m->w[0]);
+    if (m->w[1]) return 64 + BORDER_CTZ64(m->w[1]);
+    return -1;
+}
+
+int border_lost_highest(const border_lost_mask* m)
+{
+    if (m->w[1]) return 127 - BORDER_CLZ64(m->w[1]);
+    if (m->w[0]) return 63 - BORDER_CLZ64(m->w[0]);
+    return -1;
+}
+
+border_lost_mask border_lost_segment_bottoms(const border_lost_mask* m)
+{
+    // (m << 1) 的 bit r = 第 r-1 行；第 -1 行移入 0
+    border_lost_mask r;
+    r.w[0] = m->w[0] & ~(m->w[0] << 1);
+    r.w[1] = m->w[1] & ~((m->w[1] << 1) | (m->w[0] >> 63));
+    return r;
+}
+
+border_lost_mask border_lost_segment_tops(const border_lost_mask* m)
+{
+    // (m >> 1) 的 bit r = 第 r+1 行；第 image_h 行本身就是 0
+    border_lost_mask r;
+    r.w[0] = m->w[0] & ~((m->w[0] >> 1) | (m->w[1] << 63));
+    r.w[1] = m->w[1] & ~(m->w[1] >> 1);
+    return r;
+}
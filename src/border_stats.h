@@ -0,0 +1,111 @@
+#ifndef BORDER_STATS_H
+#define BORDER_STATS_H
+
+/*
+  边线区间拟合统计（前缀和，O(1) 查询）
+
+  设计说明：
+  - 每帧由 l_border / r_border / center_line 各建一次前缀和：Σy、Σi·y、Σy²（i 为行下标，y 为边线列值），
+    Σi、Σi² 用闭式计算。全部为整数：188×120 下 Σi·y ≤ 120·119·255、Σy² ≤ 120·255²，uint32 足够；
+    查询时的交叉项用 int64，不会溢出。
+  - 任意 [begin,end) 的最小二乘直线 y = slope·i + intercept 与残差方差（残差平方和 / 点数）都由
+    n 倍缩放的中心化量直接给出，不需要第二遍残差循环：
+      A = nΣi² - (Σi)²，B = nΣiy - ΣiΣy，C = nΣy² - (Σy)²
+      slope = B/A，intercept = (Σy - slope·Σi)/n，variance = (A·C - B²)/(A·n²)
+    分子 A·C - B² 在 int64 内精确求出，浮点版只在最后做一次除法。
+  - 定点版（嵌入式，无 FPU）：slope、intercept 为 Q16.16（int32，超出范围饱和），variance 为 Q16.16（uint32）。
+  - 只有一个点（A = 0）时 degenerate = 1，方差为 0，斜率由调用者决定（calculate_border_variance 沿用上次斜率）。
+  - 丢线掩码 border_lost_mask：每边 120 行各占 1 位（bit r = 第 r 行丢线，行号从下往上数），
+    由八邻域追踪在产出点的同时清位；丢线计数、区间内丢线行数、上/下/中段丢线边界都只需
+    popcount/ctz/clz 几条位运算，不再逐字节扫描。
+*/
+
+#include <stdint.h>
+#include "image.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BORDER_STATS_Q 16
+
+/* 兼容 C89/C99 的 inline 定义 */
+#if (defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L)) || defined(__cplusplus)
+  #define BORDER_INLINE static inline
+#else
+  #define BORDER_INLINE static
+#endif
+
+typedef struct {
+    uint64_t w[2]; // bit r（r < image_h）：第 r 行丢线；其余位恒为 0
+} border_lost_mask;
+
+typedef struct {
+    uint32_t sy[image_h + 1];  // sy[k]  = Σ_{i<k} y[i]
+    uint32_t siy[image_h + 1]; // siy[k] = Σ_{i<k} i·y[i]
+    uint32_t syy[image_h + 1]; // syy[k] = Σ_{i<k} y[i]²
+} border_prefix;
+
+typedef struct {
+    border_prefix left;
+    border_prefix right;
+    border_prefix center;
+} BorderStats;
+
+typedef struct {
+    uint8_t ok;          // 0：区间为空或越界
+    uint8_t degenerate;  // 1：只有一个点，slope 无定义（为 0）
+    uint8_t n;           // 点数
+    float slope;
+    float intercept;
+    float variance;      // 残差平方和 / n
+} border_fit;
+
+typedef struct {
+    uint8_t ok;
+    uint8_t degenerate;
+    uint8_t n;
+    int32_t slope_q;     // Q16.16
+    int32_t intercept_q; // Q16.16
+    uint32_t variance_q; // Q16.16
+} border_fit_q;
+
+// 由一条边线（image_h 个值）建立前缀和
+void border_prefix_build(border_prefix* p, const uint8_t* border);
+
+// 左、右、中线一起建立（任一指针为 NULL 时跳过对应项）
+void border_stats_build(BorderStats* bs, const uint8_t* l_border, const uint8_t* r_border, const uint8_t* center_line);
+
+// [begin,end) 的直线拟合与残差方差（end 超过 image_h 时截到 image_h）
+border_fit border_prefix_fit(const border_prefix* p, int begin, int end);
+
+// 定点版，全部整数运算
+border_fit_q border_prefix_fit_q(const border_prefix* p, int begin, int end);
+
+// 全部行置为丢线
+void border_lost_fill(border_lost_mask* m);
+
+BORDER_INLINE void border_lost_clear(border_lost_mask* m, int row) { m->w[row >> 6] &= ~(1ull << (row & 63)); }
+BORDER_INLINE int border_lost_test(const border_lost_mask* m, int row) { return (int)((m->w[row >> 6] >> (row & 63)) & 1u); }
+
+// [begin,end) 内的丢线行数（end 超过 image_h 时截到 image_h）
+int border_lost_count(const border_lost_mask* m, int begin, int end);
+
+// 最低 / 最高的置位行号，空掩码返回 -1
+int border_lost_lowest(const border_lost_mask* m);
+int border_lost_highest(const border_lost_mask* m);
+
+// 丢线段边界（图像之外的第 -1 行与第 image_h 行按“不丢线”处理）：
+//   segment_bottoms：本行丢线且下一行（row-1）不丢线，即每段丢线的最下一行；
+//   segment_tops：   本行丢线且上一行（row+1）不丢线，即每段丢线的最上一行。
+border_lost_mask border_lost_segment_bottoms(const border_lost_mask* m);
+border_lost_mask border_lost_segment_tops(const border_lost_mask* m);
+
+// 只保留 [begin,end) 内的位
+border_lost_mask border_lost_range(const border_lost_mask* m, int begin, int end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BORDER_STATS_H
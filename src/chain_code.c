@@ -0,0 +1,399 @@
+#include "chain_code.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Freeman 码 → 偏移（y 向下）
+static const int8_t s_chain_dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int8_t s_chain_dy[8] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+// (dy+1)*3 + (dx+1) → Freeman 码，0xFF 为原地
+static const uint8_t s_chain_code[9] = { 3, 2, 1, 4, 0xFF, 0, 5, 6, 7 };
+
+static uint8_t chain_get3(const uint8_t* p, uint16_t i)
+{
+    uint32_t bit = (uint32_t)i * 3;
+    uint32_t v = (uint32_t)p[bit >> 3] | ((uint32_t)p[(bit >> 3) + 1] << 8);
+    return (uint8_t)((v >> (bit & 7)) & 7u);
+}
+
+static void chain_set3(uint8_t* p, uint16_t i, uint8_t code)
+{
+    uint32_t bit = (uint32_t)i * 3;
+    uint32_t sh = bit & 7;
+    uint32_t v = (uint32_t)p[bit >> 3] | ((uint32_t)p[(bit >> 3) + 1] << 8);
+    v = (v & ~(7u << sh)) | ((uint32_t)(code & 7u) << sh);
+    p[bit >> 3] = (uint8_t)v;
+    p[(bit >> 3) + 1] = (uint8_t)(v >> 8);
+}
+
+// 实际移动过的最后一个点的下标（其后都是原地点）
+static uint16_t chain_last_moved(const chain_code* c)
+{
+    return (uint16_t)(c->count - 1 - c->tail);
+}
+
+void chain_reset(chain_code* c)
+{
+    c->count = 0;
+    c->tail = 0;
+    c->ok = 1;
+}
+
+void chain_push(chain_code* c, uint8_t x, uint8_t y, uint8_t dir)
+{
+    if (c->count >= CHAIN_MAX_POINTS) return;
+    if (c->count == 0)
+    {
+        c->start[0] = x;
+        c->start[1] = y;
+        c->checkpoints[0][0] = x;
+        c->checkpoints[0][1] = y;
+    }
+    else
+    {
+        int dx = (int)x - c->last[0];
+        int dy = (int)y - c->last[1];
+        if (dx == 0 && dy == 0)
+        {
+            c->tail++;
+        }
+        else if (c->tail || dx < -1 || dx > 1 || dy < -1 || dy > 1)
+        {
+            c->ok = 0;
+        }
+        else
+        {
+            uint16_t i = c->count; // 新点下标，移动码下标为 i-1
+            chain_set3(c->moves, (uint16_t)(i - 1), s_chain_code[(dy + 1) * 3 + (dx + 1)]);
+            if (i % CHAIN_CHECKPOINT == 0)
+            {
+                c->checkpoints[i / CHAIN_CHECKPOINT][0] = x;
+                c->checkpoints[i / CHAIN_CHECKPOINT][1] = y;
+            }
+        }
+    }
+    c->last[0] = x;
+    c->last[1] = y;
+    chain_set3(c->dirs, c->count, dir);
+    c->count++;
+}
+
+void chain_encode(chain_code* c, const uint16_t (*points)[2], const uint16_t* dirs, uint16_t count)
+{
+    uint16_t i;
+    chain_reset(c);
+    for (i = 0; i < count; i++)
+    {
+        chain_push(c, (uint8_t)points[i][0], (uint8_t)points[i][1], (uint8_t)dirs[i]);
+    }
+}
+
+uint8_t chain_move(const chain_code* c, uint16_t i)
+{
+    return chain_get3(c->moves, i);
+}
+
+uint8_t chain_dir(const chain_code* c, uint16_t i)
+{
+    return chain_get3(c->dirs, i);
+}
+
+int chain_point(const chain_code* c, uint16_t i, uint8_t* x, uint8_t* y)
+{
+    uint16_t k, target;
+    int px, py;
+    if (!c->ok || i >= c->count) return -1;
+    target = i;
+    if (target > chain_last_moved(c)) target = chain_last_moved(c);
+    k = (uint16_t)(target / CHAIN_CHECKPOINT * CHAIN_CHECKPOINT);
+    px = c->checkpoints[k / CHAIN_CHECKPOINT][0];
+    py = c->checkpoints[k / CHAIN_CHECKPOINT][1];
+    for (; k < target; k++)
+    {
+        uint8_t m = chain_get3(c->moves, k);
+        px += s_chain_dx[m];
+        py += s_chain_dy[m];
+    }
+    *x = (uint8_t)px;
+    *y = (uint8_t)py;
+    return 0;
+}
+
+int chain_decode(const chain_code* c, uint16_t (*points)[2], uint16_t* dirs)
+{
+    chain_iter it;
+    uint16_t i;
+    if (dirs)
+    {
+        for (i = 0; i < c->count; i++) dirs[i] = chain_get3(c->dirs, i);
+    }
+    if (!points || c->count == 0) return c->ok ? 0 : -1;
+    if (chain_iter_at(&it, c, 0) < 0) return -1;
+    do
+    {
+        points[it.i][0] = it.x;
+        points[it.i][1] = it.y;
+    } while (chain_iter_next(&it));
+    return 0;
+}
+
+int chain_iter_at(chain_iter* it, const chain_code* c, uint16_t i)
+{
+    it->c = c;
+    if (chain_point(c, i, &it->x, &it->y) < 0) return -1;
+    it->i = i;
+    return 0;
+}
+
+int chain_iter_next(chain_iter* it)
+{
+    const chain_code* c = it->c;
+    if (it->i + 1 >= c->count) return 0;
+    if (it->i < chain_last_moved(c))
+    {
+        uint8_t m = chain_get3(c->moves, it->i);
+        it->x = (uint8_t)(it->x + s_chain_dx[m]);
+        it->y = (uint8_t)(it->y + s_chain_dy[m]);
+    }
+    it->i++;
+    return 1;
+}
+
+int chain_iter_prev(chain_iter* it)
+{
+    const chain_code* c = it->c;
+    if (it->i == 0) return 0;
+    it->i--;
+    if (it->i < chain_last_moved(c))
+    {
+        uint8_t m = chain_get3(c->moves, it->i);
+        it->x = (uint8_t)(it->x - s_chain_dx[m]);
+        it->y = (uint8_t)(it->y - s_chain_dy[m]);
+    }
+    return 1;
+}
+
+uint8_t chain_iter_dir(const chain_iter* it)
+{
+    return chain_get3(it->c->dirs, it->i);
+}
+
+int chain_rle(const chain_code* c, chain_stream s, chain_run* runs, int max_runs)
+{
+    const uint8_t* p = (s == CHAIN_MOVES) ? c->moves : c->dirs;
+    uint16_t n = (s == CHAIN_MOVES) ? (c->count ? chain_last_moved(c) : 0) : c->count;
+    uint16_t i;
+    int r = 0;
+    for (i = 0; i < n; i++)
+    {
+        uint8_t v = chain_get3(p, i);
+        if (r > 0 && runs[r - 1].code == v)
+        {
+            runs[r - 1].len++;
+            continue;
+        }
+        if (r >= max_runs) return -1;
+        runs[r].code = v;
+        runs[r].len = 1;
+        r++;
+    }
+    return r;
+}
+
+// 把一条链的游程追加到 buf[*pos]，空间不足返回 -1
+static int chain_format_runs(const chain_code* c, chain_stream s, char* buf, size_t cap, size_t* pos)
+{
+    chain_run runs[CHAIN_MAX_POINTS];
+    int n = chain_rle(c, s, runs, CHAIN_MAX_POINTS);
+    int k, w;
+    for (k = 0; k < n; k++)
+    {
+        const char* sep = k ? " " : "";
+        if (runs[k].len > 1)
+            w = snprintf(buf + *pos, cap - *pos, "%s%ux%u", sep, (unsigned)runs[k].code, (unsigned)runs[k].len);
+        else
+            w = snprintf(buf + *pos, cap - *pos, "%s%u", sep, (unsigned)runs[k].code);
+        if (w < 0 || (size_t)w >= cap - *pos) return -1;
+        *pos += (size_t)w;
+    }
+    return 0;
+}
+
+int chain_format(const chain_code* c, char* buf, size_t cap)
+{
+    size_t pos = 0;
+    int w;
+    if (!buf || cap == 0) return -1;
+    buf[0] = '\0';
+    if (c->count == 0)
+    {
+        w = snprintf(buf, cap, "n0");
+        return (w < 0 || (size_t)w >= cap) ? -1 : w;
+    }
+    // 坐标不可用时只记生长方向
+    w = snprintf(buf, cap, "%u,%u n%u%s", (unsigned)c->start[0], (unsigned)c->start[1], (unsigned)c->count,
+                 c->ok ? " m:" : " bad");
+    if (w < 0 || (size_t)w >= cap) return -1;
+    pos = (size_t)w;
+    if (c->ok && chain_format_runs(c, CHAIN_MOVES, buf, cap, &pos) < 0) return -1;
+    if (c->ok && c->tail)
+    {
+        w = snprintf(buf + pos, cap - pos, " s%u", (unsigned)c->tail);
+        if (w < 0 || (size_t)w >= cap - pos) return -1;
+        pos += (size_t)w;
+    }
+    w = snprintf(buf + pos, cap - pos, " d:");
+    if (w < 0 || (size_t)w >= cap - pos) return -1;
+    pos += (size_t)w;
+    if (chain_format_runs(c, CHAIN_DIRS, buf, cap, &pos) < 0) return -1;
+    return (int)pos;
+}
+
+size_t chain_serialize(const chain_code* c, uint8_t* buf, size_t cap)
+{
+    size_t mb = c->count ? ((size_t)chain_last_moved(c) * 3 + 7) / 8 : 0;
+    size_t db = ((size_t)c->count * 3 + 7) / 8;
+    size_t need = 5 + mb + db;
+    if (!c->ok || need > cap) return 0;
+    buf[0] = c->start[0];
+    buf[1] = c->start[1];
+    buf[2] = (uint8_t)(c->count & 0xFF);
+    buf[3] = (uint8_t)(c->count >> 8);
+    buf[4] = c->tail;
+    memcpy(buf + 5, c->moves, mb);
+    memcpy(buf + 5 + mb, c->dirs, db);
+    return need;
+}
+
+// 由起点与移动码重建检查点与末点（ok = 1 的链）
+static void chain_rebuild(chain_code* c)
+{
+    uint16_t moved = chain_last_moved(c), i;
+    int px = c->start[0], py = c->start[1];
+    c->checkpoints[0][0] = (uint8_t)px;
+    c->checkpoints[0][1] = (uint8_t)py;
+    for (i = 0; i < moved; i++)
+    {
+        uint8_t m = chain_get3(c->moves, i);
+        px += s_chain_dx[m];
+        py += s_chain_dy[m];
+        if ((i + 1) % CHAIN_CHECKPOINT == 0)
+        {
+            c->checkpoints[(i + 1) / CHAIN_CHECKPOINT][0] = (uint8_t)px;
+            c->checkpoints[(i + 1) / CHAIN_CHECKPOINT][1] = (uint8_t)py;
+        }
+    }
+    c->last[0] = (uint8_t)px;
+    c->last[1] = (uint8_t)py;
+}
+
+int chain_deserialize(chain_code* c, const uint8_t* buf, size_t len)
+{
+    uint16_t count;
+    uint8_t tail;
+    size_t mb, db;
+    if (len < 5) return -1;
+    count = (uint16_t)(buf[2] | (buf[3] << 8));
+    tail = buf[4];
+    if (count > CHAIN_MAX_POINTS || (count && tail >= count) || (!count && tail)) return -1;
+    mb = count ? ((size_t)(count - 1 - tail) * 3 + 7) / 8 : 0;
+    db = ((size_t)count * 3 + 7) / 8;
+    if (len < 5 + mb + db) return -1;
+
+    memset(c, 0, sizeof(*c));
+    c->ok = 1;
+    c->start[0] = buf[0];
+    c->start[1] = buf[1];
+    c->count = count;
+    c->tail = tail;
+    memcpy(c->moves, buf + 5, mb);
+    memcpy(c->dirs, buf + 5 + mb, db);
+    // 只保留有效位，随后按移动码重建检查点与末点
+    if (count)
+    {
+        uint16_t moved = (uint16_t)(count - 1 - tail);
+        if (moved % 8) c->moves[moved * 3 / 8] &= (uint8_t)((1u << (moved * 3 % 8)) - 1);
+        if (count % 8) c->dirs[count * 3 / 8] &= (uint8_t)((1u << (count * 3 % 8)) - 1);
+        chain_rebuild(c);
+    }
+    return 0;
+}
+
+// 解析一串游程 "2x40 1 2x3"，依次写入 p 的第 *n 个码起；码超过 7、长度为 0 或总数超过 CHAIN_MAX_POINTS 返回 -1
+static int chain_parse_runs(const char** text, uint8_t* p, uint16_t* n)
+{
+    const char* s = *text;
+    while (*s >= '0' && *s <= '7')
+    {
+        char* end;
+        unsigned long code = strtoul(s, &end, 10), len = 1;
+        if (code > 7) return -1;
+        s = end;
+        if (*s == 'x')
+        {
+            if (s[1] < '0' || s[1] > '9') return -1;
+            len = strtoul(s + 1, &end, 10);
+            s = end;
+        }
+        if (len == 0 || len > (unsigned long)(CHAIN_MAX_POINTS - *n)) return -1;
+        while (len--) chain_set3(p, (*n)++, (uint8_t)code);
+        if (*s != ' ' || s[1] < '0' || s[1] > '9') break;
+        s++;
+    }
+    *text = s;
+    return 0;
+}
+
+int chain_parse(chain_code* c, const char* text)
+{
+    const char* s = text;
+    char* end;
+    unsigned long x, y, count, tail = 0;
+    uint16_t moved = 0, dirs = 0;
+    memset(c, 0, sizeof(*c));
+    c->ok = 1;
+    if (strcmp(s, "n0") == 0) return 0;
+
+    if (*s < '0' || *s > '9') return -1;
+    x = strtoul(s, &end, 10);
+    if (*end != ',' || end[1] < '0' || end[1] > '9') return -1;
+    s = end + 1;
+    y = strtoul(s, &end, 10);
+    if (strncmp(end, " n", 2) != 0 || end[2] < '0' || end[2] > '9') return -1;
+    s = end + 2;
+    count = strtoul(s, &end, 10);
+    s = end;
+    if (x > 255 || y > 255 || count == 0 || count > CHAIN_MAX_POINTS) return -1;
+    c->start[0] = (uint8_t)x;
+    c->start[1] = (uint8_t)y;
+    c->count = (uint16_t)count;
+
+    if (strncmp(s, " bad", 4) == 0)
+    {
+        c->ok = 0; // 只有生长方向
+        s += 4;
+    }
+    else if (strncmp(s, " m:", 3) == 0)
+    {
+        s += 3;
+        if (chain_parse_runs(&s, c->moves, &moved) < 0) return -1;
+        if (strncmp(s, " s", 2) == 0)
+        {
+            if (s[2] < '0' || s[2] > '9') return -1;
+            tail = strtoul(s + 2, &end, 10);
+            s = end;
+        }
+        if (tail > 255 || moved + 1 + tail != count) return -1;
+        c->tail = (uint8_t)tail;
+    }
+    else
+    {
+        return -1;
+    }
+
+    if (strncmp(s, " d:", 3) != 0) return -1;
+    s += 3;
+    if (chain_parse_runs(&s, c->dirs, &dirs) < 0 || dirs != count || *s != '\0') return -1;
+    if (c->ok) chain_rebuild(c);
+    return 0;
+}
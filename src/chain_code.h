@@ -0,0 +1,110 @@
+#ifndef CHAIN_CODE_H
+#define CHAIN_CODE_H
+
+/*
+  八邻域边线的 Freeman 链码表示（紧凑存储 / 日志 / 遥测）
+
+  设计说明：
+  - 一条边线 = 起点坐标 + 每步 3 位的 Freeman 移动码 + 每点 3 位的生长方向记录值（dir_l/dir_r 的值）。
+    生长方向记录值带 +1 偏移约定（见 search_l_r），并不等于实际移动方向，元素识别用的正是记录值，
+    所以两条 3 位链都要保存，才能无损还原 points + dir。
+    每边 USE_num 个点：points + dir 原来 360×6 = 2160 字节，这里约 330 字节。
+  - Freeman 码（图像坐标，y 向下）：0 右、1 右上、2 上、3 左上、4 左、5 左下、6 下、7 右下。
+  - 追踪停住时末尾会有原地不动的点（邻域内无跳变），用 tail 计数表示；
+    除此之外相邻两点必须是 8 邻域一步，否则 ok = 0（链码仍保存点数与生长方向，但坐标不可用）。
+  - 随机访问：每 CHAIN_CHECKPOINT 个点存一个检查点坐标，取第 i 点最多走 CHAIN_CHECKPOINT-1 步。
+  - 迭代器 chain_iter 支持正反向逐点遍历，供序列匹配与元素检测使用。
+  - 游程形式 chain_rle 与文本形式 chain_format / chain_parse（userlog 写日志、replay_check 读回），
+    二进制形式 chain_serialize（遥测下发）。
+  - 追踪热路径只写 points_l/dir_l（元素检测在紧循环里随机访问这两个数组），不逐点维护链码；
+    需要紧凑形式（日志 / 存盘 / 遥测）时用 chain_encode 由数组整体编码一次（userlog 每帧各边一次）。
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "image.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHAIN_MAX_POINTS     USE_num
+#define CHAIN_CHECKPOINT     16
+#define CHAIN_PACKED_BYTES   (((CHAIN_MAX_POINTS) * 3 + 7) / 8 + 1) // 多 1 字节，跨字节读取不越界
+#define CHAIN_TEXT_MAX       (32 + 4 * (CHAIN_MAX_POINTS))           // chain_format 最坏长度（含结尾 0）
+#define CHAIN_SERIAL_MAX     (8 + 2 * CHAIN_PACKED_BYTES)            // chain_serialize 最坏长度
+
+typedef enum {
+    CHAIN_MOVES = 0, // Freeman 移动码（count-1-tail 个）
+    CHAIN_DIRS  = 1  // 生长方向记录值（count 个）
+} chain_stream;
+
+typedef struct {
+    uint8_t start[2];   // 起点 [x, y]
+    uint8_t last[2];    // 最后一个点 [x, y]
+    uint16_t count;     // 点数
+    uint8_t tail;       // 末尾原地不动的点数
+    uint8_t ok;         // 0：出现非 8 邻域的跳步（或原地点之后又移动），坐标不可用
+    uint8_t moves[CHAIN_PACKED_BYTES];
+    uint8_t dirs[CHAIN_PACKED_BYTES];
+    uint8_t checkpoints[CHAIN_MAX_POINTS / CHAIN_CHECKPOINT + 1][2]; // 第 k*CHAIN_CHECKPOINT 点的坐标
+} chain_code;
+
+typedef struct {
+    const chain_code* c;
+    uint16_t i;         // 当前点下标
+    uint8_t x, y;       // 当前点坐标
+} chain_iter;
+
+typedef struct {
+    uint8_t code;
+    uint16_t len;
+} chain_run;
+
+// 清空
+void chain_reset(chain_code* c);
+
+// 追加一个点及其生长方向记录值（超过 CHAIN_MAX_POINTS 的点被忽略）
+void chain_push(chain_code* c, uint8_t x, uint8_t y, uint8_t dir);
+
+// 由点集与生长方向数组整体编码
+void chain_encode(chain_code* c, const uint16_t (*points)[2], const uint16_t* dirs, uint16_t count);
+
+// 还原成点集与生长方向数组（各 count 个，任一指针可为 NULL）；ok = 0 时返回 -1
+int chain_decode(const chain_code* c, uint16_t (*points)[2], uint16_t* dirs);
+
+// 第 i 个移动码 / 生长方向记录值
+uint8_t chain_move(const chain_code* c, uint16_t i);
+uint8_t chain_dir(const chain_code* c, uint16_t i);
+
+// 第 i 点坐标（检查点 + 不超过 CHAIN_CHECKPOINT-1 步）；越界或 ok = 0 返回 -1
+int chain_point(const chain_code* c, uint16_t i, uint8_t* x, uint8_t* y);
+
+// 迭代器：定位到点 i，越界返回 -1
+int chain_iter_at(chain_iter* it, const chain_code* c, uint16_t i);
+// 前进 / 后退一点，越过两端返回 0（迭代器不动）
+int chain_iter_next(chain_iter* it);
+int chain_iter_prev(chain_iter* it);
+// 当前点的生长方向记录值
+uint8_t chain_iter_dir(const chain_iter* it);
+
+// 游程编码：返回游程数；runs 放不下时返回 -1
+int chain_rle(const chain_code* c, chain_stream s, chain_run* runs, int max_runs);
+
+// 文本形式，例："35,117 n120 m:2x40 1 2x3 s2 d:3x41 4 3x3"
+// （m 为移动码游程，s 为末尾原地点数，d 为生长方向游程；游程长 1 时省略 xN；ok = 0 时为 "x,y nN bad d:..."）
+// 返回写入长度（不含结尾 0），cap 不足时返回 -1
+int chain_format(const chain_code* c, char* buf, size_t cap);
+// chain_format 的逆：解析文本并重建检查点（日志回放用）；格式不符或点数对不上返回 -1
+int chain_parse(chain_code* c, const char* text);
+
+// 二进制形式：x y count(2 字节小端) tail 移动码 生长方向（都按 3 位打包，只写有效字节）
+size_t chain_serialize(const chain_code* c, uint8_t* buf, size_t cap);
+// 反序列化并重建检查点；数据不完整返回 -1
+int chain_deserialize(chain_code* c, const uint8_t* buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHAIN_CODE_H
@@ -124,6 +124,7 @@ void DynamicLogManager::addVariable(const std::string& var_name, LogVarType type
     var.array_count = 0;  // 非数组
     
     // 检查该帧是否已有同名变量，如果有则更新，否则添加
+    std::lock_guard<std::mutex> lock(mutex);
     auto& frame_vars = frame_logs[frame_index];
     bool found = false;
     for (auto& existing_var : frame_vars) {
@@ -157,6 +158,7 @@ void DynamicLogManager::addArray(const std::string& var_name, LogVarType array_t
     var.array_count = count;
     
     // 检查该帧是否已有同名变量，如果有则更新，否则添加
+    std::lock_guard<std::mutex> lock(mutex);
     auto& frame_vars = frame_logs[frame_index];
     bool found = false;
     for (auto& existing_var : frame_vars) {
@@ -177,6 +179,7 @@ void DynamicLogManager::addArray(const std::string& var_name, LogVarType array_t
 }
 
 std::vector<DynamicLogVariable> DynamicLogManager::getFrameLogs(int frame_index) const {
+    std::lock_guard<std::mutex> lock(mutex);
     auto it = frame_logs.find(frame_index);
     if (it != frame_logs.end()) {
         return it->second;
@@ -185,15 +188,18 @@ std::vector<DynamicLogVariable> DynamicLogManager::getFrameLogs(int frame_index)
 }
 
 void DynamicLogManager::clearAll() {
+    std::lock_guard<std::mutex> lock(mutex);
     frame_logs.clear();
 }
 
 void DynamicLogManager::clearFrame(int frame_index) {
+    std::lock_guard<std::mutex> lock(mutex);
     frame_logs.erase(frame_index);
 }
 
 std::vector<int> DynamicLogManager::getFrameIndices() const {
     std::vector<int> indices;
+    std::lock_guard<std::mutex> lock(mutex);
     for (const auto& pair : frame_logs) {
         indices.push_back(pair.first);
     }
@@ -211,6 +217,7 @@ void DynamicLogManager::setCsvPath(const std::string& path) {
 std::vector<std::string> DynamicLogManager::getAllVariableNames() const {
     std::vector<std::string> names;
     std::set<std::string> name_set;
+    std::lock_guard<std::mutex> lock(mutex);
     
     // 收集所有出现过的变量名（保持插入顺序）
     for (const auto& frame_pair : frame_logs) {
@@ -338,6 +345,7 @@ void DynamicLogManager::flushToCsv() {
     }
     
     // 4. 为每一行数据填充新列的值
+    std::unique_lock<std::mutex> lock(mutex);
     for (size_t row_idx = 0; row_idx < existing_data.size(); row_idx++) {
         auto& row = existing_data[row_idx];
         
@@ -377,6 +385,8 @@ void DynamicLogManager::flushToCsv() {
         }
     }
     
+    lock.unlock();
+    
     // 5. 写回CSV文件
 #ifdef _WIN32
     fp = _wfopen(wpath.c_str(), L"wb");
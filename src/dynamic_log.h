@@ -91,6 +91,7 @@ void log_flush_to_csv();
 #include <string>
 #include <map>
 #include <vector>
+#include <mutex>
 
 // 单条日志变量记录
 struct DynamicLogVariable {
@@ -154,7 +155,9 @@ private:
     std::string escapeCSV(const std::string& str);
     
     // 存储结构: frame_index -> vector of variables
+    // frame_logs 由 mutex 保护：多个 PipelineContext 可在不同线程上同时写日志
     std::map<int, std::vector<DynamicLogVariable>> frame_logs;
+    mutable std::mutex mutex;
     int current_frame;
     std::string csv_path;
     bool auto_save_enabled;
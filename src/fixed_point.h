@@ -0,0 +1,51 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+/*
+  数值 profile：默认浮点；定义 IMAGEPROC_FIXED_POINT（CMake 选项 -DIMAGEPROC_FIXED_POINT=ON）时
+  边线拟合方差、序列匹配置信度与卡尔曼滤波全部改用 Q 格式整数，管线里不再出现 float 运算，
+  可以跑在没有 FPU 的 MCU 上。
+
+  - 方差：Q16.16（int32），由 border_prefix_fit_q 精确整数求得，阈值比较同样在 Q16 下进行。
+  - 置信度：Q15（uint16，32768 = 1.0）。
+  - 卡尔曼：Q19.12（int32，见 kalman.h 的 KALMAN_Q），乘加在 int64 中累加后舍入、饱和。
+  两个 profile 的决策差异用 profile_check 工具逐帧对比（见 README）。
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef IMAGEPROC_FIXED_POINT
+
+typedef int32_t border_variance;                          // Q16.16
+#define BORDER_VARIANCE_FROM_INT(v) ((border_variance)(v) * 65536)
+typedef int32_t border_slope;                             // Q16.16
+
+typedef uint16_t match_confidence;                        // Q15
+#define MATCH_CONFIDENCE_ONE  ((match_confidence)32768u)
+#define MATCH_CONFIDENCE_ZERO ((match_confidence)0u)
+// 1 - gap/max（max > 0）
+#define MATCH_CONFIDENCE_FROM_GAP(gap, max) \
+    ((match_confidence)(32768u - ((uint32_t)(gap) * 32768u) / (uint32_t)(max)))
+
+#else
+
+typedef float border_variance;
+#define BORDER_VARIANCE_FROM_INT(v) ((float)(v))
+typedef float border_slope;
+
+typedef float match_confidence;
+#define MATCH_CONFIDENCE_ONE  1.0f
+#define MATCH_CONFIDENCE_ZERO 0.0f
+#define MATCH_CONFIDENCE_FROM_GAP(gap, max) (1.0f - (float)(gap) / (float)(max))
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_H
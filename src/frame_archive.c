@@ -0,0 +1,475 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L // mmap / fstat（C11 严格模式下默认不可见）
+#endif
+
+#include "frame_archive.h"
+#include "morph_binary_bitpacked.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(IPF_NO_MMAP)
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// ---- 小端读写 ----
+static void put_u16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_u32(uint8_t* p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static void put_u64(uint8_t* p, uint64_t v) { put_u32(p, (uint32_t)v); put_u32(p + 4, (uint32_t)(v >> 32)); }
+static uint16_t get_u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t* p) { return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+static uint64_t get_u64(const uint8_t* p) { return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32); }
+
+/*
+  文件头（64 字节）：
+    0  magic[4]      "IPF1"
+    4  u16 version
+    6  u16 format    ipf_format
+    8  u16 width
+    10 u16 height
+    12 u32 frame_bytes
+    16 u32 frame_count
+    20 u32 keyframe_interval（0 = 无增量帧）
+    24 u64 index_offset（0 = 未完成）
+    32 u64 data_offset
+    40..63 保留（0）
+*/
+static void encode_header(uint8_t h[IPF_HEADER_SIZE], ipf_format format, int width, int height, uint32_t frame_bytes,
+                          uint32_t frame_count, uint32_t keyframe_interval, uint64_t index_offset)
+{
+    memset(h, 0, IPF_HEADER_SIZE);
+    memcpy(h, IPF_MAGIC, 4);
+    put_u16(h + 4, IPF_VERSION);
+    put_u16(h + 6, (uint16_t)format);
+    put_u16(h + 8, (uint16_t)width);
+    put_u16(h + 10, (uint16_t)height);
+    put_u32(h + 12, frame_bytes);
+    put_u32(h + 16, frame_count);
+    put_u32(h + 20, keyframe_interval);
+    put_u64(h + 24, index_offset);
+    put_u64(h + 32, IPF_HEADER_SIZE);
+}
+
+uint32_t ipf_frame_bytes(ipf_format format, int width, int height)
+{
+    if (format == IPF_FORMAT_PACKED) return (uint32_t)total_words(width, height) * (uint32_t)sizeof(uint32_t);
+    return (uint32_t)width * (uint32_t)height;
+}
+
+// ---------------- 写入 ----------------
+
+int ipf_writer_open(ipf_writer* w, const char* path, ipf_format format, int width, int height)
+{
+    uint8_t h[IPF_HEADER_SIZE];
+    memset(w, 0, sizeof(*w));
+    if (width <= 0 || height <= 0 || width > 0xFFFF || height > 0xFFFF) return -1;
+    if (format != IPF_FORMAT_PACKED && format != IPF_FORMAT_GRAY8) return -1;
+    w->fp = fopen(path, "wb");
+    if (!w->fp) return -1;
+    w->format = format;
+    w->width = width;
+    w->height = height;
+    w->frame_bytes = ipf_frame_bytes(format, width, height);
+    encode_header(h, format, width, height, w->frame_bytes, 0, 0, 0);
+    if (fwrite(h, 1, IPF_HEADER_SIZE, w->fp) != IPF_HEADER_SIZE)
+    {
+        fclose(w->fp);
+        w->fp = NULL;
+        return -1;
+    }
+    w->pos = IPF_HEADER_SIZE;
+    return 0;
+}
+
+int ipf_writer_set_delta(ipf_writer* w, uint32_t keyframe_interval)
+{
+    int words = (int)(w->frame_bytes / sizeof(uint32_t));
+    if (!w->fp || w->format != IPF_FORMAT_PACKED || w->count != 0 || keyframe_interval == 0) return -1;
+    free(w->prev);
+    free(w->scratch);
+    w->prev = (uint32_t*)malloc(w->frame_bytes);
+    w->scratch = (uint8_t*)malloc(IPF_DELTA_BOUND(words));
+    if (!w->prev || !w->scratch)
+    {
+        free(w->prev);
+        free(w->scratch);
+        w->prev = NULL;
+        w->scratch = NULL;
+        return -1;
+    }
+    w->keyframe_interval = keyframe_interval;
+    return 0;
+}
+
+int ipf_writer_add(ipf_writer* w, const void* frame)
+{
+    static const uint8_t zeros[IPF_FRAME_ALIGN] = {0};
+    const void* data = frame;
+    uint32_t size = w->frame_bytes;
+    uint32_t flags = 0;
+    uint32_t pad;
+    if (!w->fp) return -1;
+    if (w->count == w->cap)
+    {
+        uint32_t cap = w->cap ? w->cap * 2 : 1024;
+        ipf_index_entry* p = (ipf_index_entry*)realloc(w->index, (size_t)cap * sizeof(*p));
+        if (!p) return -1;
+        w->index = p;
+        w->cap = cap;
+    }
+    if (w->keyframe_interval && (w->count % w->keyframe_interval) != 0)
+    {
+        size_t n = ipf_delta_encode(w->prev, (const uint32_t*)frame, (int)(w->frame_bytes / sizeof(uint32_t)), w->scratch);
+        if (n < w->frame_bytes) // 变化太多的帧原样存放，同时充当关键帧
+        {
+            data = w->scratch;
+            size = (uint32_t)n;
+            flags = IPF_FRAME_DELTA;
+        }
+    }
+    if (w->keyframe_interval) memcpy(w->prev, frame, w->frame_bytes);
+    // 原样帧按 IPF_FRAME_ALIGN 对齐（零拷贝按 uint32_t 访问）；增量帧按字节解码，只补齐到 4 字节，
+    // 读取端据此拒绝任何非 4 字节对齐的偏移
+    pad = (uint32_t)(flags ? ((4u - (w->pos & 3u)) & 3u)
+                           : ((IPF_FRAME_ALIGN - (w->pos & (IPF_FRAME_ALIGN - 1))) & (IPF_FRAME_ALIGN - 1)));
+    if (pad && fwrite(zeros, 1, pad, w->fp) != pad) return -1;
+    w->pos += pad;
+    if (size && fwrite(data, 1, size, w->fp) != size) return -1;
+    w->index[w->count].offset = w->pos;
+    w->index[w->count].size = size;
+    w->index[w->count].flags = flags;
+    w->count++;
+    w->pos += size;
+    return 0;
+}
+
+int ipf_writer_close(ipf_writer* w)
+{
+    uint8_t h[IPF_HEADER_SIZE];
+    uint8_t e[IPF_INDEX_ENTRY];
+    uint64_t index_offset;
+    uint32_t i;
+    int ok;
+    if (!w->fp) return -1;
+    index_offset = w->pos;
+    ok = 1;
+    for (i = 0; i < w->count && ok; i++)
+    {
+        put_u64(e, w->index[i].offset);
+        put_u32(e + 8, w->index[i].size);
+        put_u32(e + 12, w->index[i].flags);
+        ok = fwrite(e, 1, IPF_INDEX_ENTRY, w->fp) == IPF_INDEX_ENTRY;
+    }
+    // 索引写完后再回填文件头：中途失败的文件 index_offset 保持 0
+    encode_header(h, w->format, w->width, w->height, w->frame_bytes, w->count, w->keyframe_interval, index_offset);
+    ok = ok && fflush(w->fp) == 0 && fseek(w->fp, 0, SEEK_SET) == 0 && fwrite(h, 1, IPF_HEADER_SIZE, w->fp) == IPF_HEADER_SIZE;
+    ok = (fclose(w->fp) == 0) && ok;
+    free(w->index);
+    free(w->prev);
+    free(w->scratch);
+    w->fp = NULL;
+    w->index = NULL;
+    w->prev = NULL;
+    w->scratch = NULL;
+    w->count = w->cap = 0;
+    return ok ? 0 : -1;
+}
+
+// ---------------- 读取 ----------------
+
+static int map_file(ipf_reader* r, const char* path)
+{
+#if defined(IPF_NO_MMAP)
+    FILE* fp = fopen(path, "rb");
+    long n;
+    uint8_t* buf;
+    if (!fp) return -1;
+    if (fseek(fp, 0, SEEK_END) != 0 || (n = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0)
+    {
+        fclose(fp);
+        return -1;
+    }
+    buf = (uint8_t*)malloc(n ? (size_t)n : 1);
+    if (!buf || fread(buf, 1, (size_t)n, fp) != (size_t)n)
+    {
+        free(buf);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    r->base = buf;
+    r->size = (size_t)n;
+    r->map = buf;
+    return 0;
+#elif defined(_WIN32)
+    HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    HANDLE m;
+    LARGE_INTEGER n;
+    void* p;
+    if (f == INVALID_HANDLE_VALUE) return -1;
+    if (!GetFileSizeEx(f, &n) || n.QuadPart == 0)
+    {
+        CloseHandle(f);
+        return -1;
+    }
+    m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(f); // 映射对象持有文件引用
+    if (!m) return -1;
+    p = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!p)
+    {
+        CloseHandle(m);
+        return -1;
+    }
+    r->base = (const uint8_t*)p;
+    r->size = (size_t)n.QuadPart;
+    r->map = m;
+    return 0;
+#else
+    struct stat st;
+    void* p;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return -1;
+    }
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // 映射建立后即可关闭描述符
+    if (p == MAP_FAILED) return -1;
+    r->base = (const uint8_t*)p;
+    r->size = (size_t)st.st_size;
+    r->map = NULL;
+    return 0;
+#endif
+}
+
+static void unmap_file(ipf_reader* r)
+{
+    if (!r->base) return;
+#if defined(IPF_NO_MMAP)
+    free(r->map);
+#elif defined(_WIN32)
+    UnmapViewOfFile(r->base);
+    CloseHandle((HANDLE)r->map);
+#else
+    munmap((void*)r->base, r->size);
+#endif
+    r->base = NULL;
+    r->map = NULL;
+    r->size = 0;
+}
+
+int ipf_reader_open(ipf_reader* r, const char* path)
+{
+    const uint8_t* h;
+    uint64_t index_offset;
+    uint32_t i;
+    memset(r, 0, sizeof(*r));
+    if (map_file(r, path) != 0) return -1;
+    h = r->base;
+    if (r->size < IPF_HEADER_SIZE || memcmp(h, IPF_MAGIC, 4) != 0 || get_u16(h + 4) != IPF_VERSION) goto bad;
+    r->format = (ipf_format)get_u16(h + 6);
+    r->width = get_u16(h + 8);
+    r->height = get_u16(h + 10);
+    r->frame_bytes = get_u32(h + 12);
+    r->frame_count = get_u32(h + 16);
+    r->keyframe_interval = get_u32(h + 20);
+    index_offset = get_u64(h + 24);
+    if ((r->format != IPF_FORMAT_PACKED && r->format != IPF_FORMAT_GRAY8) || r->width == 0 || r->height == 0) goto bad;
+    if (r->frame_bytes != ipf_frame_bytes(r->format, r->width, r->height)) goto bad;
+    if (index_offset < IPF_HEADER_SIZE || index_offset > r->size ||
+        (uint64_t)r->frame_count * IPF_INDEX_ENTRY > r->size - index_offset) goto bad;
+    r->index = r->base + index_offset;
+    for (i = 0; i < r->frame_count; i++)
+    {
+        const uint8_t* e = r->index + (size_t)i * IPF_INDEX_ENTRY;
+        uint64_t off = get_u64(e);
+        uint32_t size = get_u32(e + 8);
+        uint32_t flags = get_u32(e + 12);
+        // 偏移必须 4 字节对齐：原样帧会被当作 const uint32_t* 直接交给流水线，未对齐在严格对齐的目标上会出错
+        if (off < IPF_HEADER_SIZE || off > index_offset || size > index_offset - off || (off & 3) != 0) goto bad;
+        // 增量帧只出现在位打包归档中且不能是第一帧；原样帧必须是整帧
+        if (flags == IPF_FRAME_DELTA)
+        {
+            if (r->format != IPF_FORMAT_PACKED || i == 0) goto bad;
+        }
+        else if (flags != 0 || size != r->frame_bytes)
+        {
+            goto bad;
+        }
+    }
+    return 0;
+bad:
+    unmap_file(r);
+    memset(r, 0, sizeof(*r));
+    return -1;
+}
+
+int ipf_reader_entry(const ipf_reader* r, uint32_t i, ipf_index_entry* e)
+{
+    const uint8_t* p;
+    if (i >= r->frame_count) return -1;
+    p = r->index + (size_t)i * IPF_INDEX_ENTRY;
+    e->offset = get_u64(p);
+    e->size = get_u32(p + 8);
+    e->flags = get_u32(p + 12);
+    return 0;
+}
+
+const void* ipf_reader_frame(const ipf_reader* r, uint32_t i)
+{
+    ipf_index_entry e;
+    if (ipf_reader_entry(r, i, &e) != 0 || e.flags != 0 || e.size != r->frame_bytes) return NULL;
+    return r->base + e.offset;
+}
+
+void ipf_reader_close(ipf_reader* r)
+{
+    unmap_file(r);
+    memset(r, 0, sizeof(*r));
+}
+
+// ---------------- 时域增量 ----------------
+
+static uint8_t* put_varint(uint8_t* p, uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+// 读一个 varint；越界或超过 5 字节返回 NULL
+static const uint8_t* get_varint(const uint8_t* p, const uint8_t* end, uint32_t* v)
+{
+    uint32_t x = 0;
+    int shift;
+    for (shift = 0; shift < 35 && p < end; shift += 7)
+    {
+        uint8_t b = *p++;
+        x |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+        {
+            *v = x;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+size_t ipf_delta_encode(const uint32_t* prev, const uint32_t* cur, int words, uint8_t* out)
+{
+    uint8_t* p = out;
+    int i = 0;
+    while (i < words)
+    {
+        int same = i, diff;
+        while (i < words && prev[i] == cur[i]) i++;
+        if (i == words) break; // 末尾不变的 word 省略
+        diff = i;
+        while (i < words && prev[i] != cur[i]) i++;
+        p = put_varint(p, (uint32_t)(diff - same));
+        p = put_varint(p, (uint32_t)(i - diff));
+        for (; diff < i; diff++)
+        {
+            put_u32(p, prev[diff] ^ cur[diff]);
+            p += 4;
+        }
+    }
+    return (size_t)(p - out);
+}
+
+int ipf_delta_decode(const uint8_t* src, size_t size, const uint32_t* ref, uint32_t* out, int words)
+{
+    const uint8_t* end = src + size;
+    uint32_t pos = 0, skip, lit, j;
+    while (src < end)
+    {
+        if (!(src = get_varint(src, end, &skip)) || !(src = get_varint(src, end, &lit))) return -1;
+        if (skip > (uint32_t)words - pos || lit > (uint32_t)words - pos - skip || (size_t)(end - src) < (size_t)lit * 4)
+            return -1;
+        if (ref != out) memcpy(out + pos, ref + pos, (size_t)skip * sizeof(uint32_t)); // 原地解码时不变的 word 直接跳过
+        pos += skip;
+        for (j = 0; j < lit; j++, src += 4) out[pos + j] = ref[pos + j] ^ get_u32(src);
+        pos += lit;
+    }
+    if (ref != out) memcpy(out + pos, ref + pos, (size_t)((uint32_t)words - pos) * sizeof(uint32_t));
+    return 0;
+}
+
+int ipf_decoder_init(ipf_decoder* d, const ipf_reader* r)
+{
+    memset(d, 0, sizeof(*d));
+    if (r->format != IPF_FORMAT_PACKED) return -1;
+    d->r = r;
+    d->words = (int)(r->frame_bytes / sizeof(uint32_t));
+    d->buf = (uint32_t*)malloc(r->frame_bytes);
+    d->last_index = UINT32_MAX;
+    return d->buf ? 0 : -1;
+}
+
+// 把第 i 帧（增量帧）相对 ref 解到 buf
+static int decode_into_buf(ipf_decoder* d, uint32_t i, const uint32_t* ref)
+{
+    ipf_index_entry e;
+    ipf_reader_entry(d->r, i, &e);
+    return ipf_delta_decode(d->r->base + e.offset, e.size, ref, d->buf, d->words);
+}
+
+const uint32_t* ipf_decoder_frame(ipf_decoder* d, uint32_t i)
+{
+    ipf_index_entry e;
+    const uint32_t* ref;
+    uint32_t k;
+    if (ipf_reader_entry(d->r, i, &e) != 0) return NULL;
+    if (i == d->last_index) return d->last;
+    if (e.flags == 0)
+    {
+        d->last = (const uint32_t*)(d->r->base + e.offset);
+        d->last_index = i;
+        return d->last;
+    }
+    if (d->last_index != UINT32_MAX && d->last_index + 1 == i)
+    {
+        ref = d->last; // 顺序读取：last 为 buf 时原地解码
+    }
+    else
+    {
+        // 跳读：回到最近的关键帧，逐帧解到 i-1（第一帧一定是关键帧）
+        k = i;
+        do
+        {
+            ipf_reader_entry(d->r, --k, &e);
+        } while (e.flags != 0);
+        ref = (const uint32_t*)(d->r->base + e.offset);
+        for (k++; k < i; k++)
+        {
+            if (decode_into_buf(d, k, ref) != 0) goto bad;
+            ref = d->buf;
+        }
+    }
+    if (decode_into_buf(d, i, ref) != 0) goto bad;
+    d->last = d->buf;
+    d->last_index = i;
+    return d->last;
+bad:
+    d->last = NULL;
+    d->last_index = UINT32_MAX;
+    return NULL;
+}
+
+void ipf_decoder_free(ipf_decoder* d)
+{
+    free(d->buf);
+    memset(d, 0, sizeof(*d));
+}
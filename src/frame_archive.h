@@ -0,0 +1,141 @@
+#ifndef FRAME_ARCHIVE_H
+#define FRAME_ARCHIVE_H
+
+/*
+  .ipf 帧归档：把整段录像的 188×120 二值帧（或灰度帧）连续存成一个文件，回放时 mmap 后按帧取指针直接进流水线，
+  不再为每帧解码 PNG / mp4。
+
+  文件布局（小端）：
+    [0, 64)      文件头：magic "IPF1"、版本、格式、宽高、每帧字节数、帧数、索引偏移
+    [64, ...)    帧数据：原样帧起点按 64 字节对齐（位打包帧 2880 字节恰为 45×64，连续存放无填充），
+                 增量帧起点按 4 字节对齐；读取端拒绝非 4 字节对齐的偏移
+    [index, end) 索引：每帧 16 字节 {uint64 offset, uint32 size, uint32 flags}
+  - 位打包格式与 morph_binary_bitpacked 相同：image_h 行 × words_per_row(image_w) 个 uint32，bit=1 为白，
+    最左像素在 bit0；一帧 2880 字节（188×120 的纯位数为 2820 字节，每行补齐到 32 位）。
+    mmap 的基址按页对齐、帧起点按 64 字节对齐，ipf_reader_frame 返回的指针可直接当 const uint32_t* 交给
+    image_process_packed_ctx（零拷贝）。
+  - 灰度格式每帧 width×height 字节（行跨度 = width），回放时再按阈值打包，可在回放时换阈值。
+  - 索引放在文件末尾，写入端边写帧边记偏移，关闭时写索引并回填文件头；未正常关闭的文件 index_offset 为 0，
+    读取端视为损坏。flags 为 0 表示原样存放，IPF_FRAME_DELTA 表示时域增量帧。
+  - 时域增量（仅位打包格式，ipf_writer_set_delta 开启）：相邻帧只差几百个像素，增量帧存与上一帧的 XOR，
+    按 word 游程编码为若干 {varint 不变 word 数, varint 变化 word 数, 变化 word 的 XOR 值 × n（u32 小端）}，
+    末尾的不变 word 省略。每 keyframe_interval 帧一个原样关键帧（编码后不比原样小的帧也原样存），
+    随机访问第 i 帧时从不晚于 i 的最近关键帧向后解码；顺序回放时在同一缓冲区原地解码，不变的 word 直接跳过。
+    关键帧仍可零拷贝，增量帧经 ipf_decoder 解码后交给流水线。
+  - 读取端：POSIX 用 mmap，Windows 用 MapViewOfFile；都不可用时（定义 IPF_NO_MMAP）整个文件读进内存。
+    帧数据按主机字节序解释，位打包帧只能在小端机器上零拷贝使用。
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IPF_MAGIC        "IPF1"
+#define IPF_VERSION      1
+#define IPF_HEADER_SIZE  64
+#define IPF_INDEX_ENTRY  16
+#define IPF_FRAME_ALIGN  64
+
+#define IPF_FRAME_DELTA  1u // 索引 flags：与上一帧的 XOR 游程编码
+
+// 增量编码输出上界（字节）：每个变化 word 4 字节，每段游程两个 varint（各至多 5 字节）
+#define IPF_DELTA_BOUND(words) ((size_t)(words) * 9u + 10u)
+
+typedef enum {
+    IPF_FORMAT_PACKED = 0, // 位打包（words_per_row 布局）
+    IPF_FORMAT_GRAY8 = 1   // 8 位灰度，行跨度 = width
+} ipf_format;
+
+typedef struct {
+    uint64_t offset; // 帧数据在文件中的偏移
+    uint32_t size;   // 帧数据字节数
+    uint32_t flags;  // 0 = 原样存放
+} ipf_index_entry;
+
+typedef struct {
+    FILE* fp;
+    ipf_format format;
+    int width;
+    int height;
+    uint32_t frame_bytes;     // 每帧原始字节数
+    uint32_t count;           // 已写帧数
+    uint32_t cap;
+    ipf_index_entry* index;   // 帧索引（关闭时写到文件末尾）
+    uint64_t pos;             // 当前写位置
+    uint32_t keyframe_interval; // 0 = 全部原样存放
+    uint32_t* prev;           // 上一帧（增量编码的参考）
+    uint8_t* scratch;         // 增量编码缓冲区
+} ipf_writer;
+
+typedef struct {
+    const uint8_t* base;      // 文件映像首地址
+    size_t size;              // 文件字节数
+    ipf_format format;
+    int width;
+    int height;
+    uint32_t frame_bytes;
+    uint32_t frame_count;
+    uint32_t keyframe_interval; // 写入时的关键帧间隔（0 = 无增量帧）
+    const uint8_t* index;     // 索引区（按 ipf_index_entry 的磁盘布局，小端）
+    void* map;                // 平台句柄（mmap 长度 / 映射对象 / 内存副本）
+} ipf_reader;
+
+// 位打包帧解码器：关键帧直接返回映像内指针，增量帧解码到 buf
+typedef struct {
+    const ipf_reader* r;
+    int words;                // 每帧 word 数
+    uint32_t* buf;            // 增量帧解码结果
+    const uint32_t* last;     // 上次返回的帧（映像内关键帧或 buf）
+    uint32_t last_index;      // last 是第几帧（UINT32_MAX = 无）
+} ipf_decoder;
+
+// 格式对应的每帧原始字节数
+uint32_t ipf_frame_bytes(ipf_format format, int width, int height);
+
+// 创建归档并写文件头；失败返回 -1
+int ipf_writer_open(ipf_writer* w, const char* path, ipf_format format, int width, int height);
+
+// 追加一帧：PACKED 为 height × words_per_row(width) 个 uint32，GRAY8 为 width×height 字节；失败返回 -1
+int ipf_writer_add(ipf_writer* w, const void* frame);
+
+// 开启时域增量：每 keyframe_interval 帧一个关键帧（1 = 全部关键帧）；须在第一帧之前调用，仅位打包格式，失败返回 -1
+int ipf_writer_set_delta(ipf_writer* w, uint32_t keyframe_interval);
+
+// 写索引、回填文件头并关闭；失败返回 -1（文件保持未完成状态，读取端会拒绝）
+int ipf_writer_close(ipf_writer* w);
+
+// 打开并映射归档，校验文件头与索引；失败返回 -1
+int ipf_reader_open(ipf_reader* r, const char* path);
+
+// 第 i 帧数据（零拷贝，指向映像内部，ipf_reader_close 之前有效）；越界或非原样存放返回 NULL
+const void* ipf_reader_frame(const ipf_reader* r, uint32_t i);
+
+// 第 i 帧的索引项；越界返回 -1
+int ipf_reader_entry(const ipf_reader* r, uint32_t i, ipf_index_entry* e);
+
+void ipf_reader_close(ipf_reader* r);
+
+// 增量编码 cur 相对 prev 的变化，写入 out（至少 IPF_DELTA_BOUND(words) 字节），返回字节数（两帧相同时为 0）
+size_t ipf_delta_encode(const uint32_t* prev, const uint32_t* cur, int words, uint8_t* out);
+
+// 增量解码：out = ref ^ delta；ref == out 时原地解码，不变的 word 不读不写。数据损坏返回 -1
+int ipf_delta_decode(const uint8_t* src, size_t size, const uint32_t* ref, uint32_t* out, int words);
+
+// 位打包归档的解码器；灰度归档或内存不足返回 -1
+int ipf_decoder_init(ipf_decoder* d, const ipf_reader* r);
+
+// 第 i 帧的位图（关键帧零拷贝）；指针在下一次调用前有效。顺序读取时每帧只解一个增量，跳读时从最近关键帧解起。
+// 越界或数据损坏返回 NULL
+const uint32_t* ipf_decoder_frame(ipf_decoder* d, uint32_t i);
+
+void ipf_decoder_free(ipf_decoder* d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_ARCHIVE_H
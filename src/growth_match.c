@@ -0,0 +1,214 @@
+#include "growth_match.h"
+#include <string.h>
+
+#define GROWTH_NONE 0xFFFFu
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GROWTH_CTZ64(x) __builtin_ctzll(x)
+#else
+static int growth_ctz64(uint64_t x) { int n = 0; while (!(x & 1u)) { x >>= 1; n++; } return n; }
+#define GROWTH_CTZ64(x) growth_ctz64(x)
+#endif
+
+int growth_matcher_compile(growth_matcher* m, const growth_pattern* pats, int count)
+{
+    int k, j;
+    if (!m || !pats || count <= 0 || count > GROWTH_MATCH_MAX_PATTERNS) return -1;
+    memset(m, 0, sizeof(*m));
+    m->count = (uint8_t)count;
+    m->table_ok = 1;
+    for (k = 0; k < count; k++)
+    {
+        const growth_pattern* p = &pats[k];
+        m->pats[k] = *p;
+        // 位掩码按 uint8 存 pattern 下标，状态数受 GROWTH_MATCH_MAX_STATES 限制
+        if (!p->pattern || p->len == 0 || p->len > 8
+            || (p->len - 1) * (p->max_gap + 1) > GROWTH_MATCH_MAX_STATES)
+        {
+            m->table_ok = 0;
+            continue;
+        }
+        for (j = 0; j < p->len; j++)
+        {
+            uint16_t v = p->pattern[j];
+            uint16_t vr = p->pattern[p->len - 1 - j];
+            if (v >= GROWTH_MATCH_MAX_VALUE || vr >= GROWTH_MATCH_MAX_VALUE)
+            {
+                m->table_ok = 0;
+                break;
+            }
+            m->eq[0][k][v] |= (uint8_t)(1u << j);
+            m->eq[1][k][vr] |= (uint8_t)(1u << j);
+        }
+        m->head[0][p->pattern[0] & (GROWTH_MATCH_MAX_VALUE - 1)] |= (uint8_t)(1u << k);
+        m->head[1][p->pattern[p->len - 1] & (GROWTH_MATCH_MAX_VALUE - 1)] |= (uint8_t)(1u << k);
+    }
+    return 0;
+}
+
+// 单个模式的 NFA：状态 s = (j-1)*(max_gap+1) + g，同一状态的候选起点串成链表（link 按起点下标索引）
+typedef struct {
+    uint64_t occ;
+    uint16_t head[GROWTH_MATCH_MAX_STATES];
+    uint16_t tail[GROWTH_MATCH_MAX_STATES];
+} growth_nfa;
+
+static void growth_nfa_append(growth_nfa* n, uint16_t* link, int s, uint16_t h, uint16_t t)
+{
+    if (n->occ & (1ull << s))
+    {
+        link[n->tail[s]] = h;
+        n->tail[s] = t;
+    }
+    else
+    {
+        n->occ |= 1ull << s;
+        n->head[s] = h;
+        n->tail[s] = t;
+    }
+}
+
+// 推进一个元素：eqm 为该元素对应的 pattern 位掩码（方向已换算），pos 为元素下标
+static void growth_nfa_step(growth_nfa* cur, growth_nfa* next, uint16_t* link, uint16_t* other_end,
+                            uint16_t* hits, int len, int gap, uint8_t eqm, uint16_t pos)
+{
+    uint64_t occ = cur->occ;
+    next->occ = 0;
+    while (occ)
+    {
+        int s = GROWTH_CTZ64(occ);
+        int j = s / (gap + 1) + 1; // 已匹配个数
+        int g = s % (gap + 1);
+        occ &= occ - 1;
+        if ((eqm >> j) & 1u)
+        {
+            if (j + 1 == len)
+            {
+                // 整组成功：组内每个候选起点的另一端都是 pos
+                uint16_t p = cur->head[s];
+                for (;;)
+                {
+                    other_end[p] = pos;
+                    (*hits)++;
+                    if (p == cur->tail[s]) break;
+                    p = link[p];
+                }
+            }
+            else
+            {
+                growth_nfa_append(next, link, j * (gap + 1), cur->head[s], cur->tail[s]);
+            }
+        }
+        else if (g < gap)
+        {
+            growth_nfa_append(next, link, s + 1, cur->head[s], cur->tail[s]);
+        }
+        // 否则间隔超限，整组失败
+    }
+    if (eqm & 1u)
+    {
+        if (len == 1)
+        {
+            other_end[pos] = pos;
+            (*hits)++;
+        }
+        else
+        {
+            growth_nfa_append(next, link, 0, pos, pos);
+        }
+    }
+}
+
+void growth_scan_run(growth_scan* s, const growth_matcher* m, const uint16_t* input, size_t len,
+                     int8_t direction, uint8_t mask)
+{
+    growth_nfa nfa[GROWTH_MATCH_MAX_PATTERNS][2];
+    uint16_t link[GROWTH_MATCH_MAX_PATTERNS][GROWTH_MATCH_MAX_INPUT];
+    uint8_t cur[GROWTH_MATCH_MAX_PATTERNS] = { 0 }; // 每个模式当前使用的 nfa 缓冲（只在推进后交换）
+    int d = (direction == 1) ? 0 : 1;
+    int k, n = (int)len;
+    uint8_t active = 0; // 有活跃状态的模式
+
+    s->m = m;
+    s->input = input;
+    s->len = len;
+    s->direction = direction;
+    s->mask = (uint8_t)(mask & ((1u << m->count) - 1u));
+    memset(s->hits, 0, sizeof(s->hits));
+    s->fallback = (!m->table_ok || !input || len > GROWTH_MATCH_MAX_INPUT || (direction != 1 && direction != -1));
+    if (s->fallback || len == 0) return;
+
+    for (k = 0; k < m->count; k++)
+    {
+        if (!(s->mask & (1u << k))) continue;
+        memset(s->other_end[k], 0xFF, len * sizeof(uint16_t));
+        nfa[k][0].occ = 0;
+    }
+
+    for (int step = 0; step < n; step++)
+    {
+        int i = d ? n - 1 - step : step;
+        uint16_t v = input[i];
+        uint8_t starting = (v < GROWTH_MATCH_MAX_VALUE) ? (uint8_t)(m->head[d][v] & s->mask) : 0u;
+        uint8_t todo = (uint8_t)(active | starting);
+        active = 0;
+        while (todo)
+        {
+            k = GROWTH_CTZ64(todo);
+            todo &= (uint8_t)(todo - 1);
+            uint8_t eqm = (v < GROWTH_MATCH_MAX_VALUE) ? m->eq[d][k][v] : 0u;
+            growth_nfa_step(&nfa[k][cur[k]], &nfa[k][cur[k] ^ 1], link[k], s->other_end[k], &s->hits[k],
+                            m->pats[k].len, m->pats[k].max_gap, eqm, (uint16_t)i);
+            cur[k] ^= 1;
+            if (nfa[k][cur[k]].occ) active |= (uint8_t)(1u << k);
+        }
+    }
+}
+
+static match_result growth_make_result(const growth_pattern* p, uint16_t start, uint16_t end)
+{
+    match_result result = {0, 0, 0, 0, MATCH_CONFIDENCE_ZERO};
+    // 与 match_strict_sequence_with_gaps 相同：起止之间除了模式元素都计为间隔
+    uint16_t total_gap = (uint16_t)(end - start + 1 - p->len);
+    uint16_t max_possible_gap = (uint16_t)(p->len - 1) * p->max_gap;
+    result.matched = 1;
+    result.total_gap = (uint8_t)total_gap;
+    result.start = start;
+    result.end = end;
+    if (max_possible_gap == 0) {
+        result.confidence = (total_gap == 0) ? MATCH_CONFIDENCE_ONE : MATCH_CONFIDENCE_ZERO;
+    } else {
+        result.confidence = MATCH_CONFIDENCE_FROM_GAP(total_gap, max_possible_gap);
+    }
+    return result;
+}
+
+match_result growth_scan_query(const growth_scan* s, int k, size_t start_pos)
+{
+    match_result result = {0, 0, 0, 0, MATCH_CONFIDENCE_ZERO};
+    const growth_pattern* p;
+    if (!s->m || k < 0 || k >= s->m->count) return result;
+    p = &s->m->pats[k];
+    if (s->fallback || !(s->mask & (1u << k)))
+    {
+        return match_strict_sequence_with_gaps(s->input, s->len, p->pattern, p->len, p->max_gap, start_pos, s->direction);
+    }
+    // 与原函数一致：start_pos 越界时两个方向都直接返回未匹配
+    if (s->len == 0 || s->hits[k] == 0 || start_pos >= s->len) return result;
+
+    if (s->direction == 1)
+    {
+        for (size_t i = start_pos; i < s->len; i++)
+        {
+            if (s->other_end[k][i] != GROWTH_NONE) return growth_make_result(p, (uint16_t)i, s->other_end[k][i]);
+        }
+    }
+    else
+    {
+        for (int i = (int)start_pos; i >= 0; i--)
+        {
+            if (s->other_end[k][i] != GROWTH_NONE) return growth_make_result(p, s->other_end[k][i], (uint16_t)i);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,76 @@
+#ifndef GROWTH_MATCH_H
+#define GROWTH_MATCH_H
+
+/*
+  生长方向序列的多模式匹配器（match_strict_sequence_with_gaps 的一次扫描版）
+
+  设计说明：
+  - 编译：growth_matcher_compile 把若干 (模式, 最大间隔) 组合预处理成“值 → 模式下标位掩码”表，
+    每个上下文初始化时编译一次。
+  - 扫描：growth_scan_run 对一个方向数组只走一遍（正向或反向），所有模式同时推进。
+    每个模式是一个带间隔上限的小 NFA，状态为 (已匹配个数 j, 当前间隔 g)；
+    状态相同的候选起点未来走法完全相同，合并为一组，只在成功时逐个记下终点，
+    因此每个元素的开销只与当前活跃状态数有关，增加模式不会增加整遍重扫。
+  - 查询：growth_scan_query(scan, k, start_pos) 返回与
+    match_strict_sequence_with_gaps(input, len, pattern_k, len_k, gap_k, start_pos, direction)
+    完全相同的 match_result（start/end/total_gap/confidence 语义不变）：
+    原函数按窗口依次尝试，结果就是 start_pos 之后（反向为之前）第一个贪心匹配成功的候选起点。
+  - 超出限制（模式过长、间隔过大、值超出方向码范围、输入过长）时自动回退逐模式匹配，结果不变。
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "image.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GROWTH_MATCH_MAX_PATTERNS 8   // 最多模式数
+#define GROWTH_MATCH_MAX_STATES   64  // 每个模式的状态数上限：(len-1)*(max_gap+1)
+#define GROWTH_MATCH_MAX_VALUE    8   // 方向码取值 0..7
+#define GROWTH_MATCH_MAX_INPUT    USE_num
+#define GROWTH_MATCH_ALL          0xFFu
+
+typedef struct {
+    const uint16_t* pattern;
+    uint8_t len;
+    uint8_t max_gap;
+} growth_pattern;
+
+typedef struct {
+    uint8_t count;
+    uint8_t table_ok;                                    // 0：存在超限模式，扫描全部回退逐模式匹配
+    growth_pattern pats[GROWTH_MATCH_MAX_PATTERNS];
+    // [0] 正向：bit j 表示 pattern[j] == v；[1] 反向：bit j 表示 pattern[len-1-j] == v
+    uint8_t eq[2][GROWTH_MATCH_MAX_PATTERNS][GROWTH_MATCH_MAX_VALUE];
+    uint8_t head[2][GROWTH_MATCH_MAX_VALUE];             // bit k：模式 k 在该方向上的第一个元素 == v
+} growth_matcher;
+
+typedef struct {
+    const growth_matcher* m;
+    const uint16_t* input;
+    size_t len;
+    int8_t direction;       // 1=正向, -1=反向
+    uint8_t mask;           // 本次扫描包含的模式
+    uint8_t fallback;       // 1：本次未走表，查询时直接调用 match_strict_sequence_with_gaps
+    uint16_t hits[GROWTH_MATCH_MAX_PATTERNS];
+    // 候选起点 p 贪心匹配成功时另一端的下标（正向为 end，反向为 start），0xFFFF 表示失败
+    uint16_t other_end[GROWTH_MATCH_MAX_PATTERNS][GROWTH_MATCH_MAX_INPUT];
+} growth_scan;
+
+// 编译模式表；返回 0，参数非法返回 -1
+int growth_matcher_compile(growth_matcher* m, const growth_pattern* pats, int count);
+
+// 对 input 做一次正向（direction=1）或反向（-1）扫描，mask 选择参与的模式（GROWTH_MATCH_ALL 为全部）
+void growth_scan_run(growth_scan* s, const growth_matcher* m, const uint16_t* input, size_t len,
+                     int8_t direction, uint8_t mask);
+
+// 取模式 k 从 start_pos 开始（同 match_strict_sequence_with_gaps 的 start_pos）的匹配结果
+match_result growth_scan_query(const growth_scan* s, int k, size_t start_pos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GROWTH_MATCH_H
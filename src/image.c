@@ -3,21 +3,46 @@
 
 //------------------------------------------------------------------------------------------------------------------
 #include "image.h"
+#include "pipeline_context.h"
 #include "morph_binary_bitpacked.h"
 #include "global_image_buffer.h"
 #include "dynamic_log.h"
-#include "kalman.h"
-
-// ---- Kalman Filter for firstcorner_pos ----
-static KalmanFilter kf_firstcorner;
-static int kf_firstcorner_initialized = 0;
-static int kf_firstcorner_loss_count = 0; // 连续丢失帧数计数器
-#define KALMAN_MAX_LOSS_FRAMES 5 // 禁用卡尔曼滤波器的连续丢失帧数阈值
-uint8_t firstcorner_pos[2]={0,0};
-uint8_t firstcorner_pos_filtered[2] = {0, 0}; // 滤波后的位置 [x, y]
-uint8_t secondcorner_pos[2]={0,0};
-uint8_t secondcorner_pos_filtered[2] = {0, 0}; // 滤波后的位置 [x, y]
-// -----------------------------------------
+#include "border_stats.h"
+#include "area_downscale.h"
+#include "overlay.h"
+#include "stage_timing.h"
+#include "chain_code.h"
+#include <string.h>
+
+// ---- 流水线上下文 ----
+// 原先散落在本文件中的全局状态都已移入 PipelineContext（见 pipeline_context.h）
+static PipelineContext s_default_ctx;
+static int s_default_ctx_initialized = 0;
+
+static void element_matcher_compile(growth_matcher* m);
+static void image_process_bits(PipelineContext* ctx, const uint32_t* bits, int morphed, uint8_t* out, int out_stride);
+static uint16_t search_l_r_bits_run(PipelineContext* ctx, uint16_t break_flag, const uint32_t* bits, const trace_step* from, trace_step* steps, uint16_t *l_stastic, uint16_t *r_stastic, uint8_t *hightest);
+
+void pipeline_context_init(PipelineContext* ctx)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	element_matcher_compile(&ctx->element_matcher);
+	ctx->last_left_lost_up = image_h - 1;
+	ctx->last_right_lost_up = image_h - 1;
+	ctx->left_lost_num = image_h;
+	ctx->right_lost_num = image_h;
+	ctx->log_enabled = 1;
+	ctx->log_frame = -1;
+}
+
+PipelineContext* pipeline_default_context(void)
+{
+	if (!s_default_ctx_initialized) {
+		pipeline_context_init(&s_default_ctx);
+		s_default_ctx_initialized = 1;
+	}
+	return &s_default_ctx;
+}
 
 // --- IMO 数组颜色映射说明 ---
 // imo 数组中的特定值在 GUI 中会被渲染成不同的颜色，用于可视化。
@@ -94,32 +119,30 @@ int16_t limit1(int16_t x, int16_t y)
 //二值化后bin_image用Grayscale取代
 
 /*
-函数名称：void get_start_point(uint8 start_row)
+函数名称：void get_start_point(PipelineContext* ctx, uint8(*image)[image_w], uint8 start_row)
 功能说明：寻找两个边界的边界点作为八邻域循环的起始点
-参数说明：输入任意行数
+参数说明：输入任意行数，起点写入 ctx->start_point_l / ctx->start_point_r
 函数返回：无
 修改时间：2022年9月8日
 备    注：
-example：  get_start_point(image_h-2)
+example：  get_start_point(ctx, image, image_h-2)
  */
-uint8_t start_point_l[2] = { 0 };//左边起点的x，y值
-uint8_t start_point_r[2] = { 0 };//右边起点的x，y值
-uint8_t get_start_point(uint8_t start_row)
+uint8_t get_start_point(PipelineContext* ctx, uint8_t(*image)[image_w], uint8_t start_row)
 {
 	uint16_t i = 0,l_found = 0,r_found = 0;
 	//清零
-	start_point_l[0] = 0;//x
-	start_point_l[1] = 0;//y
+	ctx->start_point_l[0] = 0;//x
+	ctx->start_point_l[1] = 0;//y
 
-	start_point_r[0] = 0;//x
-	start_point_r[1] = 0;//y
+	ctx->start_point_r[0] = 0;//x
+	ctx->start_point_r[1] = 0;//y
 
 		//从中间往左边，先找起点
 	for (i = image_w / 2; i >= border_min; i--)
 	{
-		start_point_l[0] = i;//x
-		start_point_l[1] = start_row;//y
-		if (imo[start_row][i] == 255 && imo[start_row][i - 1] == 0)
+		ctx->start_point_l[0] = i;//x
+		ctx->start_point_l[1] = start_row;//y
+		if (image[start_row][i] == 255 && image[start_row][i - 1] == 0)
 		{
 			//printf("找到左边起点image[%d][%d]\n", start_row,i);
 			l_found = 1;
@@ -129,9 +152,9 @@ uint8_t get_start_point(uint8_t start_row)
 
 	for (i = image_w / 2; i <= border_max; i++)
 	{
-		start_point_r[0] = i;//x
-		start_point_r[1] = start_row;//y
-		if (imo[start_row][i] == 255 && imo[start_row][i + 1] == 0)
+		ctx->start_point_r[0] = i;//x
+		ctx->start_point_r[1] = start_row;//y
+		if (image[start_row][i] == 255 && image[start_row][i + 1] == 0)
 		{
 			//printf("找到右边起点image[%d][%d]\n",start_row, i);
 			r_found = 1;
@@ -147,11 +170,12 @@ uint8_t get_start_point(uint8_t start_row)
 }
 
 /*
-函数名称：void search_l_r(uint16 break_flag, uint8(*image)[image_w],uint16 *l_stastic, uint16 *r_stastic,
+函数名称：void search_l_r(PipelineContext* ctx, uint16 break_flag, uint8(*image)[image_w],uint16 *l_stastic, uint16 *r_stastic,
 							uint8 l_start_x, uint8 l_start_y, uint8 r_start_x, uint8 r_start_y,uint8*hightest)
 
 功能说明：八邻域正式开始找右边点的函数，输入参数有点多，调用的时候不要漏了，这个是左右线一次性找完。
 参数说明：
+ctx					：流水线上下文，找到的点与生长方向写入 ctx->points_l/r、ctx->dir_l/r
 break_flag_r			：最多需要循环的次数
 (*image)[image_w]		：需要进行找点的图像数组，必须是二值图,填入数组名称即可
 					   特别注意，不要拿宏定义名字作为输入参数，否则数据可能无法传递过来
@@ -166,20 +190,10 @@ hightest				：循环结束所得到的最高高度
 修改时间：2022年9月25日
 备    注：
 example：
-	search_l_r((uint16)USE_num,image,&data_stastics_l, &data_stastics_r,start_point_l[0],
-				start_point_l[1], start_point_r[0], start_point_r[1],&hightest);
+	search_l_r(ctx, (uint16)USE_num,image,&ctx->data_stastics_l, &ctx->data_stastics_r,ctx->start_point_l[0],
+				ctx->start_point_l[1], ctx->start_point_r[0], ctx->start_point_r[1],&ctx->hightest);
  */
-#define USE_num	image_h*3	//定义找点的数组成员个数按理说300个点能放下，但是有些特殊情况确实难顶，多定义了一点
-
- //存放点的x，y坐标
-uint16_t points_l[(uint16_t)USE_num][2] = { {  0 } };//左线
-uint16_t points_r[(uint16_t)USE_num][2] = { {  0 } };//右线
-uint16_t dir_r[(uint16_t)USE_num] = { 0 };//用来存储右边生长方向
-uint16_t dir_l[(uint16_t)USE_num] = { 0 };//用来存储左边生长方向
-uint16_t data_stastics_l = 0;//统计左边找到点的个数
-uint16_t data_stastics_r = 0;//统计右边找到点的个数
-uint8_t hightest = 0;//最高点
-void search_l_r(uint16_t break_flag, uint8_t(*image)[image_w], uint16_t *l_stastic, uint16_t *r_stastic, uint8_t l_start_x, uint8_t l_start_y, uint8_t r_start_x, uint8_t r_start_y, uint8_t *hightest)
+void search_l_r(PipelineContext* ctx, uint16_t break_flag, uint8_t(*image)[image_w], uint16_t *l_stastic, uint16_t *r_stastic, uint8_t l_start_x, uint8_t l_start_y, uint8_t r_start_x, uint8_t r_start_y, uint8_t *hightest)
 {
 
 	uint8_t i = 0, j = 0;
@@ -260,8 +274,8 @@ void search_l_r(uint16_t break_flag, uint8_t(*image)[image_w], uint16_t *l_stast
 			search_filds_l[i][1] = center_point_l[1] + seeds_l[i][1];//y
 		}
 		//中心坐标点填充到已经找到的点内
-		points_l[l_data_statics][0] = center_point_l[0];//x
-		points_l[l_data_statics][1] = center_point_l[1];//y
+		ctx->points_l[l_data_statics][0] = center_point_l[0];//x
+		ctx->points_l[l_data_statics][1] = center_point_l[1];//y
 		l_data_statics++;//索引加一
 
 		//右边
@@ -271,8 +285,8 @@ void search_l_r(uint16_t break_flag, uint8_t(*image)[image_w], uint16_t *l_stast
 			search_filds_r[i][1] = center_point_r[1] + seeds_r[i][1];//y
 		}
 		//中心坐标点填充到已经找到的点内
-		points_r[r_data_statics][0] = center_point_r[0];//x
-		points_r[r_data_statics][1] = center_point_r[1];//y
+		ctx->points_r[r_data_statics][0] = center_point_r[0];//x
+		ctx->points_r[r_data_statics][1] = center_point_r[1];//y
 
 		index_l = 0;//先清零，后使用
 		for (i = 0; i < 8; i++)
@@ -294,7 +308,7 @@ void search_l_r(uint16_t break_flag, uint8_t(*image)[image_w], uint16_t *l_stast
 				index_l++;
 				// 记录i（表示在i方向检测到黑色边界，实际生长方向是i+1）
 				// 例：记录3表示在左上(3)检测到黑色，实际向上(4)生长
-				dir_l[l_data_statics - 1] = (i);
+				ctx->dir_l[l_data_statics - 1] = (i);
 			}
 		}
 
@@ -313,36 +327,36 @@ void search_l_r(uint16_t break_flag, uint8_t(*image)[image_w], uint16_t *l_stast
 				}
 			}
 		}
-		if ((r_data_statics >= 2 && points_r[r_data_statics][0] == points_r[r_data_statics-1][0] && points_r[r_data_statics][0] == points_r[r_data_statics - 2][0]
-            && points_r[r_data_statics][1] == points_r[r_data_statics - 1][1] && points_r[r_data_statics][1] == points_r[r_data_statics - 2][1])
-            || (l_data_statics >= 3 && points_l[l_data_statics-1][0] == points_l[l_data_statics - 2][0] && points_l[l_data_statics-1][0] == points_l[l_data_statics - 3][0]
-                && points_l[l_data_statics-1][1] == points_l[l_data_statics - 2][1] && points_l[l_data_statics-1][1] == points_l[l_data_statics - 3][1]))
+		if ((r_data_statics >= 2 && ctx->points_r[r_data_statics][0] == ctx->points_r[r_data_statics-1][0] && ctx->points_r[r_data_statics][0] == ctx->points_r[r_data_statics - 2][0]
+            && ctx->points_r[r_data_statics][1] == ctx->points_r[r_data_statics - 1][1] && ctx->points_r[r_data_statics][1] == ctx->points_r[r_data_statics - 2][1])
+            || (l_data_statics >= 3 && ctx->points_l[l_data_statics-1][0] == ctx->points_l[l_data_statics - 2][0] && ctx->points_l[l_data_statics-1][0] == ctx->points_l[l_data_statics - 3][0]
+                && ctx->points_l[l_data_statics-1][1] == ctx->points_l[l_data_statics - 2][1] && ctx->points_l[l_data_statics-1][1] == ctx->points_l[l_data_statics - 3][1]))
 		{
 			//printf("三次进入同一个点，退出\n");
 			break;
 		}
-		if (my_abs(points_r[r_data_statics][0] - points_l[l_data_statics - 1][0]) < 2
-			&& my_abs(points_r[r_data_statics][1] - points_l[l_data_statics - 1][1]) < 2
+		if (my_abs(ctx->points_r[r_data_statics][0] - ctx->points_l[l_data_statics - 1][0]) < 2
+			&& my_abs(ctx->points_r[r_data_statics][1] - ctx->points_l[l_data_statics - 1][1]) < 2
 			)
 		{
 			//printf("\n左右相遇退出\n");	
-			*hightest = (points_r[r_data_statics][1] + points_l[l_data_statics - 1][1]) >> 1;//取出最高点
+			*hightest = (ctx->points_r[r_data_statics][1] + ctx->points_l[l_data_statics - 1][1]) >> 1;//取出最高点
 			//printf("\n在y=%d处退出\n",*hightest);
 			break;
 		}
-		if ((points_r[r_data_statics][1] < points_l[l_data_statics - 1][1]))
+		if ((ctx->points_r[r_data_statics][1] < ctx->points_l[l_data_statics - 1][1]))
 		{
 			//printf("\n如果左边比右边高了，左边等待右边\n");	
 			continue;//如果左边比右边高了，左边等待右边
 		}
-		if (dir_l[l_data_statics - 1] == 7
-			&& (points_r[r_data_statics][1] > points_l[l_data_statics - 1][1]))//左边比右边高且已经向下生长了
+		if (ctx->dir_l[l_data_statics - 1] == 7
+			&& (ctx->points_r[r_data_statics][1] > ctx->points_l[l_data_statics - 1][1]))//左边比右边高且已经向下生长了
 		{
 			// dir_l==7 表示记录了7，实际生长方向是seeds_l[0]={0,1}即向下
 			// 左线开始向下说明可能遇到十字路口或环岛，等待右边
 			//printf("\n左边开始向下了，等待右边，等待中... \n");
-			center_point_l[0] = points_l[l_data_statics - 1][0];//x
-			center_point_l[1] = points_l[l_data_statics - 1][1];//y
+			center_point_l[0] = ctx->points_l[l_data_statics - 1][0];//x
+			center_point_l[1] = ctx->points_l[l_data_statics - 1][1];//y
 			l_data_statics--;
 		}
 		r_data_statics++;//索引加一
@@ -367,8 +381,8 @@ void search_l_r(uint16_t break_flag, uint8_t(*image)[image_w], uint16_t *l_stast
 				index_r++;//索引加一
 				// 记录i（表示在i方向检测到黑色边界，实际生长方向是i+1）
 				// 例：记录3表示在右上(3)检测到黑色，实际向上(4)生长
-				dir_r[r_data_statics - 1] = (i);
-				//printf("dir[%d]:%d\n", r_data_statics - 1, dir_r[r_data_statics - 1]);
+				ctx->dir_r[r_data_statics - 1] = (i);
+				//printf("dir[%d]:%d\n", r_data_statics - 1, ctx->dir_r[r_data_statics - 1]);
 			}
 		}
 
@@ -397,186 +411,549 @@ void search_l_r(uint16_t break_flag, uint8_t(*image)[image_w], uint16_t *l_stast
 	*r_stastic = r_data_statics;
 
 }
+
 /*
-函数名称：void get_left(uint16 total_L)
-功能说明：从八邻域边界里提取需要的边线
+函数名称：void trace_border_reset(PipelineContext* ctx)
+功能说明：追踪开始前把左右边线置为丢线状态（左 border_min、右 border_max，丢线掩码全置位）
  */
-uint8_t l_border[image_h];//左线数组
-uint8_t r_border[image_h];//右线数组
-uint8_t center_line[image_h];//中线数组
-uint8_t left_lost[image_h];//左线丢失标志数组
-uint8_t right_lost[image_h];//右线丢失标志数组
-uint8_t last_left_lost_down=0;//记录左边下方最后一次左线丢失的位置 注意1这是由于局限的 这里主要是为了后续直线判断
-uint8_t last_right_lost_down=0;//记录右边下方最后一次右线丢失的位置  注意2这是索引 实际丢线行数值要再+1
-uint8_t last_left_lost_midstart=0;//记录中间段丢线开始位置
-uint8_t last_right_lost_midstart=0;//记录中间段丢线开始位置
-uint8_t last_left_lost_midend=0;//记录中间段丢线结束位置
-uint8_t last_right_lost_midend=0;//记录中间段丢线结束位置
-uint8_t last_left_lost_up=image_h-1;//记录左边上方最后一次左线丢失的位置
-uint8_t last_right_lost_up=image_h-1;//记录右边上方最后一次右线丢失的位置 注意3这是索引 实际丢线行数为image_h - last_right_lost_up
-uint8_t left_lost_num=image_h;//左线丢失总行数
-uint8_t right_lost_num=image_h;//右线丢失总行数
+// 边线与丢线掩码保存在 PipelineContext 中（字段说明见 pipeline_context.h）
+static void trace_border_reset(PipelineContext* ctx)
+{
+	memset(ctx->l_border, border_min, sizeof(ctx->l_border));
+	memset(ctx->r_border, border_max, sizeof(ctx->r_border));
+	border_lost_fill(&ctx->left_lost);
+	border_lost_fill(&ctx->right_lost);
+}
 
-#define max(a, b) ((a) > (b) ? (a) : (b))
+/*
+函数名称：void trace_border_fold_l/r(PipelineContext* ctx, uint16 j)
+功能说明：把第 j 个点并入边线（反转行号）：左线取该行最右边的点，右线取该行最左边的点，并清丢线位
+备    注：八邻域每确定一个点就调用一次，边线随追踪同步建好，不再二次遍历点集
+ */
+static inline void trace_border_fold_l(PipelineContext* ctx, uint16_t j)
+{
+	uint16_t row = image_h - 1 - ctx->points_l[j][1]; // 反转行号
+	uint16_t col = ctx->points_l[j][0];
+	if (row < image_h && col > ctx->l_border[row])
+	{
+		ctx->l_border[row] = col;
+		border_lost_clear(&ctx->left_lost, row);
+	}
+}
+
+static inline void trace_border_fold_r(PipelineContext* ctx, uint16_t j)
+{
+	uint16_t row = image_h - 1 - ctx->points_r[j][1]; // 反转行号
+	uint16_t col = ctx->points_r[j][0];
+	if (row < image_h && col < ctx->r_border[row])
+	{
+		ctx->r_border[row] = col;
+		border_lost_clear(&ctx->right_lost, row);
+	}
+}
 
-void get_left(uint16_t total_L)
+/*
+函数名称：void trace_border_from_points(PipelineContext* ctx, uint16 total_L, uint16 total_R)
+功能说明：由已有点集重建左右边线与丢线掩码（字节版 search_l_r、时间复用帧使用；位图追踪已在生长时同步建好）
+参数说明：total_L/total_R  左右点数
+example：trace_border_from_points(ctx, ctx->data_stastics_l, ctx->data_stastics_r);
+ */
+void trace_border_from_points(PipelineContext* ctx, uint16_t total_L, uint16_t total_R)
 {
 	uint16_t j;
-	left_lost_num=image_h;
-	last_left_lost_midstart=0;last_left_lost_midend=0;
-	//初始化左边界为最小值（丢线状态）
-	for (j = 0; j < image_h; j++)
+	trace_border_reset(ctx);
+	for (j = 0; j < total_L; j++) trace_border_fold_l(ctx, j);
+	for (j = 0; j < total_R; j++) trace_border_fold_r(ctx, j);
+}
+
+// ---------------- 位打包追踪前端 ----------------
+// 直接在形态学输出的位打包图上找起点与八邻域生长，免去追踪前的 0/255 解包和逐字节邻域读取。
+// 布局与 morph_binary_bitpacked 一致：每行 TRACE_WPR 个 word，bit0 对应每个 word 的最左像素，bit=1 为白（赛道）。
+// 行为与字节版 get_start_point/search_l_r 逐点一致（字节版保留作参考实现）。
+#define TRACE_WPR ((image_w + 31) >> 5)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TRACE_CTZ(x) __builtin_ctz(x)
+#define TRACE_CLZ(x) __builtin_clz(x)
+#else
+static inline int trace_ctz(uint32_t x) { int n = 0; while (!(x & 1u)) { x >>= 1; n++; } return n; }
+static inline int trace_clz(uint32_t x) { int n = 0; while (!(x & 0x80000000u)) { x <<= 1; n++; } return n; }
+#define TRACE_CTZ(x) trace_ctz(x)
+#define TRACE_CLZ(x) trace_clz(x)
+#endif
+
+// 八邻域方向表：下标为 8 位邻域掩码（bit k = seeds[k] 处是否为白，k 的顺序同 search_l_r 的 seeds_l），
+// 值为 0 表示邻域内没有黑→白跳变；否则 bit7=1，bit3..5 = 选中的邻域序号（跳变的白点中 y 最小的第一个），
+// bit0..2 = 写入 dir_l/dir_r 的记录值（最后一个跳变的黑点序号，即 +1 偏移约定）。
+// 左右两侧 seeds 的 y 偏移完全相同，右侧只需把邻域左右镜像后查同一张表。
+static const uint8_t s_trace_dir_table[256] = {
+	0x00, 0x87, 0x88, 0x87, 0x91, 0x97, 0x88, 0x87, 0x9A, 0x9F, 0x9A, 0x9F, 0x91, 0x97, 0x88, 0x87,
+	0xA3, 0xA7, 0xA3, 0xA7, 0xA3, 0xA7, 0xA3, 0xA7, 0x9A, 0x9F, 0x9A, 0x9F, 0x91, 0x97, 0x88, 0x87,
+	0xAC, 0xAF, 0xAC, 0xAF, 0xAC, 0xAF, 0xAC, 0xAF, 0x9C, 0x9F, 0x9C, 0x9F, 0xAC, 0xAF, 0xAC, 0xAF,
+	0xA3, 0xA7, 0xA3, 0xA7, 0xA3, 0xA7, 0xA3, 0xA7, 0x9A, 0x9F, 0x9A, 0x9F, 0x91, 0x97, 0x88, 0x87,
+	0xB5, 0xB7, 0xB5, 0xB7, 0x95, 0x97, 0xB5, 0xB7, 0x9D, 0x9F, 0x9D, 0x9F, 0x95, 0x97, 0xB5, 0xB7,
+	0xA5, 0xA7, 0xA5, 0xA7, 0xA5, 0xA7, 0xA5, 0xA7, 0x9D, 0x9F, 0x9D, 0x9F, 0x95, 0x97, 0xB5, 0xB7,
+	0xAC, 0xAF, 0xAC, 0xAF, 0xAC, 0xAF, 0xAC, 0xAF, 0x9C, 0x9F, 0x9C, 0x9F, 0xAC, 0xAF, 0xAC, 0xAF,
+	0xA3, 0xA7, 0xA3, 0xA7, 0xA3, 0xA7, 0xA3, 0xA7, 0x9A, 0x9F, 0x9A, 0x9F, 0x91, 0x97, 0x88, 0x87,
+	0xBE, 0xBE, 0x8E, 0xBE, 0x96, 0x96, 0x8E, 0xBE, 0x9E, 0x9E, 0x9E, 0x9E, 0x96, 0x96, 0x8E, 0xBE,
+	0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0x9E, 0x9E, 0x9E, 0x9E, 0x96, 0x96, 0x8E, 0xBE,
+	0xAE, 0xAE, 0xAE, 0xAE, 0xAE, 0xAE, 0xAE, 0xAE, 0x9E, 0x9E, 0x9E, 0x9E, 0xAE, 0xAE, 0xAE, 0xAE,
+	0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0x9E, 0x9E, 0x9E, 0x9E, 0x96, 0x96, 0x8E, 0xBE,
+	0xB5, 0xB5, 0xB5, 0xB5, 0x95, 0x95, 0xB5, 0xB5, 0x9D, 0x9D, 0x9D, 0x9D, 0x95, 0x95, 0xB5, 0xB5,
+	0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0x9D, 0x9D, 0x9D, 0x9D, 0x95, 0x95, 0xB5, 0xB5,
+	0xAC, 0xAC, 0xAC, 0xAC, 0xAC, 0xAC, 0xAC, 0xAC, 0x9C, 0x9C, 0x9C, 0x9C, 0xAC, 0xAC, 0xAC, 0xAC,
+	0xA3, 0xA3, 0xA3, 0xA3, 0xA3, 0xA3, 0xA3, 0xA3, 0x9A, 0x9A, 0x9A, 0x9A, 0x91, 0x91, 0x88, 0x00,
+};
+
+static const int8_t s_trace_seeds_l[8][2] = { {0,  1},{-1,1},{-1,0},{-1,-1},{0,-1},{1,-1},{1,  0},{1, 1}, };
+static const int8_t s_trace_seeds_r[8][2] = { {0,  1},{1,1},{1,0}, {1,-1},{0,-1},{-1,-1}, {-1,  0},{-1, 1}, };
+static const uint8_t s_trace_rev3[8] = { 0, 4, 2, 6, 1, 5, 3, 7 }; // 3 位左右镜像
+
+// 取 (x-1, x, x+1) 三个像素（bit0 = x-1）；图像外（含第 image_h 行）视为黑
+static inline uint32_t trace_triple(const uint32_t* bits, int x, int y)
+{
+	const uint32_t* row;
+	uint64_t v;
+	int s, w;
+	if ((unsigned)y >= image_h) return 0;
+	row = bits + y * TRACE_WPR;
+	if (x <= 0) return (row[0] & 3u) << 1; // x=0：左侧邻点在图外
+	s = x - 1;
+	w = s >> 5;
+	v = row[w];
+	if (w + 1 < TRACE_WPR) v |= (uint64_t)row[w + 1] << 32;
+	return (uint32_t)(v >> (s & 31)) & 7u;
+}
+
+// 把 3×3 邻域收拢成 seeds_l 顺序的 8 位掩码；mirror=1 时按 seeds_r（左右镜像）顺序
+static inline uint8_t trace_neighbour_mask(const uint32_t* bits, int x, int y, int mirror)
+{
+	uint32_t t = trace_triple(bits, x, y - 1);
+	uint32_t m = trace_triple(bits, x, y);
+	uint32_t b = trace_triple(bits, x, y + 1);
+	if (mirror)
 	{
-		l_border[j] = border_min;
-		left_lost[j] = 1;  // 丢线标志
+		t = s_trace_rev3[t];
+		m = s_trace_rev3[m];
+		b = s_trace_rev3[b];
 	}
+	return (uint8_t)(((b >> 1) & 1u)        // 0:下
+		| ((b & 1u) << 1)                   // 1:左下
+		| ((m & 1u) << 2)                   // 2:左
+		| (t << 3)                          // 3:左上 4:上 5:右上
+		| (((m >> 2) & 1u) << 6)            // 6:右
+		| (((b >> 2) & 1u) << 7));          // 7:右下
+}
 
-	// 遍历所有找到的点，更新l_border数组（过程中反转行号）
-	for (j = 0; j < total_L; j++)
+/*
+函数名称：void image_draw_rectan_bits(uint32* bits)
+功能说明：位打包版画黑框，与 image_draw_rectan 一致（左右各 1 列、上边 1 行）
+参数说明：bits	位打包图像（image_h 行 × TRACE_WPR word）
+函数返回：无
+备    注：
+example： image_draw_rectan_bits(ctx->morph_out);
+ */
+void image_draw_rectan_bits(uint32_t* bits)
+{
+	uint8_t i = 0;
+	for (i = 0; i < image_h; i++)
 	{
-		uint16_t row = image_h - 1 - points_l[j][1]; // 反转行号
-		uint16_t col = points_l[j][0];
-		if (row < image_h) // 确保行号在范围内 其实没必要
-		{	
-			// 若非丢线 取该行最右边的左边界点
-			if (col > l_border[row])
-			{
-				// 只在第一次找到该行边界时减少丢线计数
-				if (left_lost[row] == 1) {
-					left_lost_num--;
-				}
-				l_border[row] = col;
-				left_lost[row] = 0;
-			}
-		}
+		bits[i * TRACE_WPR] &= ~1u;                                               // 最左边
+		bits[i * TRACE_WPR + ((image_w - 1) >> 5)] &= ~(1u << ((image_w - 1) & 31)); // 最右边
 	}
+	memset(bits, 0, TRACE_WPR * sizeof(uint32_t)); // 最上面
+}
 
-	//从下往上找丢线
-	for(uint8_t row=0;row<image_h;row++){
-		if(left_lost[row]==1&&left_lost[row+1]==0/*&&left_lost[row+2]==0*/)
+/*
+函数名称：uint8 get_start_point_bits(PipelineContext* ctx, const uint32* bits, uint8 start_row)
+功能说明：位打包版寻找起点，结果（含未找到时的取值）与 get_start_point 相同
+参数说明：bits 位打包图像；start_row 搜索行
+函数返回：左右起点都找到返回 1，否则返回 0
+备    注：左边找 [border_min, image_w/2] 内最右的“白且左邻为黑”（clz），右边找 [image_w/2, border_max] 内最左的“白且右邻为黑”（ctz）
+example： get_start_point_bits(ctx, ctx->morph_out, image_h-3)
+ */
+uint8_t get_start_point_bits(PipelineContext* ctx, const uint32_t* bits, uint8_t start_row)
+{
+	const uint32_t* row = bits + start_row * TRACE_WPR;
+	uint8_t l_found = 0, r_found = 0;
+	int w;
+
+	//未找到时与字节版循环结束时的取值一致
+	ctx->start_point_l[0] = border_min;
+	ctx->start_point_l[1] = start_row;
+	ctx->start_point_r[0] = border_max;
+	ctx->start_point_r[1] = start_row;
+
+	//从中间往左边：edge = 白 & ~左邻
+	for (w = (image_w / 2) >> 5; w >= 0; w--)
+	{
+		uint32_t left = (row[w] << 1) | (w > 0 ? row[w - 1] >> 31 : 0u);
+		uint32_t edge = row[w] & ~left;
+		int lo = border_min - (w << 5), hi = image_w / 2 - (w << 5);
+		if (hi < 31) edge &= (2u << hi) - 1u;
+		if (lo > 0) edge &= ~((1u << lo) - 1u);
+		if (edge)
 		{
-			last_left_lost_down=row;
+			ctx->start_point_l[0] = (uint8_t)((w << 5) + 31 - TRACE_CLZ(edge));
+			l_found = 1;
 			break;
 		}
 	}
-	//从上往下找丢线
-	for(int8_t row=image_h-1;row>=0;row--){
-		if(left_lost[row]==1&&left_lost[row-1]==0/*&&left_lost[row-2]==0*/)
+
+	//从中间往右边：edge = 白 & ~右邻
+	for (w = (image_w / 2) >> 5; w <= (border_max) >> 5; w++)
+	{
+		uint32_t right = (row[w] >> 1) | (w + 1 < TRACE_WPR ? row[w + 1] << 31 : 0u);
+		uint32_t edge = row[w] & ~right;
+		int lo = image_w / 2 - (w << 5), hi = border_max - (w << 5);
+		if (hi < 31) edge &= (2u << hi) - 1u;
+		if (lo > 0) edge &= ~((1u << lo) - 1u);
+		if (edge)
 		{
-			last_left_lost_up=row;
+			ctx->start_point_r[0] = (uint8_t)((w << 5) + TRACE_CTZ(edge));
+			r_found = 1;
 			break;
 		}
 	}
-	uint8_t temp_lost_num=image_h - last_left_lost_up+last_left_lost_down+1;//这是上加下丢线总行数 总是小于等于left_lost_num 中间段不丢线时取等
-	//判断是否还有一段丢线
-	if(left_lost_num-temp_lost_num>=3)// 这里3为了抗噪
+
+	return (l_found && r_found) ? 1 : 0;
+}
+
+/*
+函数名称：void search_l_r_bits(PipelineContext* ctx, uint16 break_flag, const uint32* bits, ...)
+功能说明：位打包版八邻域，参数与 search_l_r 相同（图像换成位打包图），结果逐点一致
+备    注：每步把中心点的 3×3 邻域收拢成 8 位掩码，查 s_trace_dir_table 得到生长方向与 dir 记录值；
+         确定下来的点同步并入 l_border/r_border 与丢线掩码（结果与追踪后再遍历点集相同）
+example：
+	search_l_r_bits(ctx, (uint16)USE_num, ctx->morph_out, &ctx->data_stastics_l, &ctx->data_stastics_r, ctx->start_point_l[0],
+				ctx->start_point_l[1], ctx->start_point_r[0], ctx->start_point_r[1], &ctx->hightest);
+ */
+void search_l_r_bits(PipelineContext* ctx, uint16_t break_flag, const uint32_t* bits, uint16_t *l_stastic, uint16_t *r_stastic, uint8_t l_start_x, uint8_t l_start_y, uint8_t r_start_x, uint8_t r_start_y, uint8_t *hightest)
+{
+	trace_step from;
+	from.l = *l_stastic;
+	from.r = *r_stastic;
+	from.cl[0] = l_start_x;
+	from.cl[1] = l_start_y;
+	from.cr[0] = r_start_x;
+	from.cr[1] = r_start_y;
+	search_l_r_bits_run(ctx, break_flag, bits, &from, NULL, l_stastic, r_stastic, hightest);
+}
+
+/*
+函数名称：uint16 search_l_r_bits_run(PipelineContext* ctx, uint16 break_flag, const uint32* bits, const trace_step* from, trace_step* steps, ...)
+功能说明：八邻域主循环：从状态 from 开始最多再走 break_flag 步
+参数说明：steps 非 NULL 时把每一步开始时的状态依次写入 steps[0..]（时域复用记录，调用方按已走步数偏移）
+函数返回：本次执行的步数
+备    注：边线在开始时复位，from 之前的点在第一步并入（与从头追踪时逐步并入结果相同）
+ */
+static uint16_t search_l_r_bits_run(PipelineContext* ctx, uint16_t break_flag, const uint32_t* bits, const trace_step* from, trace_step* steps, uint16_t *l_stastic, uint16_t *r_stastic, uint8_t *hightest)
+{
+	uint8_t center_point_l[2];
+	uint8_t center_point_r[2];
+	uint16_t l_data_statics = from->l;
+	uint16_t r_data_statics = from->r;
+	uint16_t l_folded = 0, r_folded = 0; // 已并入边线的点数
+	uint16_t n = 0;                      // 已执行的步数
+	uint8_t e;
+
+	center_point_l[0] = from->cl[0];
+	center_point_l[1] = from->cl[1];
+	center_point_r[0] = from->cr[0];
+	center_point_r[1] = from->cr[1];
+	trace_border_reset(ctx);
+
+	while (break_flag--)
 	{
-		//如果有中间段 从上往下看 因为下面两个角落经常糊
-		for(uint8_t row=last_left_lost_up-2;row>=last_left_lost_down+2;row--)
+		STAGE_TIMING_TRACE_STEP(&ctx->timing);
+		if (steps)
 		{
-			if(left_lost[row]==1&&left_lost[row+1]==0&&/*left_lost[row+2]==0&&*/last_left_lost_midend==0)
-			{
-				last_left_lost_midend=row;
-			}
-			if(left_lost[row]==1&&left_lost[row-1]==0&&/*left_lost[row-2]==0&&*/last_left_lost_midstart==0)
-			{
-				last_left_lost_midstart=row;
-				break;
-			}
+			steps[n].l = l_data_statics;
+			steps[n].r = r_data_statics;
+			steps[n].cl[0] = center_point_l[0];
+			steps[n].cl[1] = center_point_l[1];
+			steps[n].cr[0] = center_point_r[0];
+			steps[n].cr[1] = center_point_r[1];
+		}
+		n++;
+		// 上一步留下的点已经确定（回退只撤销本步刚压入的左点），随即并入边线与丢线掩码
+		while (l_folded < l_data_statics) trace_border_fold_l(ctx, l_folded++);
+		while (r_folded < r_data_statics) trace_border_fold_r(ctx, r_folded++);
+
+		ctx->points_l[l_data_statics][0] = center_point_l[0];
+		ctx->points_l[l_data_statics][1] = center_point_l[1];
+		l_data_statics++;
+
+		ctx->points_r[r_data_statics][0] = center_point_r[0];
+		ctx->points_r[r_data_statics][1] = center_point_r[1];
+
+		//左边判断
+		e = s_trace_dir_table[trace_neighbour_mask(bits, center_point_l[0], center_point_l[1], 0)];
+		if (e)
+		{
+			ctx->dir_l[l_data_statics - 1] = e & 7;
+			center_point_l[0] = (uint8_t)(center_point_l[0] + s_trace_seeds_l[(e >> 3) & 7][0]);
+			center_point_l[1] = (uint8_t)(center_point_l[1] + s_trace_seeds_l[(e >> 3) & 7][1]);
+		}
+
+		//退出/等待条件与 search_l_r 完全相同
+		if ((r_data_statics >= 2 && ctx->points_r[r_data_statics][0] == ctx->points_r[r_data_statics-1][0] && ctx->points_r[r_data_statics][0] == ctx->points_r[r_data_statics - 2][0]
+            && ctx->points_r[r_data_statics][1] == ctx->points_r[r_data_statics - 1][1] && ctx->points_r[r_data_statics][1] == ctx->points_r[r_data_statics - 2][1])
+            || (l_data_statics >= 3 && ctx->points_l[l_data_statics-1][0] == ctx->points_l[l_data_statics - 2][0] && ctx->points_l[l_data_statics-1][0] == ctx->points_l[l_data_statics - 3][0]
+                && ctx->points_l[l_data_statics-1][1] == ctx->points_l[l_data_statics - 2][1] && ctx->points_l[l_data_statics-1][1] == ctx->points_l[l_data_statics - 3][1]))
+		{
+			break;
+		}
+		if (my_abs(ctx->points_r[r_data_statics][0] - ctx->points_l[l_data_statics - 1][0]) < 2
+			&& my_abs(ctx->points_r[r_data_statics][1] - ctx->points_l[l_data_statics - 1][1]) < 2
+			)
+		{
+			*hightest = (ctx->points_r[r_data_statics][1] + ctx->points_l[l_data_statics - 1][1]) >> 1;//取出最高点
+			break;
+		}
+		if ((ctx->points_r[r_data_statics][1] < ctx->points_l[l_data_statics - 1][1]))
+		{
+			continue;//如果左边比右边高了，左边等待右边
+		}
+		if (ctx->dir_l[l_data_statics - 1] == 7
+			&& (ctx->points_r[r_data_statics][1] > ctx->points_l[l_data_statics - 1][1]))//左边比右边高且已经向下生长了
+		{
+			center_point_l[0] = ctx->points_l[l_data_statics - 1][0];
+			center_point_l[1] = ctx->points_l[l_data_statics - 1][1];
+			l_data_statics--;
+		}
+		r_data_statics++;
+
+		//右边判断（邻域镜像后查同一张表）
+		e = s_trace_dir_table[trace_neighbour_mask(bits, center_point_r[0], center_point_r[1], 1)];
+		if (e)
+		{
+			ctx->dir_r[r_data_statics - 1] = e & 7;
+			center_point_r[0] = (uint8_t)(center_point_r[0] + s_trace_seeds_r[(e >> 3) & 7][0]);
+			center_point_r[1] = (uint8_t)(center_point_r[1] + s_trace_seeds_r[(e >> 3) & 7][1]);
 		}
 	}
-    // 角落糊了还是没办法 手动补一下
-	if(last_left_lost_midstart<=10&&last_left_lost_midstart!=0)
+	while (l_folded < l_data_statics) trace_border_fold_l(ctx, l_folded++);
+	while (r_folded < r_data_statics) trace_border_fold_r(ctx, r_folded++);
+
+	*l_stastic = l_data_statics;
+	*r_stastic = r_data_statics;
+	return n;
+}
+// ---------------- 时域复用 ----------------
+// 把 [x0,x1] 行内区间（自动裁剪到图内）标进掩码：按 word 整段置位，不逐像素循环
+static void temporal_mark(uint32_t* corridor, int x0, int x1, int y)
+{
+	uint32_t* row;
+	int w0, w1, w;
+	if ((unsigned)y >= image_h) return;
+	if (x0 < 0) x0 = 0;
+	if (x1 > image_w - 1) x1 = image_w - 1;
+	if (x0 > x1) return;
+	row = corridor + y * TRACE_WPR;
+	w0 = x0 >> 5;
+	w1 = x1 >> 5;
+	if (w0 == w1)
 	{
-		last_left_lost_midstart=0;
-		last_left_lost_down=last_left_lost_midend;
-		last_left_lost_midend=0;
+		row[w0] |= (0xFFFFFFFFu >> (31 - (x1 & 31))) & (0xFFFFFFFFu << (x0 & 31));
+		return;
 	}
+	row[w0] |= 0xFFFFFFFFu << (x0 & 31);
+	for (w = w0 + 1; w < w1; w++) row[w] = 0xFFFFFFFFu;
+	row[w1] |= 0xFFFFFFFFu >> (31 - (x1 & 31));
 }
-/*
-函数名称：void get_right(uint16 total_R)
-功能说明：从八邻域边界里提取需要的边线
-参数说明：
-total_R  ：找到的点的总数
-函数返回：无
-修改时间：2022年9月25日
-备    注：
-example：get_right(data_stastics_r);
- */
-void get_right(uint16_t total_R)
+
+// 本帧与上一帧的差异按 3×3 膨胀：bit=1 表示以该像素为中心的邻域内有像素变化（八邻域一步读的正是这 9 个像素）
+static void temporal_diff_dilate(const uint32_t* bits, const uint32_t* prev, uint32_t* out)
 {
-	uint16_t j;
-	right_lost_num=image_h;
-	last_right_lost_midstart=0;last_right_lost_midend=0;
-	//初始化右边界为最大值（丢线状态）
-	for (j = 0; j < image_h; j++)
+	uint32_t h[PIPELINE_MORPH_WORDS];
+	int y, w, i;
+	for (y = 0; y < image_h; y++)
+	{
+		const int base = y * TRACE_WPR;
+		uint32_t left = 0, cur = bits[base] ^ prev[base];
+		for (w = 0; w < TRACE_WPR; w++)
+		{
+			uint32_t next = w + 1 < TRACE_WPR ? bits[base + w + 1] ^ prev[base + w + 1] : 0u;
+			h[base + w] = cur | (cur << 1) | (left >> 31) | (cur >> 1) | (next << 31);
+			left = cur;
+			cur = next;
+		}
+	}
+	for (i = 0; i < PIPELINE_MORPH_WORDS; i++)
 	{
-		r_border[j] = border_max;
-		right_lost[j] = 1;  // 丢线标志
+		uint32_t up = i >= TRACE_WPR ? h[i - TRACE_WPR] : 0u;
+		uint32_t down = i + TRACE_WPR < PIPELINE_MORPH_WORDS ? h[i + TRACE_WPR] : 0u;
+		out[i] = up | h[i] | down;
 	}
+}
 
-	// 遍历所有找到的点，更新r_border数组（过程中反转行号）
-	for (j = 0; j < total_R; j++)
+// 以 p 为中心的 3×3 邻域是否有变化；中心不在图内时按有变化处理
+static inline int temporal_changed(const uint32_t* diff, const uint8_t p[2])
+{
+	if (p[0] >= image_w || p[1] >= image_h) return 1;
+	return (int)((diff[p[1] * TRACE_WPR + (p[0] >> 5)] >> (p[0] & 31)) & 1u);
+}
+
+/*
+函数名称：uint8 trace_temporal_start_unchanged(const PipelineContext* ctx, const uint32* bits)
+功能说明：上一帧找起点读过的行段在本帧是否没有变化（没有变化则起点与是否找到都与上一帧相同）
+参数说明：bits 本帧位图（上一帧的在 ctx->temporal_prev）
+函数返回：没有变化返回 1
+备    注：未找到起点的行按整段 [border_min-1, border_max+1] 比较（取超集，不影响正确性）；
+         找到起点的行只比较从中间到起点（含其外侧邻点）的区间
+example： if (trace_temporal_start_unchanged(ctx, ctx->morph_out)) ...
+ */
+static uint8_t trace_temporal_start_unchanged(const PipelineContext* ctx, const uint32_t* bits)
+{
+	uint32_t m[TRACE_WPR];
+	int last_row = ctx->start_point_l[1];
+	int row, w;
+	for (row = image_h - 3; row >= last_row; row -= 2)
 	{
-		uint16_t row = image_h - 1 - points_r[j][1]; // 反转行号
-		uint16_t col = points_r[j][0];
-		if (row < image_h) // 确保行号在范围内
+		memset(m, 0, sizeof(m));
+		if (row == last_row && ctx->temporal_found)
 		{
-			// 若非丢线 取该行最左边的右边界点
-			if (col < r_border[row])
-			{
-				// 只在第一次找到该行边界时减少丢线计数
-				if (right_lost[row] == 1) {
-					right_lost_num--;
-				}
-				r_border[row] = col;
-				right_lost[row] = 0;
-			}
+			temporal_mark(m, ctx->start_point_l[0] - 1, image_w / 2, 0);
+			temporal_mark(m, image_w / 2, ctx->start_point_r[0] + 1, 0);
 		}
-	}
-	//从下往上找丢线
-	for(uint8_t row=0;row<image_h;row++){
-		if(right_lost[row]==1&&right_lost[row+1]==0/*&&right_lost[row+2]==0*/)
+		else
 		{
-			last_right_lost_down=row;
-			break;
+			temporal_mark(m, border_min - 1, border_max + 1, 0);
+		}
+		for (w = 0; w < TRACE_WPR; w++)
+		{
+			if ((bits[row * TRACE_WPR + w] ^ ctx->temporal_prev[row * TRACE_WPR + w]) & m[w]) return 0;
 		}
 	}
-	//从上往下找丢线
-	for(uint8_t row=image_h-1;row>=0;row--){
-		if(right_lost[row]==1&&right_lost[row-1]==0/*&&right_lost[row-2]==0*/)
+	return 1;
+}
+
+/*
+函数名称：void trace_temporal_search(PipelineContext* ctx, const uint32* bits, uint8 same_start)
+功能说明：时域复用版八邻域（起点已找到）：沿用上一帧邻域没变的前缀步，从第一个变化的步接着正常追踪
+参数说明：bits 本帧位图；same_start 起点与上一帧相同（且上一帧找到了起点）
+函数返回：无
+备    注：第 t 步读的只有左右中心点的 3×3 邻域，前 t 步都没变时第 t 步开始的状态（点数、中心点）
+         与上一帧相同，点集与生长方向的前缀也还在 ctx 中，从这里接着走与从头追踪逐点一致；
+         起点不同时从头追踪。每次追踪都重新记录步状态，供下一帧使用
+example： trace_temporal_search(ctx, ctx->morph_out, same_start);
+ */
+static void trace_temporal_search(PipelineContext* ctx, const uint32_t* bits, uint8_t same_start)
+{
+	uint32_t diff[PIPELINE_MORPH_WORDS];
+	trace_step from;
+	uint16_t t = 0, n = ctx->temporal_nsteps;
+	if (same_start)
+	{
+		temporal_diff_dilate(bits, ctx->temporal_prev, diff);
+		while (t < n && !temporal_changed(diff, ctx->temporal_steps[t].cl) && !temporal_changed(diff, ctx->temporal_steps[t].cr)) t++;
+		if (t == n)
 		{
-			last_right_lost_up=row;
-			break;
+			//每一步读到的邻域都没变：点集、生长方向、计数、最高行都与上一帧相同，只需重建边线（已被十字补线改写）
+			trace_border_from_points(ctx, ctx->data_stastics_l, ctx->data_stastics_r);
+			ctx->temporal_hits++;
+			ctx->temporal_steps_reused += n;
+			return;
 		}
 	}
-	uint8_t temp_lost_num=image_h - last_right_lost_up+last_right_lost_down+1;//这是上加下丢线总行数 总是小于等于right_lost_num 中间段不丢线时取等
+	if (t)
+	{
+		from = ctx->temporal_steps[t];
+		ctx->temporal_partial++;
+		ctx->temporal_steps_reused += t;
+	}
+	else
+	{
+		from.l = 0;
+		from.r = 0;
+		from.cl[0] = ctx->start_point_l[0];
+		from.cl[1] = ctx->start_point_l[1];
+		from.cr[0] = ctx->start_point_r[0];
+		from.cr[1] = ctx->start_point_r[1];
+		ctx->temporal_misses++;
+	}
+	n = search_l_r_bits_run(ctx, (uint16_t)(USE_num - t), bits, &from, ctx->temporal_steps + t, &ctx->data_stastics_l, &ctx->data_stastics_r, &ctx->hightest);
+	ctx->temporal_steps_traced += n;
+	ctx->temporal_nsteps = (uint16_t)(t + n);
+}
+
+// last_*_lost_* 位置保存在 PipelineContext 中（字段说明见 pipeline_context.h）
+
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+/*
+函数名称：void lost_segments(const border_lost_mask* lost, ...)
+功能说明：由丢线掩码求丢线总行数与下/上/中间段丢线位置（左右两边共用）
+参数说明：lost 丢线掩码；其余为输出（down/up 找不到时保持原值，与逐行扫描版一致）
+备    注：down = 从下往上第一个“本行丢、上一行不丢”的行（ctz）；
+         up   = 从上往下第一个“本行丢、下一行不丢”的行（clz）；
+         中间段只在 [down+2, up-2] 内从上往下找：midstart 为最高的段底，midend 为不低于它的最高段顶
+ */
+static void lost_segments(const border_lost_mask* lost, uint8_t* lost_num, uint8_t* down, uint8_t* up,
+                          uint8_t* midstart, uint8_t* midend)
+{
+	border_lost_mask tops = border_lost_segment_tops(lost);
+	border_lost_mask bottoms = border_lost_segment_bottoms(lost);
+	int row;
+
+	*lost_num = (uint8_t)border_lost_count(lost, 0, image_h);
+	*midstart = 0;
+	*midend = 0;
+	//从下往上找丢线
+	row = border_lost_lowest(&tops);
+	if (row >= 0) *down = (uint8_t)row;
+	//从上往下找丢线
+	row = border_lost_highest(&bottoms);
+	if (row >= 0) *up = (uint8_t)row;
+
+	uint8_t temp_lost_num = image_h - *up + *down + 1;//这是上加下丢线总行数 总是小于等于lost_num 中间段不丢线时取等
 	//判断是否还有一段丢线
-	if(right_lost_num-temp_lost_num>=3)// 这里3为了抗噪
+	if (*lost_num - temp_lost_num >= 3)// 这里3为了抗噪
 	{
-		//如果有中间段 从上往下找 因为下面两个角落经常糊
-		for(uint8_t row=last_right_lost_up-2;row>=last_right_lost_down+2;row--)
+		//如果有中间段 从上往下看 因为下面两个角落经常糊
+		int lo = *down + 2, hi = *up - 2;
+		if (hi >= lo)
 		{
-			if(right_lost[row]==1&&right_lost[row+1]==0&&/*right_lost[row+2]==0&&*/last_right_lost_midend==0)
+			border_lost_mask mid_bottoms = border_lost_range(&bottoms, lo, hi + 1);
+			border_lost_mask mid_tops = border_lost_range(&tops, lo, hi + 1);
+			int ms = border_lost_highest(&mid_bottoms);
+			int me;
+			if (ms >= 0)
 			{
-				last_right_lost_midend=row;
-			}
-			if(right_lost[row]==1&&right_lost[row-1]==0&&/*right_lost[row-2]==0&&*/last_right_lost_midstart==0)
-			{
-				last_right_lost_midstart=row;
-				break;
+				*midstart = (uint8_t)ms;
+				mid_tops = border_lost_range(&mid_tops, ms, hi + 1);
 			}
+			me = border_lost_highest(&mid_tops);
+			if (me >= 0) *midend = (uint8_t)me;
 		}
 	}
 	// 角落糊了还是没办法 手动补一下
-	if(last_right_lost_midstart<=10&&last_right_lost_midstart!=0)
+	if (*midstart <= 10 && *midstart != 0)
 	{
-		last_right_lost_midstart=0;
-		last_right_lost_down=last_right_lost_midend;
-		last_right_lost_midend=0;
+		*midstart = 0;
+		*down = *midend;
+		*midend = 0;
 	}
 }
 
+/*
+函数名称：void get_lost_lines(PipelineContext* ctx)
+功能说明：左右两边的丢线分析（边线与丢线掩码已由追踪建好）
+参数说明：无
+函数返回：无
+修改时间：2022年9月25日
+备    注：
+example：get_lost_lines(ctx);
+ */
+void get_lost_lines(PipelineContext* ctx)
+{
+	lost_segments(&ctx->left_lost, &ctx->left_lost_num, &ctx->last_left_lost_down, &ctx->last_left_lost_up,
+	              &ctx->last_left_lost_midstart, &ctx->last_left_lost_midend);
+	lost_segments(&ctx->right_lost, &ctx->right_lost_num, &ctx->last_right_lost_down, &ctx->last_right_lost_up,
+	              &ctx->last_right_lost_midstart, &ctx->last_right_lost_midend);
+}
+
 /*
 函数名称：void image_draw_rectan(uint8(*image)[image_w])
 功能说明：给图像画一个黑框（1像素宽）
@@ -605,63 +982,44 @@ void image_draw_rectan(uint8_t(*image)[image_w])
 }
 
 /*绘制边界线(横向去重)
-void draw_edge()
+void draw_edge(PipelineContext* ctx, uint8_t(*image)[image_w])
 {
 	int row=0;
 	for(row=0;row<120;row++)
     {
-		imo[119-row][l_border[row]]=1;
-		imo[119-row][r_border[row]]=2;
-		imo[119-row][center_line[row]]=3;
+		image[119-row][ctx->l_border[row]]=1;
+		image[119-row][ctx->r_border[row]]=2;
+		image[119-row][ctx->center_line[row]]=3;
 	}
 }
 */
 
-//绘制边界线(完全体)
-void draw_edge()
+//生成标注显示列表：八邻域点、中线与左右边线、拐点 3×3（顺序即原 draw_edge 的绘制顺序）
+void draw_edge_list(PipelineContext* ctx, overlay_list* l)
 {
-    // 显示左边界
-    for (int i = 0; i < data_stastics_l; i++) {
-        int row = points_l[i][1];
-        int col = points_l[i][0];
-        imo[row][col] = 1; // 左边界点标记为1
-    }
-    // 显示右边界
-    for (int i = 0; i < data_stastics_r; i++) {
-        int row = points_r[i][1];
-        int col = points_r[i][0];
-        imo[row][col] = 2; // 右边界点标记为2
-    }
-    // 显示中线
-    for (int row = 0; row < image_h; row++) {
-		// 这里y索引要颠倒 因为最终左、右、中线是从底部向上 而imo是从顶部向下
-        imo[image_h-1-row][center_line[row]] = 3;
-		imo[image_h-1-row][l_border[row]] = 4;
-		imo[image_h-1-row][r_border[row]] = 5;
+	overlay_clear(l);
+	overlay_add_points(l, OVERLAY_COLOR_LEFT_POINTS, (const uint16_t (*)[2])ctx->points_l, ctx->data_stastics_l);
+	overlay_add_points(l, OVERLAY_COLOR_RIGHT_POINTS, (const uint16_t (*)[2])ctx->points_r, ctx->data_stastics_r);
+	// 中线、左右边线逐行画（y 索引颠倒：边线从底部向上，imo 从顶部向下）
+	overlay_add_row_line(l, OVERLAY_COLOR_CENTER, ctx->center_line);
+	overlay_add_row_line(l, OVERLAY_COLOR_LEFT_BORDER, ctx->l_border);
+	overlay_add_row_line(l, OVERLAY_COLOR_RIGHT_BORDER, ctx->r_border);
+	// 拐点及其周围的3x3区域（未检测到时坐标为 0，越界部分在绘制时丢弃，与原来一致）
+	overlay_add_marker(l, OVERLAY_COLOR_CORNER, ctx->firstcorner_pos[0], image_h - 1 - ctx->firstcorner_pos[1]);
+	overlay_add_marker(l, OVERLAY_COLOR_CORNER_FILTERED, ctx->firstcorner_pos_filtered[0], image_h - 1 - ctx->firstcorner_pos_filtered[1]);
+}
 
-    }
-	// 显示拐点及其周围的3x3区域
-	for(int i=0;i<9;i++)
-	{
-		imo[image_h-firstcorner_pos[1]][firstcorner_pos[0]] = 6;
-		imo[image_h-1-firstcorner_pos[1]][firstcorner_pos[0]] = 6;
-		imo[image_h-2-firstcorner_pos[1]][firstcorner_pos[0]] = 6;
-	    imo[image_h-firstcorner_pos[1]][firstcorner_pos[0]+1] = 6;
-		imo[image_h-1-firstcorner_pos[1]][firstcorner_pos[0]+1] = 6;
-		imo[image_h-2-firstcorner_pos[1]][firstcorner_pos[0]+1] = 6;
-        imo[image_h-firstcorner_pos[1]][firstcorner_pos[0]-1] = 6;
-		imo[image_h-1-firstcorner_pos[1]][firstcorner_pos[0]-1] = 6;
-		imo[image_h-2-firstcorner_pos[1]][firstcorner_pos[0]-1] = 6;
-	    imo[image_h-firstcorner_pos_filtered[1]][firstcorner_pos_filtered[0]] = 7;
-		imo[image_h-1-firstcorner_pos_filtered[1]][firstcorner_pos_filtered[0]] = 7;
-		imo[image_h-2-firstcorner_pos_filtered[1]][firstcorner_pos_filtered[0]] = 7;
-	    imo[image_h-firstcorner_pos_filtered[1]][firstcorner_pos_filtered[0]+1] = 7;
-		imo[image_h-1-firstcorner_pos_filtered[1]][firstcorner_pos_filtered[0]+1] = 7;
-		imo[image_h-2-firstcorner_pos_filtered[1]][firstcorner_pos_filtered[0]+1] = 7;
-        imo[image_h-firstcorner_pos_filtered[1]][firstcorner_pos_filtered[0]-1] = 7;
-		imo[image_h-1-firstcorner_pos_filtered[1]][firstcorner_pos_filtered[0]-1] = 7;
-		imo[image_h-2-firstcorner_pos_filtered[1]][firstcorner_pos_filtered[0]-1] = 7;
-	}
+//绘制边界线(完全体)，输出行跨度为 stride 字节；显示列表同时保存在 ctx->overlay
+void draw_edge_stride(PipelineContext* ctx, uint8_t* out, int stride)
+{
+	draw_edge_list(ctx, &ctx->overlay);
+	overlay_paint_indices(&ctx->overlay, out, stride);
+}
+
+//绘制边界线（image_w 连续布局）
+void draw_edge(PipelineContext* ctx, uint8_t(*image)[image_w])
+{
+	draw_edge_stride(ctx, image[0], image_w);
 }
 
 
@@ -692,7 +1050,7 @@ match_result match_strict_sequence_with_gaps(
     size_t         start_pos,     // 起始匹配位置（新增参数）
     int8_t         direction       // 1=正向, -1=反向
 ) {
-    match_result result = {0, 0, 0, 0, 0.0f};
+    match_result result = {0, 0, 0, 0, MATCH_CONFIDENCE_ZERO};
     if (!input || !pattern || pattern_len == 0 || input_len == 0) {
         return result;
     }
@@ -734,9 +1092,9 @@ match_result match_strict_sequence_with_gaps(
                         result.end = (uint16_t)i;
                         uint16_t max_possible_gap = (uint16_t)(pattern_len - 1) * max_gap;
                         if (max_possible_gap == 0) {
-                            result.confidence = (total_gap == 0) ? 1.0f : 0.0f;
+                            result.confidence = (total_gap == 0) ? MATCH_CONFIDENCE_ONE : MATCH_CONFIDENCE_ZERO;
                         } else {
-                            result.confidence = 1.0f - (float)total_gap / (float)max_possible_gap;
+                            result.confidence = MATCH_CONFIDENCE_FROM_GAP(total_gap, max_possible_gap);
                         }
                         return result;
                     }
@@ -784,9 +1142,9 @@ match_result match_strict_sequence_with_gaps(
                         result.end = (uint16_t)match_start;
                         uint16_t max_possible_gap = (uint16_t)(pattern_len - 1) * max_gap;
                         if (max_possible_gap == 0) {
-                            result.confidence = (total_gap == 0) ? 1.0f : 0.0f;
+                            result.confidence = (total_gap == 0) ? MATCH_CONFIDENCE_ONE : MATCH_CONFIDENCE_ZERO;
                         } else {
-                            result.confidence = 1.0f - (float)total_gap / (float)max_possible_gap;
+                            result.confidence = MATCH_CONFIDENCE_FROM_GAP(total_gap, max_possible_gap);
                         }
                         return result;
                     }
@@ -816,7 +1174,7 @@ match_result match_strict_sequence_with_gaps_u8(
     size_t         start_pos,
     int8_t            direction
 ) {
-    match_result result = {0, 0, 0, 0, 0.0f};
+    match_result result = {0, 0, 0, 0, MATCH_CONFIDENCE_ZERO};
     if (!input || !pattern || pattern_len == 0 || input_len == 0) {
         return result;
     }
@@ -857,8 +1215,8 @@ match_result match_strict_sequence_with_gaps_u8(
                         result.end = (uint8_t)i;
                         result.total_gap = total_gap;
                         uint8_t max_possible_gap = (uint8_t)(pattern_len - 1) * max_gap;
-                        result.confidence = (max_possible_gap == 0) ? ((total_gap == 0) ? 1.0f : 0.0f)
-                            : 1.0f - (float)total_gap / (float)max_possible_gap;
+                        result.confidence = (max_possible_gap == 0) ? ((total_gap == 0) ? MATCH_CONFIDENCE_ONE : MATCH_CONFIDENCE_ZERO)
+                            : MATCH_CONFIDENCE_FROM_GAP(total_gap, max_possible_gap);
                         return result;
                     }
                 } else {
@@ -905,8 +1263,8 @@ match_result match_strict_sequence_with_gaps_u8(
                         result.end = (uint8_t)match_start;   // start在后
                         result.total_gap = total_gap;
                         uint8_t max_possible_gap = (uint8_t)(pattern_len - 1) * max_gap;
-                        result.confidence = (max_possible_gap == 0) ? ((total_gap == 0) ? 1.0f : 0.0f)
-                            : 1.0f - (float)total_gap / (float)max_possible_gap;
+                        result.confidence = (max_possible_gap == 0) ? ((total_gap == 0) ? MATCH_CONFIDENCE_ONE : MATCH_CONFIDENCE_ZERO)
+                            : MATCH_CONFIDENCE_FROM_GAP(total_gap, max_possible_gap);
                         return result;
                     }
                 } else {
@@ -936,91 +1294,103 @@ growth_array arr = {
     .corner1 = {4,3,2,1,1,1}
 };
 
+// 元素识别实际用到的 (模式, 最大间隔) 组合，下标即 growth_scan_query 的 k
+enum {
+	ELEMENT_UP = 0,       // arr.up，间隔 0
+	ELEMENT_INNER,        // arr.inner，间隔 0
+	ELEMENT_UP_INNER,     // arr.up_inner，间隔 2
+	ELEMENT_CORNER1,      // arr.corner1，间隔 4
+	ELEMENT_PATTERN_NUM
+};
+
+// 每个上下文初始化时编译一次；新增元素模式只需在这里追加，不会增加对 dir_l/dir_r 的整遍扫描
+static void element_matcher_compile(growth_matcher* m)
+{
+	const growth_pattern pats[ELEMENT_PATTERN_NUM] = {
+		{ arr.up, 6, 0 },
+		{ arr.inner, 6, 0 },
+		{ arr.up_inner, 6, 2 },
+		{ arr.corner1, 6, 4 },
+	};
+	growth_matcher_compile(m, pats, ELEMENT_PATTERN_NUM);
+}
+
 /** 
-* @brief 计算边界拟合方差（最小二乘法）
+* @brief 计算边界拟合方差（最小二乘法，前缀和 O(1) 查询）
+* @param ctx					流水线上下文（只有一个点时沿用 ctx->slope_last）
 * @param begin					输入起点
-* @param end					输入终点
-* @param border				输入需要计算的边界数组首地址
-*  @see CTest		float variance = calculate_border_variance(start, end, border);
-* @return 返回拟合方差值，值越小说明边界越接近直线
-*     -<em>-1.0f</em> 计算失败（参数错误或数据点不足）
+* @param end					输入终点（不含）
+* @param stats				边界前缀和（ctx->border_stats 中的 left/right/center，每帧建一次）
+*  @see CTest		border_variance variance = calculate_border_variance(ctx, start, end, &ctx->border_stats.left);
+* @return 返回拟合方差值，值越小说明边界越接近直线（定点 profile 下为 Q16.16）
+*     -<em>-1</em> 计算失败（参数错误或数据点不足）
+*     -<em>BORDER_VARIANCE_NOT_STRAIGHT</em> 终点越出图像（整边丢线时回绕），按“不是直线”处理
 *     -<em>>=0</em> 拟合方差值
 * @note 方差表示边界点与拟合直线的平均偏离程度，可用于判断直线质量
 */
-float calculate_border_variance(uint8_t begin, uint8_t end, uint8_t *border)
+// 区间越界时返回的方差：大于 straight_detect 的“弯”阈值 50，定点 profile 下 Q16.16 也不溢出
+#define BORDER_VARIANCE_NOT_STRAIGHT BORDER_VARIANCE_FROM_INT(1000)
+
+border_variance calculate_border_variance(PipelineContext* ctx, uint8_t begin, uint8_t end, const border_prefix *stats)
 {
-	float xsum = 0, ysum = 0, xysum = 0, x2sum = 0;
-	uint16_t i;
-	uint16_t num = 0;
-	float x_average, y_average;
-	float slope, intercept;
-	static float slope_last = 0.0f;
-	
+#ifdef IMAGEPROC_FIXED_POINT
+	border_fit_q fit;
+#else
+	border_fit fit;
+#endif
+
 	// 参数检查
-	if (end <= begin || border == NULL) {
-		return -1.0f;
-	}
-	
-	// 累加计算
-	for (i = begin; i < end; i++)
-	{
-		xsum += i;
-		ysum += border[i];
-		xysum += i * border[i];
-		x2sum += i * i;
-		num++;
+	if (end <= begin || stats == NULL) {
+		return BORDER_VARIANCE_FROM_INT(-1);
 	}
-	
-	// 检查数据点数量
-	if (num == 0) {
-		return -1.0f;
+	// 整边丢线时调用方传入的 end = lost_up - 3 会回绕到 image_h 之外：不能截断成单点拟合（方差 0 会被判成直线），
+	// 直接给出“不是直线”
+	if (end > image_h) {
+		return BORDER_VARIANCE_NOT_STRAIGHT;
 	}
-	
-	// 计算平均值
-	x_average = xsum / num;
-	y_average = ysum / num;
-	
-	// 计算斜率（最小二乘法）
-	float denominator = num * x2sum - xsum * xsum;
-	if (denominator != 0) {
-		slope = (num * xysum - xsum * ysum) / denominator;
-		slope_last = slope;
-	} else {
-		// 除数为零时使用上次结果
-		slope = slope_last;
+
+#ifdef IMAGEPROC_FIXED_POINT
+	fit = border_prefix_fit_q(stats, begin, end);
+#else
+	fit = border_prefix_fit(stats, begin, end);
+#endif
+	if (!fit.ok) {
+		return BORDER_VARIANCE_FROM_INT(-1);
 	}
-	
-	// 计算截距
-	intercept = y_average - slope * x_average;
-	
-	// 计算方差（拟合残差的平方和除以样本数）
-	float variance = 0;
-	for (i = begin; i < end; i++)
-	{
-		float fitted_y = slope * i + intercept;
-		float residual = border[i] - fitted_y;
-		variance += residual * residual;
+
+	// 分母为零（只有一个点）时斜率沿用上次结果，残差恒为 0
+	if (!fit.degenerate) {
+#ifdef IMAGEPROC_FIXED_POINT
+		ctx->slope_last = fit.slope_q;
+#else
+		ctx->slope_last = fit.slope;
+#endif
 	}
-	variance /= num;
-	
-	return variance;
+#ifdef IMAGEPROC_FIXED_POINT
+	// variance_q ≤ 255² << 16，在 int32 范围内
+	return (border_variance)fit.variance_q;
+#else
+	return fit.variance;
+#endif
 }
 
 /** 
 十字补线函数
  */
-uint8_t cross_flag=0;
-void cross_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir_l, uint16_t *dir_r, uint16_t(*points_l)[2], uint16_t(*points_r)[2])
+void cross_detect(PipelineContext* ctx, uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir_l, uint16_t *dir_r, uint16_t(*points_l)[2], uint16_t(*points_r)[2])
 {
 	int temp1=0,temp2=0;
-	cross_flag=0;
+	const uint8_t cross_mask = (1u << ELEMENT_UP) | (1u << ELEMENT_INNER) | (1u << ELEMENT_UP_INNER);
+	growth_scan scan;//一次正向扫描同时得到三个模式的全部匹配，后面按起点查询
+	ctx->cross_flag=0;
 	// 左边匹配检测
-	match_result result_l1 = match_strict_sequence_with_gaps(dir_l, total_num_l, arr.up, 6, 0, 0, 1);
+	growth_scan_run(&scan, &ctx->element_matcher, dir_l, total_num_l, 1, cross_mask);
+	match_result result_l1 = growth_scan_query(&scan, ELEMENT_UP, 0);
 	if(result_l1.matched){
-		match_result result_l2 =match_strict_sequence_with_gaps(dir_l, total_num_l, arr.inner, 6, 0, result_l1.end, 1);
+		match_result result_l2 = growth_scan_query(&scan, ELEMENT_INNER, result_l1.end);
 		if(result_l2.matched){
 			temp1=image_h-1-points_l[result_l2.end][1];//这段是cross上边缘 记录行数
-			match_result result_l3 = match_strict_sequence_with_gaps(dir_l, total_num_l, arr.up_inner, 6, 2, result_l2.end, 1);
+			match_result result_l3 = growth_scan_query(&scan, ELEMENT_UP_INNER, result_l2.end);
 			if(!result_l3.matched){ 
 				return;
 			}
@@ -1032,12 +1402,13 @@ void cross_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir_l, ui
 	else{
 		return;
 	}
-	match_result result_r1 = match_strict_sequence_with_gaps(dir_r, total_num_r, arr.up, 6, 0, 0, 1);
+	growth_scan_run(&scan, &ctx->element_matcher, dir_r, total_num_r, 1, cross_mask);
+	match_result result_r1 = growth_scan_query(&scan, ELEMENT_UP, 0);
 	if(result_r1.matched){
-		match_result result_r2 = match_strict_sequence_with_gaps(dir_r, total_num_r, arr.inner, 6, 0, result_r1.end, 1);
+		match_result result_r2 = growth_scan_query(&scan, ELEMENT_INNER, result_r1.end);
 		if(result_r2.matched){
 			temp2=image_h-1-points_r[result_r2.end][1];//这段是cross上边缘 记录行数
-			match_result result_r3 = match_strict_sequence_with_gaps(dir_r, total_num_r, arr.up_inner, 6, 2, result_r2.end, 1);
+			match_result result_r3 = growth_scan_query(&scan, ELEMENT_UP_INNER, result_r2.end);
 			if(!result_r3.matched){ 
 				return;
 			}
@@ -1051,16 +1422,16 @@ void cross_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir_l, ui
 		return;
 	}
 	//上面的检察全过才能到这里 所以直接赋1 补线流程集成在一块 flag主要是为了日志记录
-	cross_flag=1;
+	ctx->cross_flag=1;
 	/*补线
 	log_add_int16("temp1", temp1, -1);
 	log_add_int16("temp2", temp2, -1);
-	uint8_t templ=l_border[temp1+3],tempr=r_border[temp2+3];
+	uint8_t templ=ctx->l_border[temp1+3],tempr=ctx->r_border[temp2+3];
 	for(uint8_t i=0;(i<=temp1)||(i<=temp2);i++)
 	{
 		//补竖线得了
-		l_border[i]=templ;
-		r_border[i]=tempr;
+		ctx->l_border[i]=templ;
+		ctx->r_border[i]=tempr;
 	}*/
 	
 }
@@ -1068,22 +1439,28 @@ void cross_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir_l, ui
 
 
 //直线检测函数
-uint8_t left_straight=0,right_straight=0,straight=0;
-void straight_detect(uint8_t *l, uint8_t *r,uint16_t start_l,uint16_t start_r,uint16_t end_l,uint16_t end_r)
+void straight_detect(PipelineContext* ctx, const border_prefix *l, const border_prefix *r,uint16_t start_l,uint16_t start_r,uint16_t end_l,uint16_t end_r)
 {
 	// 先清零
-	right_straight=0;
-	left_straight=0;
-	straight=0;
-	float left_variance = calculate_border_variance(start_l, end_l, l);
-	float right_variance = calculate_border_variance(start_r, end_r, r);
-	log_add_float("left_variance", left_variance, -1);
-	log_add_float("right_variance", right_variance, -1);
+	ctx->right_straight=0;
+	ctx->left_straight=0;
+	ctx->straight=0;
+	border_variance left_variance = calculate_border_variance(ctx, start_l, end_l, l);
+	border_variance right_variance = calculate_border_variance(ctx, start_r, end_r, r);
+	if (ctx->log_enabled) {
+#ifdef IMAGEPROC_FIXED_POINT
+		log_add_int32("left_variance_q16", left_variance, ctx->log_frame);
+		log_add_int32("right_variance_q16", right_variance, ctx->log_frame);
+#else
+		log_add_float("left_variance", left_variance, ctx->log_frame);
+		log_add_float("right_variance", right_variance, ctx->log_frame);
+#endif
+	}
 
 	// 这里留了一个不那么严格的直线判断标准 值为2
-	left_straight = (left_variance < 10.0f)?1u:(left_variance < 50.0f?2u:0u);
-	right_straight = (right_variance < 10.0f)?1u:(right_variance < 50.0f?2u:0u);
-	straight = left_straight && right_straight;
+	ctx->left_straight = (left_variance < BORDER_VARIANCE_FROM_INT(10))?1u:(left_variance < BORDER_VARIANCE_FROM_INT(50)?2u:0u);
+	ctx->right_straight = (right_variance < BORDER_VARIANCE_FROM_INT(10))?1u:(right_variance < BORDER_VARIANCE_FROM_INT(50)?2u:0u);
+	ctx->straight = ctx->left_straight && ctx->right_straight;
 }
 
 /*
@@ -1091,17 +1468,14 @@ void straight_detect(uint8_t *l, uint8_t *r,uint16_t start_l,uint16_t start_r,ui
 环岛检测函数群
 
 */
-uint8_t island_flag=0;
-uint8_t first_corner=0;
-uint8_t second_corner=0;
-uint8_t count_down=0;
-//uint8_t firstcorner_pos[2]={0,0};//记录第一个角点位置 行列 写在顶部了
-void firstcorner_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir_l, uint16_t *dir_r, uint16_t(*points_l)[2], uint16_t(*points_r)[2])
+// island_flag/first_corner/second_corner/count_down/firstcorner_pos 保存在 PipelineContext 中
+void firstcorner_detect(PipelineContext* ctx, uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir_l, uint16_t *dir_r, uint16_t(*points_l)[2], uint16_t(*points_r)[2])
 {
 	uint16_t match_start_l=total_num_l-1,match_start_r=total_num_r-1;
-	match_result result_cl={0,0,0,0,0.0f};
-	match_result result_cr={0,0,0,0,0.0f};
-	first_corner=0;
+	match_result result_cl={0,0,0,0,MATCH_CONFIDENCE_ZERO};
+	match_result result_cr={0,0,0,0,MATCH_CONFIDENCE_ZERO};
+	growth_scan scan;
+	ctx->first_corner=0;
 	/* 见到环岛第一个角点时 环的部分会有丢线 也就是last_left/right_lost_midstart非零 我们从midstart行开始反向匹配第一角点序列
 	   但midstart是从下往上数的行数 我们要找出它对应的dir_l/dir_r索引位置
 
@@ -1110,16 +1484,16 @@ void firstcorner_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir
 	*/
 
 	//如果没有中间丢线 直接返回
-	if(last_left_lost_midstart==0&&last_right_lost_midstart==0)
+	if(ctx->last_left_lost_midstart==0&&ctx->last_right_lost_midstart==0)
 	    //return;
 		;
 	//中部左丢右不丢 检测左第一角点
-    else if(last_left_lost_midstart!=0&&last_right_lost_midstart==0)
+    else if(ctx->last_left_lost_midstart!=0&&ctx->last_right_lost_midstart==0)
 	{
 	// 将 l_border 索引转换为原始图像 y 坐标
-	uint16_t target_y = image_h - 1 - last_left_lost_midstart;
+	uint16_t target_y = image_h - 1 - ctx->last_left_lost_midstart;
 	// 从 last_left_lost_midstart 开始搜索，必能找到或越过目标行
-	for(uint16_t i=last_left_lost_midstart; i<total_num_l; i++)
+	for(uint16_t i=ctx->last_left_lost_midstart; i<total_num_l; i++)
 	{
 		if(points_l[i][1] == target_y)
 		{
@@ -1130,16 +1504,17 @@ void firstcorner_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir
 		if(points_l[i][1] <= target_y)
 			break;
 	}
-	result_cl = match_strict_sequence_with_gaps(dir_l, total_num_l, arr.corner1, 6, 4, match_start_l, -1);
+	growth_scan_run(&scan, &ctx->element_matcher, dir_l, total_num_l, -1, 1u << ELEMENT_CORNER1);
+	result_cl = growth_scan_query(&scan, ELEMENT_CORNER1, match_start_l);
     }
 
 	//中部右丢左不丢 检测右第一角点
-	else if(last_left_lost_midstart==0&&last_right_lost_midstart!=0)
+	else if(ctx->last_left_lost_midstart==0&&ctx->last_right_lost_midstart!=0)
 	{
 	// 将 r_border 索引转换为原始图像 y 坐标
-	uint16_t target_y = image_h - 1 - last_right_lost_midstart;
+	uint16_t target_y = image_h - 1 - ctx->last_right_lost_midstart;
 	// 从 last_right_lost_midstart 开始搜索，必能找到或越过目标行
-	for(uint16_t i=last_right_lost_midstart; i<total_num_r; i++)
+	for(uint16_t i=ctx->last_right_lost_midstart; i<total_num_r; i++)
 	{
 		if(points_r[i][1] == target_y)
 		{
@@ -1150,98 +1525,63 @@ void firstcorner_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir
 		if(points_r[i][1] <= target_y)
 			break;
 	}
-	result_cr = match_strict_sequence_with_gaps(dir_r, total_num_r, arr.corner1, 6, 4, match_start_r, -1);
+	growth_scan_run(&scan, &ctx->element_matcher, dir_r, total_num_r, -1, 1u << ELEMENT_CORNER1);
+	result_cr = growth_scan_query(&scan, ELEMENT_CORNER1, match_start_r);
     }
 
-	if((left_straight!=0)&&result_cr.matched)
+	if((ctx->left_straight!=0)&&result_cr.matched)
 	{
-		first_corner=1;
-		count_down=8;//见到第一角点就重置计数器
-		firstcorner_pos[0]=points_r[result_cr.start][0];// x
-		firstcorner_pos[1]=image_h-1-points_r[result_cr.start][1];// y
+		ctx->first_corner=1;
+		ctx->count_down=8;//见到第一角点就重置计数器
+		ctx->firstcorner_pos[0]=points_r[result_cr.start][0];// x
+		ctx->firstcorner_pos[1]=image_h-1-points_r[result_cr.start][1];// y
 		// 右环
 	}
-	else if((right_straight!=0)&&result_cl.matched)
+	else if((ctx->right_straight!=0)&&result_cl.matched)
 	{
-		first_corner=2;
-		count_down=8;//见到第一角点就重置计数器
-	    firstcorner_pos[0]=points_l[result_cl.start][0];// x
-		firstcorner_pos[1]=image_h-1-points_l[result_cl.start][1];// y
+		ctx->first_corner=2;
+		ctx->count_down=8;//见到第一角点就重置计数器
+	    ctx->firstcorner_pos[0]=points_l[result_cl.start][0];// x
+		ctx->firstcorner_pos[1]=image_h-1-points_l[result_cl.start][1];// y
 		// 左环
 	}
 	else
 	{
-		if(count_down>0)
-		count_down--;
-		first_corner=0;
-		firstcorner_pos[0]=0;
-		firstcorner_pos[1]=0;
+		if(ctx->count_down>0)
+		ctx->count_down--;
+		ctx->first_corner=0;
+		ctx->firstcorner_pos[0]=0;
+		ctx->firstcorner_pos[1]=0;
+	}
+	if (ctx->log_enabled) {
+		log_add_uint8("横firstcorner_pos", ctx->firstcorner_pos[0], ctx->log_frame);
+		log_add_uint8("纵firstcorner_pos", ctx->firstcorner_pos[1], ctx->log_frame);
 	}
-	log_add_uint8("横firstcorner_pos", firstcorner_pos[0], -1);
-	log_add_uint8("纵firstcorner_pos", firstcorner_pos[1], -1);
-
-
-	/*
-    // --- 卡尔曼滤波器集成 ---
-    if (first_corner != 0) { // 仅当检测到角点时更新卡尔曼滤波器
-        float current_measurement[2] = {(float)firstcorner_pos[0], (float)firstcorner_pos[1]};
-
-        if (!kf_firstcorner_initialized) {
-            // 使用第一个有效测量值初始化卡尔曼滤波器
-            // 过程噪声 (Q) 和测量噪声 (R) 是可调参数。
-            // dt 暂时设为 1.0，表示一个帧间隔。
-            // 如果帧率可变，dt 应动态计算。
-            kalman_init(&kf_firstcorner, current_measurement[0], current_measurement[1], 1.0f, 20.0f);//r20
-            kf_firstcorner_initialized = 1;
-        } else {
-            kalman_predict(&kf_firstcorner, 1.0f); // dt = 1.0f (一个帧间隔)
-            kalman_update(&kf_firstcorner, current_measurement);
-        }
-        // 存储滤波后的位置
-        firstcorner_pos_filtered[0] = (uint8_t)kf_firstcorner.x[0];
-        firstcorner_pos_filtered[1] = (uint8_t)kf_firstcorner.x[1];
-        kf_firstcorner_loss_count = 0; // 成功检测到时重置丢失计数
-    } else { // 未检测到角点
-        if (kf_firstcorner_initialized) {
-            kf_firstcorner_loss_count++;
-            if (kf_firstcorner_loss_count < KALMAN_MAX_LOSS_FRAMES) {
-                // 在丢失阈值内继续预测
-                kalman_predict(&kf_firstcorner, 1.0f);
-                firstcorner_pos_filtered[0] = (uint8_t)kf_firstcorner.x[0];
-                firstcorner_pos_filtered[1] = (uint8_t)kf_firstcorner.x[1];
-            } else {
-                // 超过丢失阈值，禁用滤波器
-                kf_firstcorner_initialized = 0;
-                kf_firstcorner_loss_count = 0; // 重置计数
-                firstcorner_pos_filtered[0] = 0u; // 重置滤波后的位置
-                firstcorner_pos_filtered[1] = 0u;
-            }
-        } else {
-            // 滤波器未初始化或已禁用，重置滤波后的位置
-            firstcorner_pos_filtered[0] = 0u;
-            firstcorner_pos_filtered[1] = 0u;
-        }
-    }
-    // --- 卡尔曼滤波器集成结束 ---
-
-	log_add_uint8("横firstcorner_pos_filtered", firstcorner_pos_filtered[0], -1);
-	log_add_uint8("纵firstcorner_pos_filtered", firstcorner_pos_filtered[1], -1);
-	*/
 
-	log_add_uint8("count_down", count_down, -1);
-    log_add_uint8("result_cl.matched",result_cl.matched,-1);
-	log_add_float("result_cl.confidence",result_cl.confidence,-1);
-	log_add_uint8("result_cr.matched",result_cr.matched,-1);
-	log_add_float("result_cr.confidence",result_cr.confidence,-1);
-	log_add_uint8("first_corner", first_corner, -1);
+	if (ctx->log_enabled) {
+		log_add_uint8("count_down", ctx->count_down, ctx->log_frame);
+		log_add_uint8("result_cl.matched",result_cl.matched,ctx->log_frame);
+#ifdef IMAGEPROC_FIXED_POINT
+		log_add_uint16("result_cl.confidence_q15",result_cl.confidence,ctx->log_frame);
+#else
+		log_add_float("result_cl.confidence",result_cl.confidence,ctx->log_frame);
+#endif
+		log_add_uint8("result_cr.matched",result_cr.matched,ctx->log_frame);
+#ifdef IMAGEPROC_FIXED_POINT
+		log_add_uint16("result_cr.confidence_q15",result_cr.confidence,ctx->log_frame);
+#else
+		log_add_float("result_cr.confidence",result_cr.confidence,ctx->log_frame);
+#endif
+		log_add_uint8("first_corner", ctx->first_corner, ctx->log_frame);
+	}
 }
 
 
-void secondcorner_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir_l, uint16_t *dir_r, uint16_t(*points_l)[2], uint16_t(*points_r)[2])
+void secondcorner_detect(PipelineContext* ctx, uint16_t total_num_l, uint16_t total_num_r,uint16_t *dir_l, uint16_t *dir_r, uint16_t(*points_l)[2], uint16_t(*points_r)[2])
 //第一角点检测逻辑内创建了一个计数器count_down 倒计N帧 第二角点检测函数检测到计数值非零才能进入检测逻辑
 //注意这个倒计时每次见到第一角点都会重置 
 {
-;
+	(void)ctx; // 尚未实现，读 ctx->count_down 的检测逻辑接入前保留参数
 }
 
 
@@ -1249,71 +1589,295 @@ void secondcorner_detect(uint16_t total_num_l, uint16_t total_num_r,uint16_t *di
 /*
 日志记录函数 日志统一写在这里
 */
-void userlog()
+void userlog(PipelineContext* ctx)
 {
-	//log_add_uint8_array("左 丢left_lost", left_lost, image_h,-1);
-	//log_add_uint8_array("右 丢right_lost", right_lost, image_h,-1);
-	//log_add_uint8_array("左边 最终l_border", l_border, image_h,-1);
-	//log_add_uint8_array("右边 最终r_border", r_border, image_h,-1);
-	log_add_uint8("左直left_straight", left_straight, -1);
-	log_add_uint8("右直right_straight", right_straight, -1);
-	//log_add_uint8("环 1右2左island_flag", island_flag, -1);
-	//log_add_uint8("十字路口cross_flag", cross_flag, -1);
-	//log_add_uint8("左 上 丢last_left_lost_up", last_left_lost_up, -1);
-	//log_add_uint8("左 下 丢last_left_lost_down", last_left_lost_down, -1);
-	log_add_uint8("左 中 丢last_left_lost_midstart", last_left_lost_midstart, -1);
-	//log_add_uint8("左 中 丢last_left_lost_midend", last_left_lost_midend, -1);
-	//log_add_uint8("右 上 丢last_right_lost_up", last_right_lost_up, -1);
-	//log_add_uint8("右 下 丢last_right_lost_down", last_right_lost_down, -1);
-	log_add_uint8("右 中 丢last_right_lost_midstart", last_right_lost_midstart, -1);
-	//log_add_uint8("右 中 丢last_right_lost_midend", last_right_lost_midend, -1);
-	log_add_uint16_array("左 生长dir_l", dir_l, data_stastics_l,-1);
-	log_add_uint16_array("右 生长dir_r", dir_r, data_stastics_r,-1);
+	if (!ctx->log_enabled) return;
+	//log_add_uint8("左 丢left_lost_num", ctx->left_lost_num, ctx->log_frame);
+	//log_add_uint8("右 丢right_lost_num", ctx->right_lost_num, ctx->log_frame);
+	//log_add_uint8_array("左边 最终l_border", ctx->l_border, image_h,ctx->log_frame);
+	//log_add_uint8_array("右边 最终r_border", ctx->r_border, image_h,ctx->log_frame);
+	log_add_uint8("左直left_straight", ctx->left_straight, ctx->log_frame);
+	log_add_uint8("右直right_straight", ctx->right_straight, ctx->log_frame);
+	//log_add_uint8("环 1右2左island_flag", ctx->island_flag, ctx->log_frame);
+	//log_add_uint8("十字路口cross_flag", ctx->cross_flag, ctx->log_frame);
+	//log_add_uint8("左 上 丢last_left_lost_up", ctx->last_left_lost_up, ctx->log_frame);
+	//log_add_uint8("左 下 丢last_left_lost_down", ctx->last_left_lost_down, ctx->log_frame);
+	log_add_uint8("左 中 丢last_left_lost_midstart", ctx->last_left_lost_midstart, ctx->log_frame);
+	//log_add_uint8("左 中 丢last_left_lost_midend", ctx->last_left_lost_midend, ctx->log_frame);
+	//log_add_uint8("右 上 丢last_right_lost_up", ctx->last_right_lost_up, ctx->log_frame);
+	//log_add_uint8("右 下 丢last_right_lost_down", ctx->last_right_lost_down, ctx->log_frame);
+	log_add_uint8("右 中 丢last_right_lost_midstart", ctx->last_right_lost_midstart, ctx->log_frame);
+	//log_add_uint8("右 中 丢last_right_lost_midend", ctx->last_right_lost_midend, ctx->log_frame);
+	if (ctx->log_dir_arrays) {
+		//旧格式：逐点数组，每边约 1.5KB 文本
+		log_add_uint16_array("左 生长dir_l", ctx->dir_l, ctx->data_stastics_l,ctx->log_frame);
+		log_add_uint16_array("右 生长dir_r", ctx->dir_r, ctx->data_stastics_r,ctx->log_frame);
+	} else {
+		//链码文本（起点 + 移动码 / 生长方向游程），replay_check 用 chain_parse 还原出 dir_l/dir_r
+		chain_code chain;
+		char text[CHAIN_TEXT_MAX];
+		chain_encode(&chain, (const uint16_t (*)[2])ctx->points_l, ctx->dir_l, ctx->data_stastics_l);
+		if (chain_format(&chain, text, sizeof(text)) >= 0) log_add_string("左 链码chain_l", text, ctx->log_frame);
+		chain_encode(&chain, (const uint16_t (*)[2])ctx->points_r, ctx->dir_r, ctx->data_stastics_r);
+		if (chain_format(&chain, text, sizeof(text)) >= 0) log_add_string("右 链码chain_r", text, ctx->log_frame);
+	}
 }
 
 
 /*
-函数名称：void image_process(void)
-功能说明：最终处理函数
-参数说明：无
+函数名称：void image_process_ctx(PipelineContext* ctx, const uint8* in, uint8* out)
+功能说明：最终处理函数（可重入版），所有中间状态都保存在 ctx 中
+参数说明：ctx   流水线上下文（每个线程/每路回放一个）
+         in    输入 0/255 二值图，image_h×image_w 连续存储
+         out   输出 imo，image_h×image_w 连续存储，可与 in 相同
 函数返回：无
 修改时间：2022年9月8日
 备    注：
-example： image_process();
+example： image_process_ctx(ctx, Grayscale[0], imo[0]);
  */
-void image_process(void)
+void image_process_ctx(PipelineContext* ctx, const uint8_t* in, uint8_t* out)
+{
+	//0/255 二值图按阈值 0 打包（非零即白）
+	pack_gray_threshold_to_bits(in, image_w, image_h, image_w, 0, ctx->morph_packed);
+	image_process_packed_ctx(ctx, ctx->morph_packed, out);
+}
+
+/*
+函数名称：void image_process_gray_ctx(PipelineContext* ctx, const uint8* gray, int stride, uint8 threshold, uint8* out)
+功能说明：灰度直入版：灰度→阈值→位打包一步完成（SIMD），省去中间的 0/255 二值图
+参数说明：ctx        流水线上下文
+         gray       image_h×image_w 灰度图，行跨度 stride 字节（可带行填充，如 cv::Mat::step）
+         threshold  灰度 > threshold 视为白
+         out        输出 imo，image_h×image_w 连续存储
+函数返回：无
+修改时间：2022年9月8日
+备    注：threshold=128 时与旧的 gray>128?255:0 再调用 image_process_ctx 结果完全一致
+example： image_process_gray_ctx(ctx, resized.data, (int)resized.step, 128, imo[0]);
+ */
+void image_process_gray_ctx(PipelineContext* ctx, const uint8_t* gray, int stride, uint8_t threshold, uint8_t* out)
+{
+	pack_gray_threshold_to_bits(gray, image_w, image_h, stride, threshold, ctx->morph_packed);
+	image_process_packed_ctx(ctx, ctx->morph_packed, out);
+}
+
+/*
+函数名称：void image_process_packed_ctx(PipelineContext* ctx, const uint32* bits, uint8* out)
+功能说明：从已打包好的输入位图开始处理一帧
+参数说明：ctx   流水线上下文
+         bits  输入位图（image_h 行，每行 words_per_row(image_w) 个 word，bit=1 为白），可以是 ctx->morph_packed
+         out   输出 imo，image_h×image_w 连续存储
+函数返回：无
+修改时间：2022年9月8日
+备    注：
+example： image_process_packed_ctx(ctx, packed, imo[0]);
+ */
+void image_process_packed_ctx(PipelineContext* ctx, const uint32_t* bits, uint8_t* out)
+{
+	image_process_bits(ctx, bits, 0, out, image_w);
+}
+
+/*
+函数名称：void image_process_morphed_ctx(PipelineContext* ctx, const uint32* morphed, uint8* out)
+功能说明：从已做完开→闭运算的位图开始处理一帧（跳过形态学阶段，其余与 image_process_packed_ctx 相同）
+参数说明：ctx      流水线上下文
+         morphed  open_close_bitpacked 系列的输出（如 morph_open_close_batch 整批算好的某一帧）
+         out      输出 imo，image_h×image_w 连续存储
+函数返回：无
+备    注：离线回放按 64 帧一批做位切片形态学后逐帧调用，结果与 image_process_packed_ctx 逐帧一致
+example： image_process_morphed_ctx(ctx, batch_out + f * PIPELINE_MORPH_WORDS, imo[0]);
+ */
+void image_process_morphed_ctx(PipelineContext* ctx, const uint32_t* morphed, uint8_t* out)
+{
+	image_process_bits(ctx, morphed, 1, out, image_w);
+}
+
+// 流水线主体：bits 为位打包输入（morphed 非 0 时已做完开→闭运算），out 为输出 imo（行跨度 out_stride 字节）
+static void image_process_bits(PipelineContext* ctx, const uint32_t* bits, int morphed, uint8_t* out, int out_stride)
 {
 	uint16_t i;
 	uint8_t Hightest = 0;//定义一个最高行，tip：这里的最高指的是y值的最小
-
-//滤波（形态学处理）
-morph_clean_u8_binary_adapter(Grayscale[0], image_w, image_h, imo[0]);
-image_draw_rectan(imo);//填黑框
-//清零
-data_stastics_l = 0;
-data_stastics_r = 0;
-if (get_start_point(image_h - 3)||get_start_point(image_h - 5)||get_start_point(image_h - 7))//找到起点了，再执行八领域，没找到就一直找
+	uint8_t found;
+	uint8_t same_start; //时域复用：起点沿用上一帧
+
+STAGE_TIMING_BEGIN(&ctx->timing);
+//滤波（形态学处理），结果保留为位打包图，找起点与八邻域直接在位图上进行
+if (morphed) memcpy(ctx->morph_out, bits, sizeof(ctx->morph_out));
+else open_close_bitpacked_fused(bits, ctx->morph_tmp, ctx->morph_out, image_w, image_h);
+STAGE_TIMING_MARK(&ctx->timing, STAGE_MORPH);
+image_draw_rectan_bits(ctx->morph_out);//填黑框
+STAGE_TIMING_MARK(&ctx->timing, STAGE_DRAW_RECTAN);
+if (ctx->temporal_enabled && ctx->temporal_valid && trace_temporal_start_unchanged(ctx, ctx->morph_out))
+{
+	//起点搜索读过的行段与上一帧相同：起点与是否找到都沿用上一帧（仍在 ctx 中）
+	found = ctx->temporal_found;
+	same_start = found;
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_TEMPORAL);
+}
+else
+{
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_TEMPORAL);
+	//清零
+	ctx->data_stastics_l = 0;
+	ctx->data_stastics_r = 0;
+	found = get_start_point_bits(ctx, ctx->morph_out, image_h - 3)||get_start_point_bits(ctx, ctx->morph_out, image_h - 5)||get_start_point_bits(ctx, ctx->morph_out, image_h - 7);
+	same_start = 0;
+}
+STAGE_TIMING_MARK(&ctx->timing, STAGE_START_POINT);
+if (found)//找到起点了，再执行八领域，没找到就一直找
 {
 	//printf("正在开始八领域\n");
-	search_l_r((uint16_t)USE_num, imo, &data_stastics_l, &data_stastics_r, start_point_l[0], start_point_l[1], start_point_r[0], start_point_r[1], &hightest);
+	if (ctx->temporal_enabled)
+	{
+		trace_temporal_search(ctx, ctx->morph_out, same_start);
+	}
+	else
+	{
+		search_l_r_bits(ctx, (uint16_t)USE_num, ctx->morph_out, &ctx->data_stastics_l, &ctx->data_stastics_r, ctx->start_point_l[0], ctx->start_point_l[1], ctx->start_point_r[0], ctx->start_point_r[1], &ctx->hightest);
+	}
 	//printf("八邻域已结束\n");
-	// 从爬取的边界线内提取边线 ， 这个才是最终有用的边线
-	get_left(data_stastics_l);
-	get_right(data_stastics_r);
+}
+STAGE_TIMING_MARK(&ctx->timing, STAGE_SEARCH_L_R);
+if (ctx->temporal_enabled)
+{
+	memcpy(ctx->temporal_prev, ctx->morph_out, sizeof(ctx->temporal_prev));
+	ctx->temporal_found = found;
+	ctx->temporal_valid = 1;
+	if (!found) ctx->temporal_nsteps = 0;
+}
+else
+{
+	ctx->temporal_valid = 0;
+}
+STAGE_TIMING_MARK(&ctx->timing, STAGE_TEMPORAL);
+if (found)
+{
+	// 边线已在八邻域生长时同步提取（这个才是最终有用的边线），这里只由丢线掩码求丢线段
+	get_lost_lines(ctx);
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_LOST_LINES);
 	//处理函数放这里 不要放到if外面
-    cross_detect(data_stastics_l, data_stastics_r, dir_l, dir_r, points_l, points_r);//十字检测
-	straight_detect(l_border, r_border, last_left_lost_down, last_right_lost_down, last_left_lost_up-3, last_right_lost_up-3);//直线检测 这里去掉顶部三行 因为有时左右线在右侧相交 左border会异常
-	firstcorner_detect(data_stastics_l, data_stastics_r, dir_l, dir_r, points_l, points_r);
+    cross_detect(ctx, ctx->data_stastics_l, ctx->data_stastics_r, ctx->dir_l, ctx->dir_r, ctx->points_l, ctx->points_r);//十字检测
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_CROSS);
+	// 十字补线之后的左右边线建一次前缀和，直线检测的区间拟合都是 O(1)
+	border_stats_build(&ctx->border_stats, ctx->l_border, ctx->r_border, NULL);
+	straight_detect(ctx, &ctx->border_stats.left, &ctx->border_stats.right, ctx->last_left_lost_down, ctx->last_right_lost_down, ctx->last_left_lost_up-3, ctx->last_right_lost_up-3);//直线检测 这里去掉顶部三行 因为有时左右线在右侧相交 左border会异常
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_STRAIGHT);
+	firstcorner_detect(ctx, ctx->data_stastics_l, ctx->data_stastics_r, ctx->dir_l, ctx->dir_r, ctx->points_l, ctx->points_r);
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_FIRSTCORNER);
 }
     //求中线
 	for (i = Hightest; i < image_h; i++)
 	{
-		center_line[i] = (l_border[i] + r_border[i]) >> 1;//求中线
+		ctx->center_line[i] = (ctx->l_border[i] + ctx->r_border[i]) >> 1;//求中线
 	}
-    //显示边线
-	draw_edge();
-
-	userlog();
+	border_prefix_build(&ctx->border_stats.center, ctx->center_line);
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_CENTER_LINE);
+    //解包到输出图（仅用于显示），再叠加边线
+	unpack_bits_to_binary_u8(ctx->morph_out, image_w, image_h, out, out_stride);
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_UNPACK);
+    //标注：默认只生成显示列表，out 保持干净二值图（见 overlay.h）
+	if (ctx->overlay_mode == OVERLAY_MODE_OFF)
+	{
+		overlay_clear(&ctx->overlay);
+	}
+	else if (ctx->overlay_mode == OVERLAY_MODE_PAINT)
+	{
+		draw_edge_stride(ctx, out, out_stride);
+	}
+	else
+	{
+		draw_edge_list(ctx, &ctx->overlay);
+	}
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_DRAW_EDGE);
+	userlog(ctx);
+	STAGE_TIMING_MARK(&ctx->timing, STAGE_USERLOG);
+	STAGE_TIMING_END(&ctx->timing);
+#ifdef IMAGEPROC_STAGE_TIMING
+	//计时本身的日志在本帧计时结束之后写，不计入 userlog 阶段
+	if (ctx->log_enabled) stage_timing_log(&ctx->timing, ctx->log_frame);
+#endif
 }
 
+/*
+函数名称：int image_process_view_ctx(PipelineContext* ctx, const image_view* in, uint8 threshold, const image_out_view* out)
+功能说明：视图版：直接读调用者的输入缓冲（任意行跨度 / 像素格式），结果直接写入调用者的输出缓冲
+参数说明：ctx        流水线上下文
+         in         输入视图（格式与尺寸约束见 image_view.h）
+         threshold  灰度 / 彩色输入的阈值（灰度 > threshold 为白），BINARY / PACKED 忽略
+         out        输出视图，image_w×image_h，行跨度 stride ≥ image_w
+函数返回：0 成功；-1 参数非法（不处理该帧，上下文不变）
+修改时间：2022年9月8日
+备    注：输入只在打包阶段读取，之后只读写 ctx 与 out，out 可与 in 重叠
+example： image_view in = { mat.data, mat.cols, mat.rows, (int)mat.step, IMAGE_VIEW_BGR };
+          image_out_view out = { imo[0], image_w, image_h, image_w };
+          image_process_view_ctx(ctx, &in, 128, &out);
+ */
+int image_process_view_ctx(PipelineContext* ctx, const image_view* in, uint8_t threshold, const image_out_view* out)
+{
+	const int wpr = words_per_row(image_w);
+	const uint32_t* bits = ctx->morph_packed;
+	area_src_format fmt;
+	int y;
+
+	if (!in || !out || !in->data || !out->data) return -1;
+	if (out->width != image_w || out->height != image_h || out->stride < image_w) return -1;
+	if (in->width <= 0 || in->height <= 0) return -1;
+
+	switch (in->format)
+	{
+	case IMAGE_VIEW_BINARY:
+		if (in->width != image_w || in->height != image_h || in->stride < image_w) return -1;
+		pack_gray_threshold_to_bits(in->data, image_w, image_h, in->stride, 0, ctx->morph_packed);
+		break;
+	case IMAGE_VIEW_GRAY:
+		if (in->stride < in->width) return -1;
+		if (in->width == image_w && in->height == image_h)
+		{
+			pack_gray_threshold_to_bits(in->data, image_w, image_h, in->stride, threshold, ctx->morph_packed);
+			break;
+		}
+		if (area_downscale_threshold_rows(in->data, in->width, in->height, in->stride, AREA_SRC_GRAY, threshold,
+		                                  ctx->morph_packed, image_w, image_h, 0, image_h) != 0) return -1;
+		break;
+	case IMAGE_VIEW_BGR:
+	case IMAGE_VIEW_RGB:
+	case IMAGE_VIEW_BGRA:
+	case IMAGE_VIEW_RGBA:
+		fmt = (in->format == IMAGE_VIEW_BGR) ? AREA_SRC_BGR :
+		      (in->format == IMAGE_VIEW_RGB) ? AREA_SRC_RGB :
+		      (in->format == IMAGE_VIEW_BGRA) ? AREA_SRC_BGRA : AREA_SRC_RGBA;
+		if (area_downscale_threshold_rows(in->data, in->width, in->height, in->stride, fmt, threshold,
+		                                  ctx->morph_packed, image_w, image_h, 0, image_h) != 0) return -1;
+		break;
+	case IMAGE_VIEW_PACKED:
+		if (in->width != image_w || in->height != image_h) return -1;
+		if (in->stride < wpr * (int)sizeof(uint32_t) || ((uintptr_t)in->data & 3u) || (in->stride & 3)) return -1;
+		if (in->stride == wpr * (int)sizeof(uint32_t))
+		{
+			bits = (const uint32_t*)(const void*)in->data; // 零拷贝
+			break;
+		}
+		for (y = 0; y < image_h; y++)
+		{
+			memcpy(ctx->morph_packed + y * wpr, in->data + (size_t)y * in->stride, (size_t)wpr * sizeof(uint32_t));
+		}
+		break;
+	default:
+		return -1;
+	}
+	image_process_bits(ctx, bits, 0, out->data, out->stride);
+	return 0;
+}
 
+/*
+函数名称：void image_process(void)
+功能说明：最终处理函数（默认上下文封装：输入 Grayscale，输出 imo）
+参数说明：无
+函数返回：无
+修改时间：2022年9月8日
+备    注：非线程安全；需要并发处理时请为每个线程创建 PipelineContext 并调用 image_process_ctx
+example： image_process();
+ */
+void image_process(void)
+{
+	image_process_ctx(pipeline_default_context(), Grayscale[0], imo[0]);
+}
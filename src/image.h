@@ -1,8 +1,12 @@
 #ifndef _IMAGE_H
 #define _IMAGE_H
 #include <stdint.h>
-//绘制边界线
-void draw_edge();
+#include <stddef.h>
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 //生长方向序列匹配结构体
 typedef struct {
@@ -10,7 +14,7 @@ typedef struct {
     uint16_t end;              // 若匹配到序列 记录终止行号（匹配最后一个元素的位置）
     uint8_t matched;       // 是否完整匹配 (0 = false, 1 = true)
     uint8_t total_gap;     // 实际总间隔数 (越小越好)
-    float   confidence;    // 置信度：1.0 = 完美连续, 0.0 = 间隔最大
+    match_confidence confidence; // 置信度：1.0 = 完美连续, 0.0 = 间隔最大（定点 profile 下为 Q15）
 } match_result;
 
 //生长方向序列结构体
@@ -33,6 +37,22 @@ typedef struct{
 #define bin_jump_num	1//跳过的点数
 #define border_max	image_w-2 //边界最大值
 #define border_min	1	//边界最小值	
+#define USE_num	image_h*3	//定义找点的数组成员个数按理说300个点能放下，但是有些特殊情况确实难顶，多定义了一点
+
+typedef struct PipelineContext PipelineContext; // 见 pipeline_context.h
+typedef struct overlay_list overlay_list;       // 见 overlay.h
+
+//绘制边界线
+void draw_edge(PipelineContext* ctx, uint8_t(*image)[image_w]);
+//绘制边界线（输出行跨度 stride 字节）
+void draw_edge_stride(PipelineContext* ctx, uint8_t* out, int stride);
+//生成标注显示列表（不写图像）
+void draw_edge_list(PipelineContext* ctx, overlay_list* l);
+
+//位打包追踪前端（bits 为形态学输出的位打包图，布局同 morph_binary_bitpacked）
+void image_draw_rectan_bits(uint32_t* bits);
+uint8_t get_start_point_bits(PipelineContext* ctx, const uint32_t* bits, uint8_t start_row);
+void search_l_r_bits(PipelineContext* ctx, uint16_t break_flag, const uint32_t* bits, uint16_t *l_stastic, uint16_t *r_stastic, uint8_t l_start_x, uint8_t l_start_y, uint8_t r_start_x, uint8_t r_start_y, uint8_t *hightest);
 
 extern void image_process(void); //直接在中断或循环里调用此程序就可以循环执行了
 extern match_result match_strict_sequence_with_gaps(
@@ -54,10 +74,9 @@ extern match_result match_strict_sequence_with_gaps_u8(
     int8_t         direction       // 匹配方向：1=正向，-1=反向
 );
 
-extern uint8_t l_border[image_h];//左线数组
-extern uint8_t r_border[image_h];//右线数组
-extern uint8_t center_line[image_h];//中线数组
-extern uint8_t firstcorner_pos_filtered[2]; // 卡尔曼滤波后的拐角坐标
+#ifdef __cplusplus
+}
+#endif
 
 #endif /*_IMAGE_H*/
 
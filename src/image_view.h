@@ -0,0 +1,53 @@
+#ifndef IMAGE_VIEW_H
+#define IMAGE_VIEW_H
+
+/*
+  图像视图（输入只读 / 输出可写），供 image_process_view_ctx / process_view_to_imo 直接读写调用者的缓冲
+
+  设计说明：
+  - 视图只描述一块已有的内存：首行首像素指针 + 宽高 + 行跨度（字节），不拥有数据，也不要求连续。
+    cv::Mat 的 ROI（data、cols、rows、step）与 GdkPixbuf（pixels、width、height、rowstride）都可以直接填进来。
+  - 输入按格式直接进入位打包（阈值比较 / 区域平均缩小），不经过全局 Grayscale / original_bi_image：
+      BINARY / GRAY：尺寸必须等于 image_w×image_h，SIMD 阈值打包；GRAY 尺寸不同时按区域平均缩小；
+      BGR / RGB / BGRA / RGBA：任意尺寸，区域平均缩小到 image_w×image_h 后阈值化（alpha 忽略）；
+      PACKED：image_h 行位打包（每行 words_per_row(image_w) 个 uint32），stride 恰为一行字节数时零拷贝，
+              否则逐行拷入上下文缓冲。
+  - 输出视图尺寸必须为 image_w×image_h，stride ≥ image_w；二值底图与边线标注按 stride 直接写入。
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    IMAGE_VIEW_BINARY = 0, // u8，非 0 为白
+    IMAGE_VIEW_GRAY,       // u8 灰度，> threshold 为白
+    IMAGE_VIEW_BGR,
+    IMAGE_VIEW_RGB,
+    IMAGE_VIEW_BGRA,
+    IMAGE_VIEW_RGBA,
+    IMAGE_VIEW_PACKED      // 位打包，bit=1 为白，最左像素在 bit0（data 需 4 字节对齐）
+} image_view_format;
+
+typedef struct {
+    const uint8_t* data;      // 首行首像素
+    int width;
+    int height;
+    int stride;               // 行跨度（字节）
+    image_view_format format;
+} image_view;
+
+typedef struct {
+    uint8_t* data;            // 首行首像素
+    int width;
+    int height;
+    int stride;               // 行跨度（字节）
+} image_out_view;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMAGE_VIEW_H
@@ -1,45 +1,70 @@
 #include "kalman.h"
 #include <string.h>
 
+// --- 数值 profile：浮点直接运算；定点下乘积在 int64 中累加，最后舍入并饱和回 Q19.12 ---
+#ifdef IMAGEPROC_FIXED_POINT
+static kalman_real kalman_sat(int64_t v) {
+    if (v > INT32_MAX) return INT32_MAX;
+    if (v < INT32_MIN) return INT32_MIN;
+    return (kalman_real)v;
+}
+static kalman_real kalman_norm(int64_t acc) {
+    return kalman_sat((acc + (1 << (KALMAN_Q - 1))) >> KALMAN_Q);
+}
+#define KMUL(a, b) ((int64_t)(a) * (b))
+#define KNORM(acc) kalman_norm(acc)
+#define KADD(a, b) kalman_sat((int64_t)(a) + (b))
+#define KSUB(a, b) kalman_sat((int64_t)(a) - (b))
+#define KDIV(num, den) kalman_sat(((int64_t)(num) * (1 << KALMAN_Q)) / (den)) // num/den，den > 0
+#define KDIV_ACC(acc, den) kalman_sat((acc) / (den))                          // Q24 乘积 / Q12 → Q12
+#else
+#define KMUL(a, b) ((a) * (b))
+#define KNORM(acc) (acc)
+#define KADD(a, b) ((a) + (b))
+#define KSUB(a, b) ((a) - (b))
+#define KDIV(num, den) ((num) / (den))
+#define KDIV_ACC(acc, den) ((acc) / (den))
+#endif
+
 // --- Optimized Matrix Operations for Kalman Filter (4x4, 4x1, 2x2, 2x1) ---
 
 // 4x4 * 4x1 (vector) -> 4x1
-static void mat_mul_4x4_4x1(float res[4], const float A[4][4], const float B[4]) {
-    res[0] = A[0][0]*B[0] + A[0][1]*B[1] + A[0][2]*B[2] + A[0][3]*B[3];
-    res[1] = A[1][0]*B[0] + A[1][1]*B[1] + A[1][2]*B[2] + A[1][3]*B[3];
-    res[2] = A[2][0]*B[0] + A[2][1]*B[1] + A[2][2]*B[2] + A[2][3]*B[3];
-    res[3] = A[3][0]*B[0] + A[3][1]*B[1] + A[3][2]*B[2] + A[3][3]*B[3];
+static void mat_mul_4x4_4x1(kalman_real res[4], const kalman_real A[4][4], const kalman_real B[4]) {
+    res[0] = KNORM(KMUL(A[0][0], B[0]) + KMUL(A[0][1], B[1]) + KMUL(A[0][2], B[2]) + KMUL(A[0][3], B[3]));
+    res[1] = KNORM(KMUL(A[1][0], B[0]) + KMUL(A[1][1], B[1]) + KMUL(A[1][2], B[2]) + KMUL(A[1][3], B[3]));
+    res[2] = KNORM(KMUL(A[2][0], B[0]) + KMUL(A[2][1], B[1]) + KMUL(A[2][2], B[2]) + KMUL(A[2][3], B[3]));
+    res[3] = KNORM(KMUL(A[3][0], B[0]) + KMUL(A[3][1], B[1]) + KMUL(A[3][2], B[2]) + KMUL(A[3][3], B[3]));
 }
 
 // 4x4 * 4x4 -> 4x4
-static void mat_mul_4x4_4x4(float res[4][4], const float A[4][4], const float B[4][4]) {
+static void mat_mul_4x4_4x4(kalman_real res[4][4], const kalman_real A[4][4], const kalman_real B[4][4]) {
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
-            res[i][j] = A[i][0]*B[0][j] + A[i][1]*B[1][j] + A[i][2]*B[2][j] + A[i][3]*B[3][j];
+            res[i][j] = KNORM(KMUL(A[i][0], B[0][j]) + KMUL(A[i][1], B[1][j]) + KMUL(A[i][2], B[2][j]) + KMUL(A[i][3], B[3][j]));
         }
     }
 }
 
 // 4x4 + 4x4 -> 4x4
-static void mat_add_4x4_4x4(float res[4][4], const float A[4][4], const float B[4][4]) {
+static void mat_add_4x4_4x4(kalman_real res[4][4], const kalman_real A[4][4], const kalman_real B[4][4]) {
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
-            res[i][j] = A[i][j] + B[i][j];
+            res[i][j] = KADD(A[i][j], B[i][j]);
         }
     }
 }
 
 // 4x4 - 4x4 -> 4x4
-static void mat_sub_4x4_4x4(float res[4][4], const float A[4][4], const float B[4][4]) {
+static void mat_sub_4x4_4x4(kalman_real res[4][4], const kalman_real A[4][4], const kalman_real B[4][4]) {
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
-            res[i][j] = A[i][j] - B[i][j];
+            res[i][j] = KSUB(A[i][j], B[i][j]);
         }
     }
 }
 
 // 4x4 Transpose -> 4x4
-static void mat_trans_4x4(float res[4][4], const float A[4][4]) {
+static void mat_trans_4x4(kalman_real res[4][4], const kalman_real A[4][4]) {
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
             res[i][j] = A[j][i];
@@ -48,106 +73,124 @@ static void mat_trans_4x4(float res[4][4], const float A[4][4]) {
 }
 
 // 2x4 * 4x4 -> 2x4
-static void mat_mul_2x4_4x4(float res[2][4], const float A[2][4], const float B[4][4]) {
+static void mat_mul_2x4_4x4(kalman_real res[2][4], const kalman_real A[2][4], const kalman_real B[4][4]) {
     for (int i = 0; i < 2; i++) {
         for (int j = 0; j < 4; j++) {
-            res[i][j] = A[i][0]*B[0][j] + A[i][1]*B[1][j] + A[i][2]*B[2][j] + A[i][3]*B[3][j];
+            res[i][j] = KNORM(KMUL(A[i][0], B[0][j]) + KMUL(A[i][1], B[1][j]) + KMUL(A[i][2], B[2][j]) + KMUL(A[i][3], B[3][j]));
         }
     }
 }
 
 // 4x4 * 4x2 -> 4x2
-static void mat_mul_4x4_4x2(float res[4][2], const float A[4][4], const float B[4][2]) {
+static void mat_mul_4x4_4x2(kalman_real res[4][2], const kalman_real A[4][4], const kalman_real B[4][2]) {
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 2; j++) {
-            res[i][j] = A[i][0]*B[0][j] + A[i][1]*B[1][j] + A[i][2]*B[2][j] + A[i][3]*B[3][j];
+            res[i][j] = KNORM(KMUL(A[i][0], B[0][j]) + KMUL(A[i][1], B[1][j]) + KMUL(A[i][2], B[2][j]) + KMUL(A[i][3], B[3][j]));
         }
     }
 }
 
 // 2x4 * 4x2 -> 2x2
-static void mat_mul_2x4_4x2(float res[2][2], const float A[2][4], const float B[4][2]) {
+static void mat_mul_2x4_4x2(kalman_real res[2][2], const kalman_real A[2][4], const kalman_real B[4][2]) {
     for (int i = 0; i < 2; i++) {
         for (int j = 0; j < 2; j++) {
-            res[i][j] = A[i][0]*B[0][j] + A[i][1]*B[1][j] + A[i][2]*B[2][j] + A[i][3]*B[3][j];
+            res[i][j] = KNORM(KMUL(A[i][0], B[0][j]) + KMUL(A[i][1], B[1][j]) + KMUL(A[i][2], B[2][j]) + KMUL(A[i][3], B[3][j]));
         }
     }
 }
 
 // 2x2 + 2x2 -> 2x2
-static void mat_add_2x2_2x2(float res[2][2], const float A[2][2], const float B[2][2]) {
-    res[0][0] = A[0][0] + B[0][0];
-    res[0][1] = A[0][1] + B[0][1];
-    res[1][0] = A[1][0] + B[1][0];
-    res[1][1] = A[1][1] + B[1][1];
+static void mat_add_2x2_2x2(kalman_real res[2][2], const kalman_real A[2][2], const kalman_real B[2][2]) {
+    res[0][0] = KADD(A[0][0], B[0][0]);
+    res[0][1] = KADD(A[0][1], B[0][1]);
+    res[1][0] = KADD(A[1][0], B[1][0]);
+    res[1][1] = KADD(A[1][1], B[1][1]);
 }
 
 // 2x2 Transpose -> 2x2 (same as original for 2x2)
-static void mat_trans_2x2(float res[2][2], const float A[2][2]) {
+static void mat_trans_2x2(kalman_real res[2][2], const kalman_real A[2][2]) {
     res[0][0] = A[0][0];
     res[0][1] = A[1][0];
     res[1][0] = A[0][1];
     res[1][1] = A[1][1];
 }
 
+#ifndef IMAGEPROC_FIXED_POINT
 // 2x2 Inverse
-static int mat_inv_2x2(float res[2][2], const float A[2][2]) {
-    float det = A[0][0] * A[1][1] - A[0][1] * A[1][0];
+static int mat_inv_2x2(kalman_real res[2][2], const kalman_real A[2][2]) {
+    kalman_real det = A[0][0] * A[1][1] - A[0][1] * A[1][0];
     if (det == 0.0f) return -1; // Singular matrix
-    float inv_det = 1.0f / det;
+    kalman_real inv_det = 1.0f / det;
     res[0][0] = A[1][1] * inv_det;
     res[0][1] = -A[0][1] * inv_det;
     res[1][0] = -A[1][0] * inv_det;
     res[1][1] = A[0][0] * inv_det;
     return 0;
 }
+#else
+// 定点：K = P_HT * adj(S) / det(S)，不单独求逆（S^-1 的元素很小，Q12 下精度不够）
+// P_HT 与 adj 都是 Q12，乘积 Q24；det 为 Q24，右移成 Q12 后相除得到 Q12 的增益
+static int gain_4x2(kalman_real K[4][2], const kalman_real P_HT[4][2], const kalman_real S[2][2]) {
+    int64_t det = (int64_t)S[0][0] * S[1][1] - (int64_t)S[0][1] * S[1][0];
+    int64_t den = det >> KALMAN_Q;
+    const kalman_real adj[2][2] = { { S[1][1], -S[0][1] }, { -S[1][0], S[0][0] } };
+    if (den == 0) return -1; // Singular matrix
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 2; j++) {
+            int64_t num = (int64_t)P_HT[i][0] * adj[0][j] + (int64_t)P_HT[i][1] * adj[1][j];
+            K[i][j] = kalman_sat(num / den);
+        }
+    }
+    return 0;
+}
+#endif
 
 // 4x1 + 4x1 -> 4x1
-static void vec_add_4x1(float res[4], const float A[4], const float B[4]) {
-    res[0] = A[0] + B[0];
-    res[1] = A[1] + B[1];
-    res[2] = A[2] + B[2];
-    res[3] = A[3] + B[3];
+static void vec_add_4x1(kalman_real res[4], const kalman_real A[4], const kalman_real B[4]) {
+    res[0] = KADD(A[0], B[0]);
+    res[1] = KADD(A[1], B[1]);
+    res[2] = KADD(A[2], B[2]);
+    res[3] = KADD(A[3], B[3]);
 }
 
 // 2x1 - 2x1 -> 2x1
-static void vec_sub_2x1(float res[2], const float A[2], const float B[2]) {
-    res[0] = A[0] - B[0];
-    res[1] = A[1] - B[1];
+static void vec_sub_2x1(kalman_real res[2], const kalman_real A[2], const kalman_real B[2]) {
+    res[0] = KSUB(A[0], B[0]);
+    res[1] = KSUB(A[1], B[1]);
 }
 
 // 4x2 * 2x1 -> 4x1
-static void mat_mul_4x2_2x1(float res[4], const float A[4][2], const float B[2]) {
-    res[0] = A[0][0]*B[0] + A[0][1]*B[1];
-    res[1] = A[1][0]*B[0] + A[1][1]*B[1];
-    res[2] = A[2][0]*B[0] + A[2][1]*B[1];
-    res[3] = A[3][0]*B[0] + A[3][1]*B[1];
+static void mat_mul_4x2_2x1(kalman_real res[4], const kalman_real A[4][2], const kalman_real B[2]) {
+    res[0] = KNORM(KMUL(A[0][0], B[0]) + KMUL(A[0][1], B[1]));
+    res[1] = KNORM(KMUL(A[1][0], B[0]) + KMUL(A[1][1], B[1]));
+    res[2] = KNORM(KMUL(A[2][0], B[0]) + KMUL(A[2][1], B[1]));
+    res[3] = KNORM(KMUL(A[3][0], B[0]) + KMUL(A[3][1], B[1]));
 }
 
 // 2x4 * 4x1 -> 2x1
-static void mat_mul_2x4_4x1(float res[2], const float A[2][4], const float B[4]) {
-    res[0] = A[0][0]*B[0] + A[0][1]*B[1] + A[0][2]*B[2] + A[0][3]*B[3];
-    res[1] = A[1][0]*B[0] + A[1][1]*B[1] + A[1][2]*B[2] + A[1][3]*B[3];
+static void mat_mul_2x4_4x1(kalman_real res[2], const kalman_real A[2][4], const kalman_real B[4]) {
+    res[0] = KNORM(KMUL(A[0][0], B[0]) + KMUL(A[0][1], B[1]) + KMUL(A[0][2], B[2]) + KMUL(A[0][3], B[3]));
+    res[1] = KNORM(KMUL(A[1][0], B[0]) + KMUL(A[1][1], B[1]) + KMUL(A[1][2], B[2]) + KMUL(A[1][3], B[3]));
 }
 
 
-void kalman_init(KalmanFilter* kf, float initial_x, float initial_y, float process_noise, float measurement_noise) {
+void kalman_init(KalmanFilter* kf, kalman_real initial_x, kalman_real initial_y, kalman_real process_noise, kalman_real measurement_noise) {
     // 初始化状态向量 [x, y, vx, vy]
     kf->x[0] = initial_x;
     kf->x[1] = initial_y;
-    kf->x[2] = 0.0f;
-    kf->x[3] = 0.0f;
+    kf->x[2] = KALMAN_CONST(0.0f);
+    kf->x[3] = KALMAN_CONST(0.0f);
 
     // 初始化状态协方差矩阵 P (较大的不确定性)
     memset(kf->P, 0, sizeof(kf->P));
-    kf->P[0][0] = 1.0f;
-    kf->P[1][1] = 1.0f;
-    kf->P[2][2] = 1000.0f;
-    kf->P[3][3] = 1000.0f;
+    kf->P[0][0] = KALMAN_CONST(1.0f);
+    kf->P[1][1] = KALMAN_CONST(1.0f);
+    kf->P[2][2] = KALMAN_CONST(1000.0f);
+    kf->P[3][3] = KALMAN_CONST(1000.0f);
 
     // 初始化过程噪声协方差矩阵 Q
     memset(kf->Q, 0, sizeof(kf->Q));
-    float q = process_noise;
+    kalman_real q = process_noise;
     kf->Q[0][0] = q;
     kf->Q[1][1] = q;
     kf->Q[2][2] = q;
@@ -160,94 +203,317 @@ void kalman_init(KalmanFilter* kf, float initial_x, float initial_y, float proce
 
     // 初始化测量矩阵 H
     memset(kf->H, 0, sizeof(kf->H));
-    kf->H[0][0] = 1.0f;
-    kf->H[1][1] = 1.0f;
+    kf->H[0][0] = KALMAN_CONST(1.0f);
+    kf->H[1][1] = KALMAN_CONST(1.0f);
+
+    // 默认完整滤波
+    memset(kf->K_ss, 0, sizeof(kf->K_ss));
+    kf->steady_warmup = 0;
+    kf->updates = 0;
+}
+
+// 稳态模式是否已接管（完整滤波已做满 steady_warmup 次更新）
+static int kalman_steady_active(const KalmanFilter* kf) {
+    return kf->steady_warmup != 0 && kf->updates >= kf->steady_warmup;
 }
 
-void kalman_predict(KalmanFilter* kf, float dt) {
-    // 状态转移矩阵 F
-    float F[4][4] = {
-        {1.0f, 0.0f, dt,   0.0f},
-        {0.0f, 1.0f, 0.0f, dt  },
-        {0.0f, 0.0f, 1.0f, 0.0f},
-        {0.0f, 0.0f, 0.0f, 1.0f}
+// 状态转移矩阵 F（匀速模型）
+static void kalman_transition(kalman_real F[4][4], kalman_real dt) {
+    const kalman_real one = KALMAN_CONST(1.0f), zero = KALMAN_CONST(0.0f);
+    const kalman_real f[4][4] = {
+        {one,  zero, dt,   zero},
+        {zero, one,  zero, dt  },
+        {zero, zero, one,  zero},
+        {zero, zero, zero, one }
     };
+    memcpy(F, f, sizeof(f));
+}
+
+// 完整预测：x = F * x，P = F * P * F^T + Q
+static void kalman_predict_full(KalmanFilter* kf, kalman_real dt) {
+    kalman_real F[4][4];
+    kalman_transition(F, dt);
 
     // 预测状态: x_hat = F * x
-    float x_hat[4];
+    kalman_real x_hat[4];
     mat_mul_4x4_4x1(x_hat, F, kf->x);
     memcpy(kf->x, x_hat, sizeof(x_hat));
 
     // 预测协方差: P = F * P * F^T + Q
-    float F_T[4][4];
+    kalman_real F_T[4][4];
     mat_trans_4x4(F_T, F);
-    float temp_P[4][4];
+    kalman_real temp_P[4][4];
     mat_mul_4x4_4x4(temp_P, F, kf->P);
     mat_mul_4x4_4x4(kf->P, temp_P, F_T);
     mat_add_4x4_4x4(kf->P, kf->P, kf->Q);
 }
 
-void kalman_update(KalmanFilter* kf, float measurement[2]) {
-    // 计算卡尔曼增益 K = P * H^T * (H * P * H^T + R)^-1
-    float H_T[4][2];
+// 卡尔曼增益 K = P * H^T * (H * P * H^T + R)^-1；S 不可逆时返回 -1
+static int kalman_gain(const KalmanFilter* kf, kalman_real K[4][2]) {
+    kalman_real H_T[4][2];
     // H is 2x4, H_T is 4x2
     H_T[0][0] = kf->H[0][0]; H_T[0][1] = kf->H[1][0];
     H_T[1][0] = kf->H[0][1]; H_T[1][1] = kf->H[1][1];
     H_T[2][0] = kf->H[0][2]; H_T[2][1] = kf->H[1][2];
     H_T[3][0] = kf->H[0][3]; H_T[3][1] = kf->H[1][3];
 
-    float P_HT[4][2];
+    kalman_real P_HT[4][2];
     mat_mul_4x4_4x2(P_HT, kf->P, H_T);
 
-    float H_P_HT[2][2];
+    kalman_real H_P_HT[2][2];
     mat_mul_2x4_4x2(H_P_HT, kf->H, P_HT);
 
-    float S[2][2];
+    kalman_real S[2][2];
     mat_add_2x2_2x2(S, H_P_HT, kf->R);
 
-    float S_inv[2][2];
+#ifndef IMAGEPROC_FIXED_POINT
+    kalman_real S_inv[2][2];
     if (mat_inv_2x2(S_inv, S) != 0) {
-        // 矩阵不可逆，跳过更新
-        return;
+        return -1;
     }
 
-    float K[4][2]; // Kalman Gain
     // Corrected: K = P_HT * S_inv (4x2 * 2x2 -> 4x2)
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 2; j++) {
-            K[i][j] = P_HT[i][0]*S_inv[0][j] + P_HT[i][1]*S_inv[1][j];
+            K[i][j] = KNORM(KMUL(P_HT[i][0], S_inv[0][j]) + KMUL(P_HT[i][1], S_inv[1][j]));
         }
     }
+    return 0;
+#else
+    return gain_4x2(K, P_HT, S);
+#endif
+}
 
-    // 更新状态: x = x + K * (z - H * x)
-    float H_x[2];
+// 更新状态: x = x + K * (z - H * x)
+static void kalman_correct(KalmanFilter* kf, const kalman_real K[4][2], const kalman_real measurement[2]) {
+    kalman_real H_x[2];
     mat_mul_2x4_4x1(H_x, kf->H, kf->x);
 
-    float y[2]; // Innovation
+    kalman_real y[2]; // Innovation
     vec_sub_2x1(y, measurement, H_x);
 
-    float K_y[4];
+    kalman_real K_y[4];
     mat_mul_4x2_2x1(K_y, K, y);
 
     vec_add_4x1(kf->x, kf->x, K_y);
+}
 
-    kf->x[0] = kf->x[0];
-    kf->x[1] = kf->x[1];
-
-    // 更新协方差: P = (I - K * H) * P
-    float K_H[4][4];
+// 更新协方差: P = (I - K * H) * P
+static void kalman_correct_cov(KalmanFilter* kf, const kalman_real K[4][2]) {
+    kalman_real K_H[4][4];
     // Corrected: K_H = K * H (4x2 * 2x4 -> 4x4)
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
-            K_H[i][j] = K[i][0]*kf->H[0][j] + K[i][1]*kf->H[1][j];
+            K_H[i][j] = KNORM(KMUL(K[i][0], kf->H[0][j]) + KMUL(K[i][1], kf->H[1][j]));
         }
     }
 
-    float I_KH[4][4];
-    float I[4][4] = {{1.0f,0.0f,0.0f,0.0f},{0.0f,1.0f,0.0f,0.0f},{0.0f,0.0f,1.0f,0.0f},{0.0f,0.0f,0.0f,1.0f}};
+    kalman_real I_KH[4][4];
+    const kalman_real one = KALMAN_CONST(1.0f), zero = KALMAN_CONST(0.0f);
+    kalman_real I[4][4] = {{one,zero,zero,zero},{zero,one,zero,zero},{zero,zero,one,zero},{zero,zero,zero,one}};
     mat_sub_4x4_4x4(I_KH, I, K_H);
 
-    float temp_P[4][4];
+    kalman_real temp_P[4][4];
     memcpy(temp_P, kf->P, sizeof(temp_P));
     mat_mul_4x4_4x4(kf->P, I_KH, temp_P);
-}
\ No newline at end of file
+}
+
+void kalman_predict(KalmanFilter* kf, kalman_real dt) {
+    if (kalman_steady_active(kf)) {
+        // 稳态：协方差已收敛，只推进状态 x += dt * v
+        kf->x[0] = KADD(kf->x[0], KNORM(KMUL(dt, kf->x[2])));
+        kf->x[1] = KADD(kf->x[1], KNORM(KMUL(dt, kf->x[3])));
+        return;
+    }
+    kalman_predict_full(kf, dt);
+}
+
+void kalman_update(KalmanFilter* kf, kalman_real measurement[2]) {
+    if (kalman_steady_active(kf)) {
+        kalman_correct(kf, kf->K_ss, measurement);
+        return;
+    }
+
+    kalman_real K[4][2]; // Kalman Gain
+    if (kalman_gain(kf, K) != 0) {
+        // 矩阵不可逆，跳过更新
+        return;
+    }
+    kalman_correct(kf, K, measurement);
+    kalman_correct_cov(kf, K);
+    if (kf->updates < UINT16_MAX) kf->updates++;
+}
+
+int kalman_steady_gain(const KalmanFilter* kf, kalman_real dt, kalman_real K[4][2]) {
+    // 在副本上迭代 Riccati 方程（只传播协方差，不需要测量），直到增益不再变化
+    KalmanFilter s = *kf;
+    kalman_real prev[4][2];
+    for (int it = 0; it < KALMAN_STEADY_MAX_ITER; it++) {
+        kalman_predict_full(&s, dt);
+        if (kalman_gain(&s, K) != 0) return -1;
+        kalman_correct_cov(&s, K);
+        if (it > 0) {
+            int converged = 1;
+            for (int i = 0; i < 4 && converged; i++) {
+                for (int j = 0; j < 2; j++) {
+                    kalman_real d = K[i][j] - prev[i][j];
+                    if (d < 0) d = -d;
+                    if (d > KALMAN_STEADY_TOL) { converged = 0; break; }
+                }
+            }
+            if (converged) return 0;
+        }
+        memcpy(prev, K, sizeof(prev));
+    }
+    return -1;
+}
+
+void kalman_steady_set(KalmanFilter* kf, const kalman_real K[4][2], uint16_t warmup) {
+    memcpy(kf->K_ss, K, sizeof(kf->K_ss));
+    kf->steady_warmup = warmup ? warmup : 1;
+}
+
+int kalman_steady_enable(KalmanFilter* kf, kalman_real dt, uint16_t warmup) {
+    kalman_real K[4][2];
+    if (kalman_steady_gain(kf, dt, K) != 0) return -1;
+    kalman_steady_set(kf, K, warmup);
+    return 0;
+}
+
+// ---- KalmanBank ----
+
+void kalman_bank_init(KalmanBank* b, uint8_t n, kalman_real process_noise, kalman_real measurement_noise,
+                      uint8_t max_loss, kalman_real gate) {
+    memset(b, 0, sizeof(*b));
+    b->n = n > KALMAN_BANK_MAX ? KALMAN_BANK_MAX : n;
+    b->max_loss = max_loss;
+    b->q = process_noise;
+    b->r = measurement_noise;
+    b->gate = gate;
+}
+
+// 以观测初始化第 i 路（与 kalman_init 的初值相同）
+static void kalman_bank_start(KalmanBank* b, int i, kalman_real zx, kalman_real zy) {
+    b->x[i] = zx;
+    b->y[i] = zy;
+    b->vx[i] = KALMAN_CONST(0.0f);
+    b->vy[i] = KALMAN_CONST(0.0f);
+    b->px_pp[i] = KALMAN_CONST(1.0f);
+    b->px_pv[i] = KALMAN_CONST(0.0f);
+    b->px_vv[i] = KALMAN_CONST(1000.0f);
+    b->py_pp[i] = KALMAN_CONST(1.0f);
+    b->py_pv[i] = KALMAN_CONST(0.0f);
+    b->py_vv[i] = KALMAN_CONST(1000.0f);
+    b->loss[i] = 0;
+    b->active |= 1u << i;
+}
+
+void kalman_bank_predict(KalmanBank* b, kalman_real dt) {
+    const int n = b->n;
+    const kalman_real q = b->q;
+    const kalman_real zero = KALMAN_CONST(0.0f);
+    for (int i = 0; i < n; i++) {
+        // 未激活的路以 dt = 0、q = 0 推进，即保持不变（循环内无分支）
+        const int on = (int)((b->active >> i) & 1u);
+        const kalman_real t = on ? dt : zero;
+        const kalman_real qi = on ? q : zero;
+        // x = x + dt·v；P = F P F^T + Q（每轴 [p, v] 的 2×2 块）
+        b->x[i] = KADD(b->x[i], KNORM(KMUL(t, b->vx[i])));
+        b->y[i] = KADD(b->y[i], KNORM(KMUL(t, b->vy[i])));
+
+        kalman_real pv = KADD(b->px_pv[i], KNORM(KMUL(t, b->px_vv[i])));
+        b->px_pp[i] = KADD(KADD(b->px_pp[i], KNORM(KMUL(t, b->px_pv[i]) + KMUL(t, pv))), qi);
+        b->px_pv[i] = pv;
+        b->px_vv[i] = KADD(b->px_vv[i], qi);
+
+        pv = KADD(b->py_pv[i], KNORM(KMUL(t, b->py_vv[i])));
+        b->py_pp[i] = KADD(KADD(b->py_pp[i], KNORM(KMUL(t, b->py_pv[i]) + KMUL(t, pv))), qi);
+        b->py_pv[i] = pv;
+        b->py_vv[i] = KADD(b->py_vv[i], qi);
+    }
+}
+
+uint32_t kalman_bank_update(KalmanBank* b, const kalman_real* zx, const kalman_real* zy, uint32_t valid) {
+    const int n = b->n;
+    const kalman_real r = b->r;
+    const kalman_real zero = KALMAN_CONST(0.0f);
+    const uint32_t lanes = (n >= 32) ? 0xFFFFFFFFu : ((1u << n) - 1u);
+    kalman_real ex[KALMAN_BANK_MAX], ey[KALMAN_BANK_MAX];
+    kalman_real use[KALMAN_BANK_MAX]; // 本帧接受观测的路为 1，其余为 0
+    uint32_t accept, rejected;
+
+    valid &= lanes;
+
+    // 1. 新息与马氏距离平方：S = diag(Pxx + r, Pyy + r)，d² = ex²/Sx + ey²/Sy
+    for (int i = 0; i < n; i++) {
+        ex[i] = KSUB(zx[i], b->x[i]);
+        ey[i] = KSUB(zy[i], b->y[i]);
+        b->d2[i] = KADD(KDIV_ACC(KMUL(ex[i], ex[i]), KADD(b->px_pp[i], r)),
+                        KDIV_ACC(KMUL(ey[i], ey[i]), KADD(b->py_pp[i], r)));
+    }
+
+    // 2. 门控与生命周期（位运算，逐路只处理状态切换）
+    accept = valid & b->active;
+    rejected = 0;
+    if (b->gate > zero) {
+        for (int i = 0; i < n; i++) {
+            if (((accept >> i) & 1u) && b->d2[i] > b->gate) rejected |= 1u << i;
+        }
+        accept &= ~rejected;
+    }
+    {
+        const uint32_t start = valid & ~b->active;
+        const uint32_t miss = b->active & ~accept;
+        for (int i = 0; i < n; i++) {
+            const uint32_t bit = 1u << i;
+            use[i] = (accept & bit) ? KALMAN_CONST(1.0f) : zero;
+            if (accept & bit) {
+                b->loss[i] = 0;
+            } else if (miss & bit) {
+                if (++b->loss[i] >= b->max_loss) {
+                    b->active &= ~bit;
+                    b->loss[i] = 0;
+                }
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            if (start & (1u << i)) kalman_bank_start(b, i, zx[i], zy[i]);
+        }
+    }
+
+    // 3. 更新（未接受的路增益乘 0，循环内无分支）
+    //    K = [Ppp, Ppv] / S；x += K·e；P = (I - K H) P
+    for (int i = 0; i < n; i++) {
+        kalman_real s, kp, kv;
+
+        s = KADD(b->px_pp[i], r);
+        kp = KDIV(b->px_pp[i], s); // s ≥ r > 0
+        kv = KDIV(b->px_pv[i], s);
+        kp = KNORM(KMUL(kp, use[i]));
+        kv = KNORM(KMUL(kv, use[i]));
+        b->x[i] = KADD(b->x[i], KNORM(KMUL(kp, ex[i])));
+        b->vx[i] = KADD(b->vx[i], KNORM(KMUL(kv, ex[i])));
+        b->px_vv[i] = KSUB(b->px_vv[i], KNORM(KMUL(kv, b->px_pv[i])));
+        b->px_pv[i] = KSUB(b->px_pv[i], KNORM(KMUL(kp, b->px_pv[i])));
+        b->px_pp[i] = KSUB(b->px_pp[i], KNORM(KMUL(kp, b->px_pp[i])));
+
+        s = KADD(b->py_pp[i], r);
+        kp = KDIV(b->py_pp[i], s); // s ≥ r > 0
+        kv = KDIV(b->py_pv[i], s);
+        kp = KNORM(KMUL(kp, use[i]));
+        kv = KNORM(KMUL(kv, use[i]));
+        b->y[i] = KADD(b->y[i], KNORM(KMUL(kp, ey[i])));
+        b->vy[i] = KADD(b->vy[i], KNORM(KMUL(kv, ey[i])));
+        b->py_vv[i] = KSUB(b->py_vv[i], KNORM(KMUL(kv, b->py_pv[i])));
+        b->py_pv[i] = KSUB(b->py_pv[i], KNORM(KMUL(kp, b->py_pv[i])));
+        b->py_pp[i] = KSUB(b->py_pp[i], KNORM(KMUL(kp, b->py_pp[i])));
+    }
+    return rejected;
+}
+
+void kalman_bank_release(KalmanBank* b, uint32_t mask) {
+    for (int i = 0; i < b->n; i++) {
+        if (mask & (1u << i)) b->loss[i] = 0;
+    }
+    b->active &= ~mask;
+}
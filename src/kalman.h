@@ -2,14 +2,46 @@
 #define KALMAN_H
 
 #include <stdint.h>
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 数值类型：默认 float；定点 profile（IMAGEPROC_FIXED_POINT）下为 Q19.12 的 int32，
+// 乘积在 int64 中累加后舍入、饱和回 int32
+#ifdef IMAGEPROC_FIXED_POINT
+#define KALMAN_Q 12
+typedef int32_t kalman_real;
+#define KALMAN_CONST(f)    ((kalman_real)((f) * (1 << KALMAN_Q) + ((f) < 0 ? -0.5 : 0.5))) // 编译期常量
+#define KALMAN_FROM_INT(v) ((kalman_real)(v) * (1 << KALMAN_Q))
+#define KALMAN_TO_INT(v)   ((int32_t)((v) / (1 << KALMAN_Q)))                                // 向零截断，与浮点版一致
+#define KALMAN_STEADY_TOL  1                                                               // 稳态增益收敛阈值（1 LSB）
+#else
+typedef float kalman_real;
+#define KALMAN_CONST(f)    ((float)(f))
+#define KALMAN_FROM_INT(v) ((float)(v))
+#define KALMAN_TO_INT(v)   ((int32_t)(v))                                                  // 与 (uint8_t)x 的截断一致
+#define KALMAN_STEADY_TOL  1e-6f
+#endif
+
+#define KALMAN_STEADY_MAX_ITER 1000 // Riccati 迭代上限
 
 // 定义卡尔曼滤波器结构体
+//
+// 稳态增益模式：Q、R、H 与 dt 都不变时，增益 K 会收敛到常数。kalman_steady_enable 在初始化时迭代
+// Riccati 方程求出稳态增益；此后前 steady_warmup 次更新仍走完整滤波（协方差从初值收敛的过程），
+// 之后 predict 只推进 x += dt·v，update 只做 x += K_ss·(z - Hx)，不再传播协方差。
+// 稳态期间预测不再放大 P，连续丢失后重新捕获时仍用稳态增益；丢失超过阈值后重新 kalman_init 即回到完整滤波。
 typedef struct {
-    float x[4]; // 状态向量 [x, y, vx, vy]
-    float P[4][4]; // 状态协方差矩阵
-    float Q[4][4]; // 过程噪声协方差矩阵
-    float R[2][2]; // 测量噪声协方差矩阵
-    float H[2][4]; // 测量矩阵
+    kalman_real x[4]; // 状态向量 [x, y, vx, vy]
+    kalman_real P[4][4]; // 状态协方差矩阵
+    kalman_real Q[4][4]; // 过程噪声协方差矩阵
+    kalman_real R[2][2]; // 测量噪声协方差矩阵
+    kalman_real H[2][4]; // 测量矩阵
+    kalman_real K_ss[4][2]; // 稳态增益（steady_warmup != 0 时有效）
+    uint16_t steady_warmup; // 0 = 关闭稳态模式；否则完整滤波更新这么多次后切换到稳态增益
+    uint16_t updates;       // 自 kalman_init 以来的完整更新次数（饱和）
 } KalmanFilter;
 
 /**
@@ -21,7 +53,7 @@ typedef struct {
  * @param process_noise 过程噪声
  * @param measurement_noise 测量噪声
  */
-void kalman_init(KalmanFilter* kf, float initial_x, float initial_y, float process_noise, float measurement_noise);
+void kalman_init(KalmanFilter* kf, kalman_real initial_x, kalman_real initial_y, kalman_real process_noise, kalman_real measurement_noise);
 
 /**
  * @brief 卡尔曼滤波器预测步骤
@@ -29,7 +61,7 @@ void kalman_init(KalmanFilter* kf, float initial_x, float initial_y, float proce
  * @param kf 指向 KalmanFilter 结构体的指针
  * @param dt 时间间隔
  */
-void kalman_predict(KalmanFilter* kf, float dt);
+void kalman_predict(KalmanFilter* kf, kalman_real dt);
 
 /**
  * @brief 卡尔曼滤波器更新步骤
@@ -37,6 +69,88 @@ void kalman_predict(KalmanFilter* kf, float dt);
  * @param kf 指向 KalmanFilter 结构体的指针
  * @param measurement 测量值 [x, y]
  */
-void kalman_update(KalmanFilter* kf, float measurement[2]);
+void kalman_update(KalmanFilter* kf, kalman_real measurement[2]);
+
+/**
+ * @brief 迭代 Riccati 方程求稳态增益（不修改 kf）
+ *
+ * @param kf 已 kalman_init 的滤波器（使用其 P、Q、R、H）
+ * @param dt 时间间隔
+ * @param K 输出稳态增益
+ * @return 0 收敛；-1 不收敛或 S 不可逆
+ */
+int kalman_steady_gain(const KalmanFilter* kf, kalman_real dt, kalman_real K[4][2]);
+
+/**
+ * @brief 使用预先求好的稳态增益（kalman_init 会清除，需在其后调用）
+ *
+ * @param kf 指向 KalmanFilter 结构体的指针
+ * @param K 稳态增益（kalman_steady_gain 的结果，可离线求出后复用）
+ * @param warmup 切换前完整滤波的更新次数（0 按 1 处理）
+ */
+void kalman_steady_set(KalmanFilter* kf, const kalman_real K[4][2], uint16_t warmup);
+
+/**
+ * @brief kalman_steady_gain + kalman_steady_set
+ *
+ * @return 0 成功；-1 不收敛（保持完整滤波）
+ */
+int kalman_steady_enable(KalmanFilter* kf, kalman_real dt, uint16_t warmup);
+
+// ---- 多目标：N 路匀速滤波器（SoA） ----
+//
+// 与 KalmanFilter 同一模型（状态 [x, y, vx, vy]、H 取位置、Q = q·I、R = r·I、P 初值对角），
+// 这种结构下 x、y 两轴互不耦合，4×4 协方差退化为两个对称 2×2 块（每轴 3 个数），
+// 所有路的同一分量连续存放，predict / update 是对各数组的逐元素循环，编译器可直接向量化。
+// 数值与逐个使用 KalmanFilter 一致（浮点下只差运算顺序带来的舍入）。
+//
+// 每路的生命周期与 image.c 中 firstcorner 的用法相同：
+//   有观测且未激活 → 以观测初始化；有观测且已激活 → 门控通过则更新并清零丢失计数；
+//   无观测或被门控拒绝 → 丢失计数 +1，达到 max_loss 后停用。
+#define KALMAN_BANK_MAX 32
+
+typedef struct {
+    uint8_t n;                   // 路数（≤ KALMAN_BANK_MAX）
+    uint8_t max_loss;            // 连续丢失达到该帧数即停用（对应 KALMAN_MAX_LOSS_FRAMES）
+    uint32_t active;             // bit i：第 i 路已初始化
+    kalman_real q;               // 过程噪声（对角）
+    kalman_real r;               // 测量噪声（对角）
+    kalman_real gate;            // 马氏距离平方门限（2 自由度卡方，如 9.21 ≈ 99%），0 = 不门控
+    uint8_t loss[KALMAN_BANK_MAX];
+    kalman_real x[KALMAN_BANK_MAX], y[KALMAN_BANK_MAX];
+    kalman_real vx[KALMAN_BANK_MAX], vy[KALMAN_BANK_MAX];
+    kalman_real px_pp[KALMAN_BANK_MAX], px_pv[KALMAN_BANK_MAX], px_vv[KALMAN_BANK_MAX]; // x 轴 [位置, 速度] 协方差
+    kalman_real py_pp[KALMAN_BANK_MAX], py_pv[KALMAN_BANK_MAX], py_vv[KALMAN_BANK_MAX]; // y 轴
+    kalman_real d2[KALMAN_BANK_MAX]; // 最近一次 update 的马氏距离平方（调试用）
+} KalmanBank;
+
+/**
+ * @brief 初始化 n 路滤波器（全部未激活）
+ *
+ * @param gate 马氏距离平方门限，0 表示不门控
+ */
+void kalman_bank_init(KalmanBank* b, uint8_t n, kalman_real process_noise, kalman_real measurement_noise,
+                      uint8_t max_loss, kalman_real gate);
+
+/**
+ * @brief 所有激活的路预测一步（未激活的路不变）
+ */
+void kalman_bank_predict(KalmanBank* b, kalman_real dt);
+
+/**
+ * @brief 一帧的观测（SoA）：valid 的 bit i 表示第 i 路本帧有观测 (zx[i], zy[i])
+ *
+ * @return 本帧被门控拒绝的路的掩码
+ */
+uint32_t kalman_bank_update(KalmanBank* b, const kalman_real* zx, const kalman_real* zy, uint32_t valid);
+
+/**
+ * @brief 停用 mask 中的路（例如元素切换时主动丢弃）
+ */
+void kalman_bank_release(KalmanBank* b, uint32_t mask);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif // KALMAN_H
@@ -9,6 +9,7 @@
 #include "csv_reader.h"
 #include "oscilloscope.h"
 #include "dynamic_log.h"
+#include "area_downscale.h"
 
 #if defined(HAVE_OPENCV)
     #if (defined(__MINGW32__) || defined(__MINGW64__))
@@ -71,7 +72,9 @@ static void on_size_allocate(GtkWidget *widget, GdkRectangle *allocation, gpoint
 static GdkPixbuf* scale_pixbuf_to_target(GdkPixbuf *pixbuf);
 static GdkPixbuf* scale_pixbuf_to_fit(GdkPixbuf *pixbuf, int max_width, int max_height);
 
-// 从 pixbuf 填充 original_bi_image
+// 二值化阈值：灰度 > GRAY_THRESHOLD 为白
+#define GRAY_THRESHOLD 128
+// 从 pixbuf 填充 Grayscale 与 original_bi_image
 static gboolean pixbuf_to_binary_array(GdkPixbuf *pixbuf);
 
 // 媒体文件处理
@@ -79,7 +82,7 @@ static void open_media_clicked(GtkWidget *widget, gpointer data);
 static gboolean load_png_image(const gchar *filename);
 static gboolean load_jpeg_image(const gchar *filename);
 static GdkPixbuf* render_bw_array_pixbuf(uint8_t **arr, int w, int h, int pixel_size);
-static GdkPixbuf* render_imo_array_pixbuf(uint8_t **arr, int w, int h, int pixel_size);
+static GdkPixbuf* render_imo_array_pixbuf(uint8_t **arr, const overlay_list *overlay, int w, int h, int pixel_size);
 
 #ifdef HAVE_OPENCV
 // 视频导入相关回调
@@ -388,6 +391,8 @@ static GdkPixbuf* scale_pixbuf_to_fit(GdkPixbuf *pixbuf, int max_width, int max_
     return gdk_pixbuf_scale_simple(pixbuf, new_width, new_height, GDK_INTERP_BILINEAR);
 }
 
+// 亮度用整数 BT.601 系数（299/587/114 ‰）计算，写入 Grayscale 供 process_gray_to_imo 直接阈值化打包；
+// original_bi_image 只作左侧二值图显示
 static gboolean pixbuf_to_binary_array(GdkPixbuf *pixbuf) {
     if (!pixbuf) return FALSE;
     int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
@@ -401,13 +406,13 @@ static gboolean pixbuf_to_binary_array(GdkPixbuf *pixbuf) {
             else if (channels == 2) gray = row[x * 2];
             else if (channels == 3) {
                 int r = row[x * 3]; int g = row[x * 3 + 1]; int b = row[x * 3 + 2];
-                gray = (int)(0.299 * r + 0.587 * g + 0.114 * b);
+                gray = (299 * r + 587 * g + 114 * b) / 1000;
             } else {
                 int r = row[x * 4]; int g = row[x * 4 + 1]; int b = row[x * 4 + 2]; int a = row[x * 4 + 3];
-                if (a == 0) { original_bi_image[y][x] = 255; continue; }
-                gray = (int)(0.299 * r + 0.587 * g + 0.114 * b);
+                gray = (a == 0) ? 255 : (299 * r + 587 * g + 114 * b) / 1000;
             }
-            original_bi_image[y][x] = (gray > 128) ? 255 : 0;
+            Grayscale[y][x] = (uint8_t)gray;
+            original_bi_image[y][x] = (gray > GRAY_THRESHOLD) ? 255 : 0;
         }
     }
     return TRUE;
@@ -456,7 +461,7 @@ static gboolean load_png_image(const gchar *filename) {
         
         // 自动处理图像
         allocate_imo_array();
-        process_original_to_imo(&original_bi_image[0][0], &imo[0][0], IMAGE_W, IMAGE_H);
+        process_gray_to_imo(&Grayscale[0][0], IMAGE_W, GRAY_THRESHOLD, &imo[0][0], IMAGE_W, IMAGE_H);
         refresh_all_views();
     }
     return ok;
@@ -490,7 +495,7 @@ static gboolean load_jpeg_image(const gchar *filename) {
         
         // 自动处理图像
         allocate_imo_array();
-        process_original_to_imo(&original_bi_image[0][0], &imo[0][0], IMAGE_W, IMAGE_H);
+        process_gray_to_imo(&Grayscale[0][0], IMAGE_W, GRAY_THRESHOLD, &imo[0][0], IMAGE_W, IMAGE_H);
         refresh_all_views();
     }
     return ok;
@@ -672,36 +677,34 @@ static GdkPixbuf* render_bw_array_pixbuf(uint8_t arr[IMAGE_H][IMAGE_W], int w, i
     return pb;
 }
 
-static GdkPixbuf* render_imo_array_pixbuf(uint8_t arr[IMAGE_H][IMAGE_W], int w, int h, int pixel_size) {
-    if (!arr || w <= 0 || h <= 0) return NULL;
-    int W = w * pixel_size, H = h * pixel_size;
-    GdkPixbuf *pb = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, W, H);
-    if (!pb) return NULL;
-    gdk_pixbuf_fill(pb, 0xffffffff);
+// imo 只含 0/255，标注来自流水线的显示列表：先画二值底图，再只画标注像素
+static GdkPixbuf* render_imo_array_pixbuf(uint8_t arr[IMAGE_H][IMAGE_W], const overlay_list *overlay, int w, int h, int pixel_size) {
+    GdkPixbuf *pb = render_bw_array_pixbuf(arr, w, h, pixel_size);
+    if (!pb || !overlay) return pb;
     int rowstride = gdk_pixbuf_get_rowstride(pb);
     guchar *pixels = gdk_pixbuf_get_pixels(pb);
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            guint32 color;
-            switch (arr[y][x]) {
-                case 0: color = 0xff000000; break;
-                case 1: color = 0xffff0000; break;
-                case 2: color = 0xffffa500; break;
-                case 3: color = 0xffffff00; break;
-                case 4: color = 0xff00ff00; break;
-                case 5: color = 0xff00ffff; break; // 青色
-                case 6: color = 0xffff00ff; break; // 洋红色
-                case 7: color = 0xff0000ff; break; // 蓝色
-                case 8: color = 0xff800080; break; // 紫色
-                case 9: color = 0xffffc0cb; break; // 粉色
-                case 255: default: color = 0xffffffff; break; // 白色
-            }
-            for (int dy = 0; dy < pixel_size; ++dy)
-                for (int dx = 0; dx < pixel_size; ++dx) {
-                    guchar *p = pixels + (y * pixel_size + dy) * rowstride + (x * pixel_size + dx) * 3;
-                    p[0] = (color >> 16) & 0xff; p[1] = (color >> 8) & 0xff; p[2] = color & 0xff;
-                }
+    static overlay_pixel px[OVERLAY_MAX_PIXELS];
+    int n = overlay_rasterize(overlay, px, OVERLAY_MAX_PIXELS);
+    for (int i = 0; i < n; ++i) {
+        if (px[i].x >= w || px[i].y >= h) continue;
+        guint32 color;
+        switch (px[i].color) {
+            case 1: color = 0xffff0000; break;
+            case 2: color = 0xffffa500; break;
+            case 3: color = 0xffffff00; break;
+            case 4: color = 0xff00ff00; break;
+            case 5: color = 0xff00ffff; break; // 青色
+            case 6: color = 0xffff00ff; break; // 洋红色
+            case 7: color = 0xff0000ff; break; // 蓝色
+            case 8: color = 0xff800080; break; // 紫色
+            case 9: color = 0xffffc0cb; break; // 粉色
+            default: color = 0xffffffff; break; // 白色
         }
+        for (int dy = 0; dy < pixel_size; ++dy)
+            for (int dx = 0; dx < pixel_size; ++dx) {
+                guchar *p = pixels + (px[i].y * pixel_size + dy) * rowstride + (px[i].x * pixel_size + dx) * 3;
+                p[0] = (color >> 16) & 0xff; p[1] = (color >> 8) & 0xff; p[2] = color & 0xff;
+            }
     }
     return pb;
 }
@@ -731,7 +734,7 @@ static void refresh_all_views() {
         int max_w = alloc_imo.width > 50 ? alloc_imo.width - 20 : 400;
         int max_h = alloc_imo.height > 50 ? alloc_imo.height - 20 : 300;
         
-        GdkPixbuf *base = render_imo_array_pixbuf(imo, IMAGE_W, IMAGE_H, 2);
+        GdkPixbuf *base = render_imo_array_pixbuf(imo, process_last_overlay(), IMAGE_W, IMAGE_H, 2);
         if (base) {
             GdkPixbuf *scaled = scale_pixbuf_to_fit(base, max_w, max_h);
             if (scaled) {
@@ -774,6 +777,21 @@ static GdkPixbuf* pixbuf_from_rgb_mat_copy(const cv::Mat &rgb)
     return pb;
 }
 
+// 原始帧（BGR/BGRA/灰度）一步区域平均缩小到 Grayscale，按行分块并行；original_bi_image 由灰度阈值化，仅供显示
+static void cv_frame_to_gray_array(const cv::Mat &frame) {
+    area_src_format fmt = (frame.channels() == 1) ? AREA_SRC_GRAY
+                        : (frame.channels() == 4) ? AREA_SRC_BGRA : AREA_SRC_BGR;
+    cv::parallel_for_(cv::Range(0, IMAGE_H), [&](const cv::Range &r) {
+        area_downscale_gray_rows(frame.data, frame.cols, frame.rows, (int)frame.step, fmt,
+                                 &Grayscale[0][0], IMAGE_W, IMAGE_H, IMAGE_W, r.start, r.end);
+    }, 4);
+    for (int y = 0; y < IMAGE_H; y++) {
+        for (int x = 0; x < IMAGE_W; x++) {
+            original_bi_image[y][x] = (Grayscale[y][x] > GRAY_THRESHOLD) ? 255 : 0;
+        }
+    }
+}
+
 static void show_cv_frame(const cv::Mat &frame) {
     // 转换为RGB格式
     cv::Mat bgr; 
@@ -800,21 +818,17 @@ static void show_cv_frame(const cv::Mat &frame) {
             g_object_unref(display_pb);
         }
         
-        // 用于二值化的 pixbuf（固定为 TARGET_WIDTH x TARGET_HEIGHT）
-        GdkPixbuf *scaled = gdk_pixbuf_scale_simple(pb, TARGET_WIDTH, TARGET_HEIGHT, GDK_INTERP_BILINEAR);
-        if (scaled) {
-            pixbuf_to_binary_array(scaled);
-            g_object_unref(scaled);
-        }
+        // 处理用的 188x120 灰度直接由原始帧区域平均得到（不经过全分辨率 RGB 与 pixbuf 缩放）
+        cv_frame_to_gray_array(frame);
         
         g_object_unref(pb);
         
         // 设置当前帧索引（让动态日志知道当前帧号）
         log_set_current_frame(g_frame_index);
         
-        // 自动处理图像：从 original 转换为 imo
+        // 自动处理图像：从灰度直接阈值化打包并生成 imo
         allocate_imo_array();
-        process_original_to_imo(&original_bi_image[0][0], &imo[0][0], IMAGE_W, IMAGE_H);
+        process_gray_to_imo(&Grayscale[0][0], IMAGE_W, GRAY_THRESHOLD, &imo[0][0], IMAGE_W, IMAGE_H);
         
         refresh_all_views();
     }
@@ -1043,9 +1057,9 @@ static void show_cv_frame_OLD(const cv::Mat &frame) {
             pixbuf_to_binary_array(scaled);
             g_object_unref(scaled);
             
-            // 自动处理图像：从 original 转换为 imo
+            // 自动处理图像：从灰度直接阈值化打包并生成 imo
             allocate_imo_array();
-            process_original_to_imo(&original_bi_image[0][0], &imo[0][0], IMAGE_W, IMAGE_H);
+            process_gray_to_imo(&Grayscale[0][0], IMAGE_W, GRAY_THRESHOLD, &imo[0][0], IMAGE_W, IMAGE_H);
             
             refresh_all_views();
         }
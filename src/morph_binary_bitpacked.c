@@ -304,19 +304,263 @@ void morph_clean_u16_binary_adapter(const uint16_t* RESTRICT src_u16,
 }
 
 // 适配器：对 u8 二值图进行形态学处理（开闭运算，可选闭、梯度）
+// 使用模块内静态缓冲，非线程安全；并发场景请使用 morph_clean_u8_binary_buffers
 void morph_clean_u8_binary_adapter(const uint8_t* RESTRICT src_u8,
                                    int width, int height,
                                    uint8_t* RESTRICT dst_u8) {
     // 注意：此函数现在假定图像尺寸不超过静态缓冲区的大小
     // (void)width; (void)height; // 在此实现中，参数仅用于接口兼容性
+    morph_clean_u8_binary_buffers(src_u8, width, height, dst_u8, s_buf1, s_buf2, s_buf3);
+}
 
-    uint32_t* packed_src = s_buf1;
-    uint32_t* tmp_buf    = s_buf2;
-    uint32_t* out_buf    = s_buf3;
-
-    pack_binary_u8_to_bits(src_u8, width, height, width, packed_src);
-    //close_bitpacked(packed_src, tmp_buf, out_buf,  width, height);
-    open_close_bitpacked(packed_src, tmp_buf, out_buf,  width, height);
-    //precise_edge_detection_bitpacked(packed_src, tmp_buf, out_buf, width, height);
+// 适配器（可重入版）：缓冲由调用者提供（如 PipelineContext 内的三块缓冲）
+// 注意：src 先被完整打包到 packed_buf 后才写 dst，因此允许 src_u8 == dst_u8
+void morph_clean_u8_binary_buffers(const uint8_t* src_u8,
+                                   int width, int height,
+                                   uint8_t* dst_u8,
+                                   uint32_t* RESTRICT packed_buf,
+                                   uint32_t* RESTRICT tmp_buf,
+                                   uint32_t* RESTRICT out_buf) {
+    pack_gray_threshold_to_bits(src_u8, width, height, width, 0, packed_buf);
+    //close_bitpacked(packed_buf, tmp_buf, out_buf,  width, height);
+    open_close_bitpacked_fused(packed_buf, tmp_buf, out_buf,  width, height);
+    //precise_edge_detection_bitpacked(packed_buf, tmp_buf, out_buf, width, height);
     unpack_bits_to_binary_u8(out_buf, width, height, dst_u8, width);
-}
\ No newline at end of file
+}
+
+// ---------------- 单遍滚动窗口 开+闭 ----------------
+// 四级流水（腐蚀→膨胀→膨胀→腐蚀），每级只保留 3 行的环形缓冲：
+// 第 k 级收到输入行 r 后即可输出行 r-1（需要 r-2、r-1、r 三行），图像上下越界行按全 0 处理，
+// 与四遍整图版本在每一级输入处补 0 的语义完全相同，因此结果逐位一致。
+// 环形缓冲里存的是已做完水平 1×3 的行，每行只做一次水平运算，纵向只剩 3 行 AND/OR。
+// 整个状态约 450 字节，始终驻留 L1；输入一行最多产出一行，延迟固定为 MORPH_STREAM_LATENCY 行。
+
+static const uint32_t s_zero_row[MORPH_STREAM_MAX_WPR] = {0};
+
+// 水平 1×3：腐蚀取 AND，膨胀取 OR（跨 word 拼接邻位，行首/行尾外按 0）
+static inline void horiz_row_bitpacked(const uint32_t* RESTRICT in, uint32_t* RESTRICT out,
+                                       int wpw, uint32_t tail, int is_dilate) {
+    uint32_t prev = 0u, cur = in[0];
+    for (int i = 0; i < wpw; i++) {
+        uint32_t next = (i + 1 < wpw) ? in[i + 1] : 0u;
+        uint32_t l = (cur << 1) | (prev >> 31);
+        uint32_t r = (cur >> 1) | (next << 31);
+        out[i] = is_dilate ? (l | cur | r) : (l & cur & r);
+        prev = cur;
+        cur = next;
+    }
+    out[wpw - 1] &= tail;
+}
+
+int morph_stream_init(MorphOpenCloseStream* s, int width, int height, uint32_t* out_bits) {
+    memset(s, 0, sizeof(*s));
+    s->width = width;
+    s->height = height;
+    s->wpw = words_per_row(width);
+    s->tail = last_word_mask(width);
+    s->out = out_bits;
+    s->last_row = -1;
+    return (s->wpw <= MORPH_STREAM_MAX_WPR && width > 0 && height > 0) ? 0 : -1;
+}
+
+// 向第 k 级送入一行（row == NULL 表示该级输入结束），并把产出的行继续推给下一级
+static void morph_stream_feed(MorphOpenCloseStream* s, int k, const uint32_t* row) {
+    int n, is_dilate;
+    const uint32_t *a, *b, *c;
+    uint32_t* dst;
+
+    if (k == MORPH_STREAM_STAGES) {
+        // 最后一级的输出已直接写入 s->out（count 只有 MORPH_STREAM_STAGES 项，须先返回再取）
+        if (row) s->last_row++;
+        return;
+    }
+    n = s->count[k];
+    is_dilate = (k == 1 || k == 2);
+
+    if (row) {
+        horiz_row_bitpacked(row, s->ring[k][n % 3], s->wpw, s->tail, is_dilate);
+        s->count[k] = ++n;
+        if (n < 2) return;
+        a = n >= 3 ? s->ring[k][(n - 3) % 3] : s_zero_row;
+        b = s->ring[k][(n - 2) % 3];
+        c = s->ring[k][(n - 1) % 3];
+    } else {
+        if (n < 1) {
+            morph_stream_feed(s, k + 1, NULL);
+            return;
+        }
+        a = n >= 2 ? s->ring[k][(n - 2) % 3] : s_zero_row;
+        b = s->ring[k][(n - 1) % 3];
+        c = s_zero_row;
+    }
+
+    // 纵向 3×1；最后一级直接写目标行，其余写入临时行后送下一级
+    dst = (k == MORPH_STREAM_STAGES - 1) ? s->out + (size_t)(s->last_row + 1) * s->wpw : s->scratch;
+    if (is_dilate) {
+        for (int i = 0; i < s->wpw; i++) dst[i] = a[i] | b[i] | c[i];
+    } else {
+        for (int i = 0; i < s->wpw; i++) dst[i] = a[i] & b[i] & c[i];
+    }
+    morph_stream_feed(s, k + 1, dst);
+    if (!row) morph_stream_feed(s, k + 1, NULL);
+}
+int morph_stream_push_row(MorphOpenCloseStream* s, const uint32_t* row_bits) {
+    if (s->count[0] >= s->height) return s->last_row;
+    morph_stream_feed(s, 0, row_bits);
+    if (s->count[0] == s->height) morph_stream_feed(s, 0, NULL); // 最后一行：冲刷所有级
+    return s->last_row;
+}
+
+// 整图接口：与 open_close_bitpacked 参数一致；tmp1_bits 仅在宽度超出流式缓冲时回退到四遍版本使用
+void open_close_bitpacked_fused(const uint32_t* RESTRICT src_bits,
+                                uint32_t* RESTRICT tmp1_bits,
+                                uint32_t* RESTRICT out_bits,
+                                int width, int height) {
+    MorphOpenCloseStream s;
+    int wpw = words_per_row(width);
+    if (open_close_bitpacked_simd(src_bits, out_bits, width, height) == 0) {
+        return; // 已由 SIMD 寄存器驻留版本完成
+    }
+    if (morph_stream_init(&s, width, height, out_bits) != 0) {
+        open_close_bitpacked(src_bits, tmp1_bits, out_bits, width, height);
+        return;
+    }
+    for (int y = 0; y < height; y++) {
+        morph_stream_push_row(&s, src_bits + (size_t)y * wpw);
+    }
+}
+
+// ---------------- 帧批量位切片形态学（离线回放） ----------------
+// 位切片布局：sliced[y * width + x] 的 bit f 表示批内第 f 帧的像素 (x, y)，一批最多 64 帧。
+// 3×3 邻域运算对所有帧完全相同，因此一次 64 位 AND/OR 同时完成 64 帧的腐蚀/膨胀，
+// 边界同样按 0 处理，结果与逐帧的 open_close_bitpacked 逐位一致。
+// 逐帧布局 ↔ 位切片布局的转换用 64×64 位矩阵转置（每 32 个像素 × 64 帧一块）。
+
+// 64×64 位矩阵原地转置：转置后 a[i] 的 bit j = 转置前 a[j] 的 bit i
+static void transpose64(uint64_t a[64]) {
+    static const uint64_t masks[6] = {
+        0x00000000FFFFFFFFull, 0x0000FFFF0000FFFFull, 0x00FF00FF00FF00FFull,
+        0x0F0F0F0F0F0F0F0Full, 0x3333333333333333ull, 0x5555555555555555ull,
+    };
+    // 每一轮交换相距 j 行、相距 j 位的两个 j×j 子块；内层循环连续，编译器可向量化
+    for (int s = 0, j = 32; s < 6; s++, j >>= 1) {
+        uint64_t m = masks[s];
+        for (int b = 0; b < 64; b += 2 * j) {
+            for (int k = b; k < b + j; k++) {
+                uint64_t t = ((a[k] >> j) ^ a[k + j]) & m;
+                a[k] ^= t << j;
+                a[k + j] ^= t;
+            }
+        }
+    }
+}
+
+void morph_batch_pack(const uint32_t* frames_bits, int nframes, int width, int height, uint64_t* sliced) {
+    int wpw = words_per_row(width);
+    size_t stride = (size_t)total_words(width, height);
+    uint64_t blk[64];
+    if (morph_batch_pack_simd(frames_bits, nframes, width, height, sliced) == 0) return;
+    for (int y = 0; y < height; y++) {
+        for (int i = 0; i < wpw; i++) {
+            int n = width - (i << 5);
+            for (int f = 0; f < 64; f++) {
+                blk[f] = (f < nframes) ? frames_bits[(size_t)f * stride + (size_t)y * wpw + i] : 0u;
+            }
+            transpose64(blk);
+            if (n > 32) n = 32;
+            memcpy(sliced + (size_t)y * width + (i << 5), blk, (size_t)n * sizeof(uint64_t));
+        }
+    }
+}
+
+void morph_batch_unpack(const uint64_t* sliced, int nframes, int width, int height, uint32_t* frames_bits) {
+    int wpw = words_per_row(width);
+    size_t stride = (size_t)total_words(width, height);
+    uint64_t blk[64];
+    if (morph_batch_unpack_simd(sliced, nframes, width, height, frames_bits) == 0) return;
+    for (int y = 0; y < height; y++) {
+        for (int i = 0; i < wpw; i++) {
+            int n = width - (i << 5);
+            if (n > 32) n = 32;
+            memcpy(blk, sliced + (size_t)y * width + (i << 5), (size_t)n * sizeof(uint64_t));
+            memset(blk + n, 0, (size_t)(64 - n) * sizeof(uint64_t));
+            transpose64(blk);
+            for (int f = 0; f < nframes; f++) {
+                frames_bits[(size_t)f * stride + (size_t)y * wpw + i] = (uint32_t)blk[f];
+            }
+        }
+    }
+}
+
+// 水平 1×3（行首/行尾外按 0）；内部循环无分支，便于编译器向量化（AVX2 下一条指令处理 4 个像素 × 64 帧）
+static inline void sliced_horiz(const uint64_t* RESTRICT in, uint64_t* RESTRICT out, int width, int is_dilate) {
+    if (width == 1) {
+        out[0] = is_dilate ? in[0] : 0u;
+        return;
+    }
+    if (is_dilate) {
+        out[0] = in[0] | in[1];
+        for (int x = 1; x < width - 1; x++) out[x] = in[x - 1] | in[x] | in[x + 1];
+        out[width - 1] = in[width - 2] | in[width - 1];
+    } else {
+        out[0] = 0u;
+        for (int x = 1; x < width - 1; x++) out[x] = in[x - 1] & in[x] & in[x + 1];
+        out[width - 1] = 0u;
+    }
+}
+
+static inline void sliced_vert(const uint64_t* a, const uint64_t* b, const uint64_t* c,
+                               uint64_t* RESTRICT out, int width, int is_dilate) {
+    if (is_dilate) {
+        for (int x = 0; x < width; x++) out[x] = a[x] | b[x] | c[x];
+    } else {
+        for (int x = 0; x < width; x++) out[x] = a[x] & b[x] & c[x];
+    }
+}
+
+// 位切片 开→闭：与单遍滚动窗口版相同的四级流水，每级保留 3 行水平结果
+// 第 t 步第 k 级的输入行号为 t-k，越界（≥height）时输入全 0；第 3 级输出行 t-4
+void open_close_bitsliced(const uint64_t* src, uint64_t* out, int width, int height, uint64_t* work) {
+    uint64_t* ring[4][3];
+    uint64_t* scratch = work + (size_t)12 * width;
+    uint64_t* zero = work + (size_t)13 * width;
+    if (width <= 0 || height <= 0) return;
+    if (open_close_bitsliced_simd(src, out, width, height, work) == 0) return; // AVX2：一次 4 个像素
+    for (int k = 0; k < 4; k++) {
+        for (int r = 0; r < 3; r++) ring[k][r] = work + (size_t)(k * 3 + r) * width;
+    }
+    memset(zero, 0, (size_t)width * sizeof(uint64_t));
+
+    for (int t = 0; t < height + 4; t++) {
+        const uint64_t* x = (t < height) ? src + (size_t)t * width : zero;
+        for (int k = 0; k < 4; k++) {
+            int idx = t - k;
+            int is_dilate = (k == 1 || k == 2);
+            uint64_t *c, *dst;
+            if (idx < 0) break;
+            if (idx >= height) x = zero;
+            c = ring[k][idx % 3];
+            sliced_horiz(x, c, width, is_dilate);
+            if (idx < 1) break; // 输出行 idx-1 尚不存在
+            dst = (k == 3) ? out + (size_t)(idx - 1) * width : scratch;
+            sliced_vert(idx >= 2 ? ring[k][(idx - 2) % 3] : zero, ring[k][(idx - 1) % 3], c, dst, width, is_dilate);
+            x = dst;
+        }
+    }
+}
+
+size_t morph_batch_workspace_words(int width, int height) {
+    return (size_t)2 * width * height + (size_t)14 * width;
+}
+
+void morph_open_close_batch(const uint32_t* src_frames, uint32_t* dst_frames, int nframes,
+                            int width, int height, uint64_t* workspace) {
+    uint64_t* sliced_in = workspace;
+    uint64_t* sliced_out = workspace + (size_t)width * height;
+    uint64_t* work = workspace + (size_t)2 * width * height;
+    if (nframes <= 0) return;
+    if (nframes > MORPH_BATCH_LANES) nframes = MORPH_BATCH_LANES;
+    morph_batch_pack(src_frames, nframes, width, height, sliced_in);
+    open_close_bitsliced(sliced_in, sliced_out, width, height, work);
+    morph_batch_unpack(sliced_out, nframes, width, height, dst_frames);
+}
@@ -20,8 +20,8 @@
 extern "C" {
 #endif
 
-/* 兼容 C89/C99 的 inline 定义 */
-#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L)
+/* 兼容 C89/C99 的 inline 定义（C++ 不定义 __STDC_VERSION__，须单独判断，否则未用到的函数会报 -Wunused-function） */
+#if defined(__cplusplus) || (defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L))
   #define MBP_INLINE static inline
 #else
   #define MBP_INLINE static
@@ -43,6 +43,11 @@ void pack_binary_u16_to_bits(const uint16_t* src, int width, int height, int src
 void pack_binary_u8_to_bits(const uint8_t* src, int width, int height, int src_stride_pixels,
                             uint32_t* dst_bits);
 
+/* 灰度阈值打包（SIMD 比较 + movemask，运行时分派）：bit = (像素 > threshold)，stride_bytes 为源行跨度（任意）。
+   threshold = 0 时与 pack_binary_u8_to_bits（非零即 1）结果相同 */
+void pack_gray_threshold_to_bits(const uint8_t* gray, int width, int height, int stride_bytes,
+                                 uint8_t threshold, uint32_t* dst_bits);
+
 /* 将位域解包为 u16（bit=1 → 0xFFFF，bit=0 → 0） */
 void unpack_bits_to_binary_u16(const uint32_t* src_bits, int width, int height,
                                uint16_t* dst, int dst_stride_pixels);
@@ -55,6 +60,30 @@ void unpack_bits_to_binary_u8(const uint32_t* src_bits, int width, int height,
 void erode3x3_bitpacked(const uint32_t* src_bits, uint32_t* dst_bits, int width, int height);
 void dilate3x3_bitpacked(const uint32_t* src_bits, uint32_t* dst_bits, int width, int height);
 
+/* 3×3 腐蚀/膨胀（SIMD 版，运行时按 CPU 选择 AVX2/SSE2/NEON/标量，见 morph_binary_bitpacked_simd.c）
+   结果与上面的标量参考实现逐位一致；宽度超过 MORPH_SIMD_MAX_WPR*32 时直接调用标量版本 */
+#define MORPH_SIMD_MAX_WPR 64
+void erode3x3_bitpacked_fast(const uint32_t* src_bits, uint32_t* dst_bits, int width, int height);
+void dilate3x3_bitpacked_fast(const uint32_t* src_bits, uint32_t* dst_bits, int width, int height);
+
+/* 寄存器驻留的 开→闭（SIMD，宽度 ≤ 256），结果与 open_close_bitpacked 逐位一致；
+   当前实现为标量或宽度超限时返回 -1 且不写 out_bits */
+int open_close_bitpacked_simd(const uint32_t* src_bits, uint32_t* out_bits, int width, int height);
+
+typedef enum {
+    MORPH_SIMD_AUTO = 0,  /* 按 CPU 自动选择（默认） */
+    MORPH_SIMD_SCALAR,
+    MORPH_SIMD_SSE2,
+    MORPH_SIMD_AVX2,
+    MORPH_SIMD_NEON
+} morph_simd_level;
+
+/* 强制使用指定实现（用于对比/基准）；当前 CPU 或构建不支持时返回 -1 且不改变选择 */
+int morph_simd_force(morph_simd_level level);
+
+/* 当前生效的实现名："scalar" / "sse2" / "avx2" / "neon" */
+const char* morph_simd_backend(void);
+
 /* 二值内部梯度：output = clean & ~erode(clean) */
 void internal_gradient_bitpacked(const uint32_t* clean_bits, const uint32_t* eroded_bits,
                                  uint32_t* output_bits, int width, int height);
@@ -65,6 +94,54 @@ void close_bitpacked(const uint32_t* src_bits, uint32_t* tmp1_bits, uint32_t* ou
 /* 高层流水线1：开(腐->膨) → 闭(膨->腐) */
 void open_close_bitpacked(const uint32_t* src_bits, uint32_t* tmp1_bits, uint32_t* out_bits, int width, int height);
 
+/* 单遍滚动窗口版 开→闭：逐行流式处理，结果与 open_close_bitpacked 逐位一致。
+   参数同 open_close_bitpacked；CPU 支持时先走 open_close_bitpacked_simd，
+   宽度超过 MORPH_STREAM_MAX_WPR*32 时回退到四遍版本（此时才使用 tmp1_bits）。 */
+void open_close_bitpacked_fused(const uint32_t* src_bits, uint32_t* tmp1_bits, uint32_t* out_bits, int width, int height);
+
+/* 行同步接口：逐行送入位打包输入，输出行直接写入 out_bits 的对应行。
+   送入第 r 行后，行 0..r-MORPH_STREAM_LATENCY 的输出已就绪；送入最后一行时自动冲刷剩余输出。 */
+#define MORPH_STREAM_MAX_WPR 8   /* 最大支持宽度 256 像素 */
+#define MORPH_STREAM_STAGES  4   /* 腐蚀、膨胀、膨胀、腐蚀 */
+#define MORPH_STREAM_LATENCY MORPH_STREAM_STAGES
+
+typedef struct {
+    int width, height, wpw;
+    uint32_t tail;
+    uint32_t* out;
+    int last_row;                                       /* 已完成的最后一个输出行，-1 表示尚无 */
+    int count[MORPH_STREAM_STAGES];                     /* 各级已收到的输入行数 */
+    uint32_t ring[MORPH_STREAM_STAGES][3][MORPH_STREAM_MAX_WPR];
+    uint32_t scratch[MORPH_STREAM_MAX_WPR];
+} MorphOpenCloseStream;
+
+/* 初始化；宽度超出缓冲或尺寸非法时返回 -1 */
+int morph_stream_init(MorphOpenCloseStream* s, int width, int height, uint32_t* out_bits);
+
+/* 送入下一行输入，返回已完成的最后一个输出行号（-1 表示尚无输出） */
+int morph_stream_push_row(MorphOpenCloseStream* s, const uint32_t* row_bits);
+
+/* 帧批量位切片（离线回放）：sliced[y*width + x] 的 bit f = 批内第 f 帧的像素 (x, y)，一批最多 64 帧。
+   逐帧数据按 total_words(width, height) 的步长连续存放（即逐帧位打包布局首尾相接）。 */
+#define MORPH_BATCH_LANES 64
+void morph_batch_pack(const uint32_t* frames_bits, int nframes, int width, int height, uint64_t* sliced);
+void morph_batch_unpack(const uint64_t* sliced, int nframes, int width, int height, uint32_t* frames_bits);
+
+/* 打包/解包转置的 SIMD 版本（x86 SSE2 movemask）；当前为标量实现时返回 -1，由上面两个函数自动调用 */
+int morph_batch_pack_simd(const uint32_t* frames_bits, int nframes, int width, int height, uint64_t* sliced);
+int morph_batch_unpack_simd(const uint64_t* sliced, int nframes, int width, int height, uint32_t* frames_bits);
+
+/* 位切片 开→闭：一次处理批内所有帧；work 至少 14*width 个 uint64 */
+void open_close_bitsliced(const uint64_t* src, uint64_t* out, int width, int height, uint64_t* work);
+/* AVX2 版本（由 open_close_bitsliced 自动调用）；当前实现不是 AVX2 时返回 -1 */
+int open_close_bitsliced_simd(const uint64_t* src, uint64_t* out, int width, int height, uint64_t* work);
+
+/* 整批 开→闭：pack → open_close_bitsliced → unpack，逐帧结果与 open_close_bitpacked 一致；
+   workspace 至少 morph_batch_workspace_words(width, height) 个 uint64；nframes 超过 64 时只处理前 64 帧 */
+size_t morph_batch_workspace_words(int width, int height);
+void morph_open_close_batch(const uint32_t* src_frames, uint32_t* dst_frames, int nframes,
+                            int width, int height, uint64_t* workspace);
+
 // 高层流水线2：开运算 -> 闭运算 -> 内部梯度（最终得到单像素边缘）
 void precise_edge_detection_bitpacked(const uint32_t* src_bits, uint32_t* tmp1_bits, uint32_t* out_bits, int width, int height);
 
@@ -78,6 +155,13 @@ void morph_clean_u8_binary_adapter(const uint8_t* src_u8,
                                    int width, int height,
                                    uint8_t* dst_u8);
 
+/* 适配器（可重入版）：缓冲由调用者提供，每块至少 total_words(width, height) 个 word；
+   src_u8 与 dst_u8 可以是同一块内存 */
+void morph_clean_u8_binary_buffers(const uint8_t* src_u8,
+                                   int width, int height,
+                                   uint8_t* dst_u8,
+                                   uint32_t* packed_buf, uint32_t* tmp_buf, uint32_t* out_buf);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,696 @@
+// 位打包 3×3 腐蚀/膨胀的 SIMD 版本（SSE2 / AVX2 / NEON）与运行时分派
+//
+// 实现思路：
+// - 每行先拷贝到首尾补 0 word 的暂存行，这样“左邻 word / 右邻 word”就是同一数组错开一个 word 的非对齐加载，
+//   水平 1×3 变成纯按 32 位通道的移位与 AND/OR，不再需要逐 word 的行首/行尾分支。
+// - 每行水平结果只算一次，放进 3 行环形缓冲；纵向只剩三行 AND/OR。
+// - 越界行按全 0、行尾按 tail 掩码，结果与 erode3x3_bitpacked / dilate3x3_bitpacked（标量参考实现）逐位一致。
+// - x86 上按 CPUID 在 AVX2 → SSE2 → 标量 之间选择；ARM 上 NEON 为编译期可用即启用。
+
+#include "morph_binary_bitpacked.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define MORPH_SIMD_X86 1
+  #include <immintrin.h>
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define MORPH_TARGET_SSE2
+    #define MORPH_TARGET_AVX2
+  #else
+    #define MORPH_TARGET_SSE2 __attribute__((target("sse2")))
+    #define MORPH_TARGET_AVX2 __attribute__((target("avx2")))
+  #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+  #define MORPH_SIMD_NEON 1
+  #include <arm_neon.h>
+#endif
+
+// 暂存行：[0] 与 [wpw+1..] 恒为 0，有效数据在 [1..wpw]；最宽 8 个 32 位通道（AVX2）的尾部读写都落在缓冲内
+#define MORPH_SIMD_PAD (MORPH_SIMD_MAX_WPR + 2 + 8)
+
+typedef void (*morph_horiz_fn)(const uint32_t* p, uint32_t* out, int wpw, int is_dilate);
+typedef void (*morph_vert_fn)(const uint32_t* a, const uint32_t* b, const uint32_t* c, uint32_t* out, int wpw, int is_dilate);
+typedef void (*morph_open_close_fn)(const uint32_t* src, uint32_t* dst, int wpw, uint32_t tail, int height);
+typedef uint32_t (*morph_pack32_fn)(const uint8_t* px, uint8_t threshold); // 32 个像素 → 1 个 word（bit=像素>阈值）
+
+// 寄存器驻留的 开+闭（wpw ≤ 8，即宽度 ≤ 256）：一行放进一个 256 位（或两个 128 位）寄存器，
+// 四级（腐蚀、膨胀、膨胀、腐蚀）各保留前两行的水平结果，逐行流过，与 open_close_bitpacked_fused 的滚动窗口相同：
+// 第 t 步第 k 级的输入行号为 t-k，行号越界（<0 或 ≥height）时输入按全 0；第 3 级输出行 t-4。
+#define MORPH_OC_MAX_WPR 8
+#define MORPH_OC_STAGE_DILATE(k) ((k) == 1 || (k) == 2)
+
+// 每行的有效位掩码：前 wpw-1 个 word 全 1，第 wpw-1 个为 tail，其余为 0
+static void open_close_lane_mask(uint32_t mask[MORPH_OC_MAX_WPR], int wpw, uint32_t tail) {
+    for (int i = 0; i < MORPH_OC_MAX_WPR; i++) {
+        mask[i] = (i < wpw - 1) ? 0xFFFFFFFFu : (i == wpw - 1 ? tail : 0u);
+    }
+}
+
+// ---------------- 标量 ----------------
+// p[-1] 与 p[wpw] 为 0
+static void horiz_scalar(const uint32_t* p, uint32_t* out, int wpw, int is_dilate) {
+    for (int i = 0; i < wpw; i++) {
+        uint32_t l = (p[i] << 1) | (p[i - 1] >> 31);
+        uint32_t r = (p[i] >> 1) | (p[i + 1] << 31);
+        out[i] = is_dilate ? (l | p[i] | r) : (l & p[i] & r);
+    }
+}
+
+static void vert_scalar(const uint32_t* a, const uint32_t* b, const uint32_t* c, uint32_t* out, int wpw, int is_dilate) {
+    for (int i = 0; i < wpw; i++) {
+        out[i] = is_dilate ? (a[i] | b[i] | c[i]) : (a[i] & b[i] & c[i]);
+    }
+}
+
+static uint32_t pack32_scalar(const uint8_t* px, uint8_t threshold) {
+    uint32_t w = 0;
+    for (int b = 0; b < 32; b++) {
+        if (px[b] > threshold) w |= (1u << b);
+    }
+    return w;
+}
+
+#if defined(MORPH_SIMD_X86)
+// ---------------- SSE2（4 个 word 一组） ----------------
+MORPH_TARGET_SSE2
+static void horiz_sse2(const uint32_t* p, uint32_t* out, int wpw, int is_dilate) {
+    for (int i = 0; i < wpw; i += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i lw = _mm_loadu_si128((const __m128i*)(p + i - 1));
+        __m128i rw = _mm_loadu_si128((const __m128i*)(p + i + 1));
+        __m128i l = _mm_or_si128(_mm_slli_epi32(c, 1), _mm_srli_epi32(lw, 31));
+        __m128i r = _mm_or_si128(_mm_srli_epi32(c, 1), _mm_slli_epi32(rw, 31));
+        __m128i v = is_dilate ? _mm_or_si128(_mm_or_si128(l, c), r) : _mm_and_si128(_mm_and_si128(l, c), r);
+        _mm_storeu_si128((__m128i*)(out + i), v);
+    }
+}
+
+MORPH_TARGET_SSE2
+static void vert_sse2(const uint32_t* a, const uint32_t* b, const uint32_t* c, uint32_t* out, int wpw, int is_dilate) {
+    for (int i = 0; i < wpw; i += 4) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i vc = _mm_loadu_si128((const __m128i*)(c + i));
+        __m128i v = is_dilate ? _mm_or_si128(_mm_or_si128(va, vb), vc) : _mm_and_si128(_mm_and_si128(va, vb), vc);
+        _mm_storeu_si128((__m128i*)(out + i), v);
+    }
+}
+
+// 无符号比较：两边同时异或 0x80 后用有符号 cmpgt；movemask 的 bit k 对应第 k 个字节（最左像素在 bit0）
+MORPH_TARGET_SSE2
+static uint32_t pack32_sse2(const uint8_t* px, uint8_t threshold) {
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    const __m128i thr = _mm_set1_epi8((char)(threshold ^ 0x80));
+    __m128i lo = _mm_xor_si128(_mm_loadu_si128((const __m128i*)px), bias);
+    __m128i hi = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(px + 16)), bias);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(lo, thr))
+         | ((uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(hi, thr)) << 16);
+}
+
+// ---------------- AVX2（8 个 word 一组，188 宽一行只需一次） ----------------
+MORPH_TARGET_AVX2
+static void horiz_avx2(const uint32_t* p, uint32_t* out, int wpw, int is_dilate) {
+    for (int i = 0; i < wpw; i += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i lw = _mm256_loadu_si256((const __m256i*)(p + i - 1));
+        __m256i rw = _mm256_loadu_si256((const __m256i*)(p + i + 1));
+        __m256i l = _mm256_or_si256(_mm256_slli_epi32(c, 1), _mm256_srli_epi32(lw, 31));
+        __m256i r = _mm256_or_si256(_mm256_srli_epi32(c, 1), _mm256_slli_epi32(rw, 31));
+        __m256i v = is_dilate ? _mm256_or_si256(_mm256_or_si256(l, c), r) : _mm256_and_si256(_mm256_and_si256(l, c), r);
+        _mm256_storeu_si256((__m256i*)(out + i), v);
+    }
+}
+
+MORPH_TARGET_AVX2
+static void vert_avx2(const uint32_t* a, const uint32_t* b, const uint32_t* c, uint32_t* out, int wpw, int is_dilate) {
+    for (int i = 0; i < wpw; i += 8) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i vc = _mm256_loadu_si256((const __m256i*)(c + i));
+        __m256i v = is_dilate ? _mm256_or_si256(_mm256_or_si256(va, vb), vc) : _mm256_and_si256(_mm256_and_si256(va, vb), vc);
+        _mm256_storeu_si256((__m256i*)(out + i), v);
+    }
+}
+
+// SSE2：一行拆成 lo（word 0..3）、hi（word 4..7）两个寄存器，跨寄存器的邻 word 用字节移位拼接
+MORPH_TARGET_SSE2
+static void open_close_sse2(const uint32_t* src, uint32_t* dst, int wpw, uint32_t tail, int height) {
+    uint32_t m[MORPH_OC_MAX_WPR], buf[MORPH_OC_MAX_WPR] = {0};
+    __m128i a_lo[4], a_hi[4], b_lo[4], b_hi[4];
+    const __m128i zero = _mm_setzero_si128();
+    __m128i mask_lo, mask_hi;
+    open_close_lane_mask(m, wpw, tail);
+    mask_lo = _mm_loadu_si128((const __m128i*)m);
+    mask_hi = _mm_loadu_si128((const __m128i*)(m + 4));
+    for (int k = 0; k < 4; k++) a_lo[k] = a_hi[k] = b_lo[k] = b_hi[k] = zero;
+
+    for (int t = 0; t < height + 4; t++) {
+        __m128i x_lo = zero, x_hi = zero;
+        int k;
+        if (t < height) {
+            memcpy(buf, src + (size_t)t * wpw, (size_t)wpw * sizeof(uint32_t));
+            x_lo = _mm_loadu_si128((const __m128i*)buf);
+            x_hi = _mm_loadu_si128((const __m128i*)(buf + 4));
+        }
+        for (k = 0; k < 4; k++) {
+            int idx = t - k;
+            __m128i c_lo, c_hi, l_lo, l_hi, r_lo, r_hi, o_lo, o_hi;
+            if (idx < 0) break;
+            if (idx >= height) x_lo = x_hi = zero;
+            // 水平 1×3：左邻 word 为整体右移一个 word，右邻为整体左移一个 word
+            l_lo = _mm_slli_si128(x_lo, 4);
+            l_hi = _mm_or_si128(_mm_slli_si128(x_hi, 4), _mm_srli_si128(x_lo, 12));
+            r_lo = _mm_or_si128(_mm_srli_si128(x_lo, 4), _mm_slli_si128(x_hi, 12));
+            r_hi = _mm_srli_si128(x_hi, 4);
+            l_lo = _mm_or_si128(_mm_slli_epi32(x_lo, 1), _mm_srli_epi32(l_lo, 31));
+            l_hi = _mm_or_si128(_mm_slli_epi32(x_hi, 1), _mm_srli_epi32(l_hi, 31));
+            r_lo = _mm_or_si128(_mm_srli_epi32(x_lo, 1), _mm_slli_epi32(r_lo, 31));
+            r_hi = _mm_or_si128(_mm_srli_epi32(x_hi, 1), _mm_slli_epi32(r_hi, 31));
+            if (MORPH_OC_STAGE_DILATE(k)) {
+                c_lo = _mm_and_si128(_mm_or_si128(_mm_or_si128(l_lo, x_lo), r_lo), mask_lo);
+                c_hi = _mm_and_si128(_mm_or_si128(_mm_or_si128(l_hi, x_hi), r_hi), mask_hi);
+                o_lo = _mm_or_si128(_mm_or_si128(a_lo[k], b_lo[k]), c_lo);
+                o_hi = _mm_or_si128(_mm_or_si128(a_hi[k], b_hi[k]), c_hi);
+            } else {
+                c_lo = _mm_and_si128(_mm_and_si128(_mm_and_si128(l_lo, x_lo), r_lo), mask_lo);
+                c_hi = _mm_and_si128(_mm_and_si128(_mm_and_si128(l_hi, x_hi), r_hi), mask_hi);
+                o_lo = _mm_and_si128(_mm_and_si128(a_lo[k], b_lo[k]), c_lo);
+                o_hi = _mm_and_si128(_mm_and_si128(a_hi[k], b_hi[k]), c_hi);
+            }
+            a_lo[k] = b_lo[k]; a_hi[k] = b_hi[k];
+            b_lo[k] = c_lo;    b_hi[k] = c_hi;
+            x_lo = o_lo;       x_hi = o_hi; // 本级输出行 idx-1
+            if (idx - 1 < 0) break;
+        }
+        if (k == 4) {
+            _mm_storeu_si128((__m128i*)buf, x_lo);
+            _mm_storeu_si128((__m128i*)(buf + 4), x_hi);
+            memcpy(dst + (size_t)(t - 4) * wpw, buf, (size_t)wpw * sizeof(uint32_t));
+        }
+    }
+}
+
+// AVX2：一行一个寄存器，邻 word 用跨通道置换取得
+MORPH_TARGET_AVX2
+static void open_close_avx2(const uint32_t* src, uint32_t* dst, int wpw, uint32_t tail, int height) {
+    uint32_t m[MORPH_OC_MAX_WPR], ld[MORPH_OC_MAX_WPR];
+    __m256i a[4], b[4];
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i perm_l = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i perm_r = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 7);
+    const __m256i keep_l = _mm256_setr_epi32(0, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i keep_r = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, -1, 0);
+    __m256i mask, io;
+    open_close_lane_mask(m, wpw, tail);
+    for (int i = 0; i < MORPH_OC_MAX_WPR; i++) ld[i] = (i < wpw) ? 0xFFFFFFFFu : 0u;
+    mask = _mm256_loadu_si256((const __m256i*)m);
+    io = _mm256_loadu_si256((const __m256i*)ld);
+    for (int k = 0; k < 4; k++) a[k] = b[k] = zero;
+
+    for (int t = 0; t < height + 4; t++) {
+        __m256i x = zero;
+        int k;
+        if (t < height) x = _mm256_maskload_epi32((const int*)(src + (size_t)t * wpw), io);
+        for (k = 0; k < 4; k++) {
+            int idx = t - k;
+            __m256i l, r, c, o;
+            if (idx < 0) break;
+            if (idx >= height) x = zero;
+            l = _mm256_and_si256(_mm256_permutevar8x32_epi32(x, perm_l), keep_l);
+            r = _mm256_and_si256(_mm256_permutevar8x32_epi32(x, perm_r), keep_r);
+            l = _mm256_or_si256(_mm256_slli_epi32(x, 1), _mm256_srli_epi32(l, 31));
+            r = _mm256_or_si256(_mm256_srli_epi32(x, 1), _mm256_slli_epi32(r, 31));
+            if (MORPH_OC_STAGE_DILATE(k)) {
+                c = _mm256_and_si256(_mm256_or_si256(_mm256_or_si256(l, x), r), mask);
+                o = _mm256_or_si256(_mm256_or_si256(a[k], b[k]), c);
+            } else {
+                c = _mm256_and_si256(_mm256_and_si256(_mm256_and_si256(l, x), r), mask);
+                o = _mm256_and_si256(_mm256_and_si256(a[k], b[k]), c);
+            }
+            a[k] = b[k];
+            b[k] = c;
+            x = o; // 本级输出行 idx-1
+            if (idx - 1 < 0) break;
+        }
+        if (k == 4) _mm256_maskstore_epi32((int*)(dst + (size_t)(t - 4) * wpw), io, x);
+    }
+}
+
+// ---------------- 位切片批量的打包/解包转置（SSE2） ----------------
+// 思路：先用若干轮 unpacklo/hi_epi8 做字节级转置（每轮把“向量号|字节位置”的下标循环左移 1 位），
+// 让同一像素字节的 16 个帧（或同一帧字节的 16 个像素）落在同一个向量里，
+// 再用 movemask 一次取出 16 个字节的最高位，add_epi8(v, v) 把下一位移到最高位（字节内移位，不跨字节）。
+
+// 4 个向量（64 字节）一轮：out[2m] = lo(in[m], in[m+2])，out[2m+1] = hi(in[m], in[m+2])
+MORPH_TARGET_SSE2
+static void byte_shuffle_round4(__m128i v[4]) {
+    __m128i t0 = _mm_unpacklo_epi8(v[0], v[2]), t1 = _mm_unpackhi_epi8(v[0], v[2]);
+    __m128i t2 = _mm_unpacklo_epi8(v[1], v[3]), t3 = _mm_unpackhi_epi8(v[1], v[3]);
+    v[0] = t0; v[1] = t1; v[2] = t2; v[3] = t3;
+}
+
+// 8 个向量（128 字节）一轮：out[2m] = lo(in[m], in[m+4])，out[2m+1] = hi(in[m], in[m+4])
+MORPH_TARGET_SSE2
+static void byte_shuffle_round8(__m128i v[8]) {
+    __m128i t[8];
+    for (int m = 0; m < 4; m++) {
+        t[2 * m] = _mm_unpacklo_epi8(v[m], v[m + 4]);
+        t[2 * m + 1] = _mm_unpackhi_epi8(v[m], v[m + 4]);
+    }
+    for (int m = 0; m < 8; m++) v[m] = t[m];
+}
+
+// 打包一块：64 帧各一个 word（32 像素）→ 32 个位切片 word
+MORPH_TARGET_SSE2
+static void batch_pack_block_sse2(const uint32_t words[64], uint64_t out[32]) {
+    memset(out, 0, 32 * sizeof(uint64_t));
+    for (int g = 0; g < 4; g++) {
+        __m128i v[4];
+        // 下标 (帧号<<2 | 字节号) 循环左移 4 轮后变为 (字节号<<4 | 帧号)：v[j] 的第 q 字节 = 帧 16g+q 的第 j 字节
+        for (int a = 0; a < 4; a++) v[a] = _mm_loadu_si128((const __m128i*)(words + 16 * g + 4 * a));
+        for (int r = 0; r < 4; r++) byte_shuffle_round4(v);
+        for (int j = 0; j < 4; j++) {
+            __m128i x = v[j];
+            for (int b = 7; b >= 0; b--) {
+                out[8 * j + b] |= (uint64_t)(uint32_t)_mm_movemask_epi8(x) << (16 * g);
+                x = _mm_add_epi8(x, x);
+            }
+        }
+    }
+}
+
+// 解包一块：32 个位切片 word → 64 帧各一个 word
+MORPH_TARGET_SSE2
+static void batch_unpack_block_sse2(const uint64_t sliced[32], uint32_t words[64]) {
+    memset(words, 0, 64 * sizeof(uint32_t));
+    for (int h = 0; h < 2; h++) {
+        __m128i v[8];
+        // 下标 (像素号<<3 | 字节号) 循环左移 4 轮后变为 (字节号<<4 | 像素号)：v[k] 的第 x 字节 = 像素 16h+x 的第 k 字节
+        for (int m = 0; m < 8; m++) v[m] = _mm_loadu_si128((const __m128i*)(sliced + 16 * h + 2 * m));
+        for (int r = 0; r < 4; r++) byte_shuffle_round8(v);
+        for (int k = 0; k < 8; k++) {
+            __m128i x = v[k];
+            for (int b = 7; b >= 0; b--) {
+                words[8 * k + b] |= (uint32_t)_mm_movemask_epi8(x) << (16 * h);
+                x = _mm_add_epi8(x, x);
+            }
+        }
+    }
+}
+
+// 位切片 开→闭（AVX2）：与 open_close_bitsliced 相同的四级滚动窗口，一条指令处理 4 个像素 × 64 帧
+MORPH_TARGET_AVX2
+static void sliced_horiz_avx2(const uint64_t* in, uint64_t* out, int width, int is_dilate) {
+    int x = 1;
+    if (width == 1) {
+        out[0] = is_dilate ? in[0] : 0u;
+        return;
+    }
+    out[0] = is_dilate ? (in[0] | in[1]) : 0u;
+    for (; x + 4 <= width - 1; x += 4) {
+        __m256i l = _mm256_loadu_si256((const __m256i*)(in + x - 1));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(in + x));
+        __m256i r = _mm256_loadu_si256((const __m256i*)(in + x + 1));
+        __m256i v = is_dilate ? _mm256_or_si256(_mm256_or_si256(l, c), r) : _mm256_and_si256(_mm256_and_si256(l, c), r);
+        _mm256_storeu_si256((__m256i*)(out + x), v);
+    }
+    for (; x < width - 1; x++) {
+        out[x] = is_dilate ? (in[x - 1] | in[x] | in[x + 1]) : (in[x - 1] & in[x] & in[x + 1]);
+    }
+    out[width - 1] = is_dilate ? (in[width - 2] | in[width - 1]) : 0u;
+}
+
+MORPH_TARGET_AVX2
+static void sliced_vert_avx2(const uint64_t* a, const uint64_t* b, const uint64_t* c, uint64_t* out, int width, int is_dilate) {
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + x));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + x));
+        __m256i vc = _mm256_loadu_si256((const __m256i*)(c + x));
+        __m256i v = is_dilate ? _mm256_or_si256(_mm256_or_si256(va, vb), vc) : _mm256_and_si256(_mm256_and_si256(va, vb), vc);
+        _mm256_storeu_si256((__m256i*)(out + x), v);
+    }
+    for (; x < width; x++) {
+        out[x] = is_dilate ? (a[x] | b[x] | c[x]) : (a[x] & b[x] & c[x]);
+    }
+}
+
+MORPH_TARGET_AVX2
+static void open_close_bitsliced_avx2(const uint64_t* src, uint64_t* out, int width, int height, uint64_t* work) {
+    uint64_t* ring[4][3];
+    uint64_t* scratch = work + (size_t)12 * width;
+    uint64_t* zero = work + (size_t)13 * width;
+    for (int k = 0; k < 4; k++) {
+        for (int r = 0; r < 3; r++) ring[k][r] = work + (size_t)(k * 3 + r) * width;
+    }
+    memset(zero, 0, (size_t)width * sizeof(uint64_t));
+
+    for (int t = 0; t < height + 4; t++) {
+        const uint64_t* x = (t < height) ? src + (size_t)t * width : zero;
+        for (int k = 0; k < 4; k++) {
+            int idx = t - k;
+            int is_dilate = MORPH_OC_STAGE_DILATE(k);
+            uint64_t *c, *dst;
+            if (idx < 0) break;
+            if (idx >= height) x = zero;
+            c = ring[k][idx % 3];
+            sliced_horiz_avx2(x, c, width, is_dilate);
+            if (idx < 1) break;
+            dst = (k == 3) ? out + (size_t)(idx - 1) * width : scratch;
+            sliced_vert_avx2(idx >= 2 ? ring[k][(idx - 2) % 3] : zero, ring[k][(idx - 1) % 3], c, dst, width, is_dilate);
+            x = dst;
+        }
+    }
+}
+
+MORPH_TARGET_AVX2
+static uint32_t pack32_avx2(const uint8_t* px, uint8_t threshold) {
+    const __m256i bias = _mm256_set1_epi8((char)0x80);
+    const __m256i thr = _mm256_set1_epi8((char)(threshold ^ 0x80));
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)px), bias);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, thr));
+}
+
+// CPU 是否支持 AVX2（同时检查操作系统是否保存 YMM 状态）
+static int cpu_has_avx2(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return 0;
+    __cpuid(r, 1);
+    if (!(r[2] & (1 << 27)) || !(r[2] & (1 << 28))) return 0; // OSXSAVE / AVX
+    if ((_xgetbv(0) & 6) != 6) return 0;
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static int cpu_has_sse2(void) {
+#if defined(__x86_64__) || defined(_M_X64)
+    return 1; // x86-64 基线
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 1);
+    return (r[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+#endif /* MORPH_SIMD_X86 */
+
+#if defined(MORPH_SIMD_NEON)
+// ---------------- NEON（4 个 word 一组） ----------------
+static void horiz_neon(const uint32_t* p, uint32_t* out, int wpw, int is_dilate) {
+    for (int i = 0; i < wpw; i += 4) {
+        uint32x4_t c = vld1q_u32(p + i);
+        uint32x4_t lw = vld1q_u32(p + i - 1);
+        uint32x4_t rw = vld1q_u32(p + i + 1);
+        uint32x4_t l = vorrq_u32(vshlq_n_u32(c, 1), vshrq_n_u32(lw, 31));
+        uint32x4_t r = vorrq_u32(vshrq_n_u32(c, 1), vshlq_n_u32(rw, 31));
+        uint32x4_t v = is_dilate ? vorrq_u32(vorrq_u32(l, c), r) : vandq_u32(vandq_u32(l, c), r);
+        vst1q_u32(out + i, v);
+    }
+}
+
+static void vert_neon(const uint32_t* a, const uint32_t* b, const uint32_t* c, uint32_t* out, int wpw, int is_dilate) {
+    for (int i = 0; i < wpw; i += 4) {
+        uint32x4_t va = vld1q_u32(a + i), vb = vld1q_u32(b + i), vc = vld1q_u32(c + i);
+        uint32x4_t v = is_dilate ? vorrq_u32(vorrq_u32(va, vb), vc) : vandq_u32(vandq_u32(va, vb), vc);
+        vst1q_u32(out + i, v);
+    }
+}
+
+// NEON 没有 movemask：比较结果与位权 {1,2,4,...,128} 相与后两两相加，三轮 vpadd 得到每 8 字节一个掩码字节
+static uint16_t neon_movemask16(uint8x16_t c) {
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t m = vandq_u8(c, vld1q_u8(weights));
+    uint8x8_t p = vpadd_u8(vget_low_u8(m), vget_high_u8(m));
+    p = vpadd_u8(p, p);
+    p = vpadd_u8(p, p);
+    return vget_lane_u16(vreinterpret_u16_u8(p), 0);
+}
+
+static uint32_t pack32_neon(const uint8_t* px, uint8_t threshold) {
+    uint8x16_t thr = vdupq_n_u8(threshold);
+    return (uint32_t)neon_movemask16(vcgtq_u8(vld1q_u8(px), thr))
+         | ((uint32_t)neon_movemask16(vcgtq_u8(vld1q_u8(px + 16), thr)) << 16);
+}
+
+// NEON：与 SSE2 相同的 lo/hi 拆分，邻 word 用 vext 拼接
+static void open_close_neon(const uint32_t* src, uint32_t* dst, int wpw, uint32_t tail, int height) {
+    uint32_t m[MORPH_OC_MAX_WPR], buf[MORPH_OC_MAX_WPR] = {0};
+    uint32x4_t a_lo[4], a_hi[4], b_lo[4], b_hi[4];
+    const uint32x4_t zero = vdupq_n_u32(0);
+    uint32x4_t mask_lo, mask_hi;
+    open_close_lane_mask(m, wpw, tail);
+    mask_lo = vld1q_u32(m);
+    mask_hi = vld1q_u32(m + 4);
+    for (int k = 0; k < 4; k++) a_lo[k] = a_hi[k] = b_lo[k] = b_hi[k] = zero;
+
+    for (int t = 0; t < height + 4; t++) {
+        uint32x4_t x_lo = zero, x_hi = zero;
+        int k;
+        if (t < height) {
+            memcpy(buf, src + (size_t)t * wpw, (size_t)wpw * sizeof(uint32_t));
+            x_lo = vld1q_u32(buf);
+            x_hi = vld1q_u32(buf + 4);
+        }
+        for (k = 0; k < 4; k++) {
+            int idx = t - k;
+            uint32x4_t c_lo, c_hi, l_lo, l_hi, r_lo, r_hi, o_lo, o_hi;
+            if (idx < 0) break;
+            if (idx >= height) x_lo = x_hi = zero;
+            l_lo = vextq_u32(zero, x_lo, 3);
+            l_hi = vextq_u32(x_lo, x_hi, 3);
+            r_lo = vextq_u32(x_lo, x_hi, 1);
+            r_hi = vextq_u32(x_hi, zero, 1);
+            l_lo = vorrq_u32(vshlq_n_u32(x_lo, 1), vshrq_n_u32(l_lo, 31));
+            l_hi = vorrq_u32(vshlq_n_u32(x_hi, 1), vshrq_n_u32(l_hi, 31));
+            r_lo = vorrq_u32(vshrq_n_u32(x_lo, 1), vshlq_n_u32(r_lo, 31));
+            r_hi = vorrq_u32(vshrq_n_u32(x_hi, 1), vshlq_n_u32(r_hi, 31));
+            if (MORPH_OC_STAGE_DILATE(k)) {
+                c_lo = vandq_u32(vorrq_u32(vorrq_u32(l_lo, x_lo), r_lo), mask_lo);
+                c_hi = vandq_u32(vorrq_u32(vorrq_u32(l_hi, x_hi), r_hi), mask_hi);
+                o_lo = vorrq_u32(vorrq_u32(a_lo[k], b_lo[k]), c_lo);
+                o_hi = vorrq_u32(vorrq_u32(a_hi[k], b_hi[k]), c_hi);
+            } else {
+                c_lo = vandq_u32(vandq_u32(vandq_u32(l_lo, x_lo), r_lo), mask_lo);
+                c_hi = vandq_u32(vandq_u32(vandq_u32(l_hi, x_hi), r_hi), mask_hi);
+                o_lo = vandq_u32(vandq_u32(a_lo[k], b_lo[k]), c_lo);
+                o_hi = vandq_u32(vandq_u32(a_hi[k], b_hi[k]), c_hi);
+            }
+            a_lo[k] = b_lo[k]; a_hi[k] = b_hi[k];
+            b_lo[k] = c_lo;    b_hi[k] = c_hi;
+            x_lo = o_lo;       x_hi = o_hi;
+            if (idx - 1 < 0) break;
+        }
+        if (k == 4) {
+            vst1q_u32(buf, x_lo);
+            vst1q_u32(buf + 4, x_hi);
+            memcpy(dst + (size_t)(t - 4) * wpw, buf, (size_t)wpw * sizeof(uint32_t));
+        }
+    }
+}
+#endif /* MORPH_SIMD_NEON */
+
+// ---------------- 分派 ----------------
+typedef struct {
+    morph_horiz_fn horiz;
+    morph_vert_fn vert;
+    morph_open_close_fn open_close; // NULL 表示没有寄存器驻留版本
+    morph_pack32_fn pack32;
+    const char* name;
+} morph_simd_kernels;
+
+static const morph_simd_kernels s_kernels_scalar = { horiz_scalar, vert_scalar, NULL, pack32_scalar, "scalar" };
+#if defined(MORPH_SIMD_X86)
+static const morph_simd_kernels s_kernels_sse2 = { horiz_sse2, vert_sse2, open_close_sse2, pack32_sse2, "sse2" };
+static const morph_simd_kernels s_kernels_avx2 = { horiz_avx2, vert_avx2, open_close_avx2, pack32_avx2, "avx2" };
+#endif
+#if defined(MORPH_SIMD_NEON)
+static const morph_simd_kernels s_kernels_neon = { horiz_neon, vert_neon, open_close_neon, pack32_neon, "neon" };
+#endif
+
+static const morph_simd_kernels* s_forced = NULL;
+
+static const morph_simd_kernels* detect_kernels(void) {
+#if defined(MORPH_SIMD_X86)
+    if (cpu_has_avx2()) return &s_kernels_avx2;
+    if (cpu_has_sse2()) return &s_kernels_sse2;
+#elif defined(MORPH_SIMD_NEON)
+    return &s_kernels_neon;
+#endif
+    return &s_kernels_scalar;
+}
+
+static const morph_simd_kernels* select_kernels(void) {
+    // CPU 能力在进程内不变，多个线程同时首次调用时写入的是同一个值
+    static const morph_simd_kernels* s_detected = NULL;
+    if (s_forced) return s_forced;
+    if (!s_detected) s_detected = detect_kernels();
+    return s_detected;
+}
+
+int morph_simd_force(morph_simd_level level) {
+    switch (level) {
+    case MORPH_SIMD_AUTO:   s_forced = NULL; return 0;
+    case MORPH_SIMD_SCALAR: s_forced = &s_kernels_scalar; return 0;
+#if defined(MORPH_SIMD_X86)
+    case MORPH_SIMD_SSE2:
+        if (!cpu_has_sse2()) return -1;
+        s_forced = &s_kernels_sse2; return 0;
+    case MORPH_SIMD_AVX2:
+        if (!cpu_has_avx2()) return -1;
+        s_forced = &s_kernels_avx2; return 0;
+#endif
+#if defined(MORPH_SIMD_NEON)
+    case MORPH_SIMD_NEON:   s_forced = &s_kernels_neon; return 0;
+#endif
+    default: return -1;
+    }
+}
+
+const char* morph_simd_backend(void) {
+    return select_kernels()->name;
+}
+
+// 腐蚀/膨胀共用：3 行环形缓冲存水平结果，越界行为全 0
+static void morph3x3_simd(const uint32_t* src_bits, uint32_t* dst_bits, int width, int height, int is_dilate) {
+    const morph_simd_kernels* k = select_kernels();
+    int wpw = words_per_row(width);
+    int rem = width & 31;
+    uint32_t tail = rem ? ((1u << rem) - 1u) : 0xFFFFFFFFu;
+    uint32_t pad[MORPH_SIMD_PAD] = {0};
+    uint32_t ring[3][MORPH_SIMD_PAD] = {{0}};
+    uint32_t zero[MORPH_SIMD_PAD] = {0};
+    uint32_t res[MORPH_SIMD_PAD];
+
+    if (wpw > MORPH_SIMD_MAX_WPR) {
+        if (is_dilate) dilate3x3_bitpacked(src_bits, dst_bits, width, height);
+        else           erode3x3_bitpacked(src_bits, dst_bits, width, height);
+        return;
+    }
+
+    for (int y = 0; y <= height; y++) {
+        // 先算第 y 行的水平结果（y == height 时不需要）
+        if (y < height) {
+            memcpy(pad + 1, src_bits + (size_t)y * wpw, (size_t)wpw * sizeof(uint32_t));
+            k->horiz(pad + 1, ring[y % 3], wpw, is_dilate);
+            ring[y % 3][wpw - 1] &= tail;
+        }
+        // 再输出第 y-1 行：上 y-2，中 y-1，下 y
+        if (y >= 1) {
+            const uint32_t* a = (y >= 2) ? ring[(y - 2) % 3] : zero;
+            const uint32_t* b = ring[(y - 1) % 3];
+            const uint32_t* c = (y < height) ? ring[y % 3] : zero;
+            k->vert(a, b, c, res, wpw, is_dilate);
+            memcpy(dst_bits + (size_t)(y - 1) * wpw, res, (size_t)wpw * sizeof(uint32_t));
+        }
+    }
+}
+
+void erode3x3_bitpacked_fast(const uint32_t* src_bits, uint32_t* dst_bits, int width, int height) {
+    morph3x3_simd(src_bits, dst_bits, width, height, 0);
+}
+
+void dilate3x3_bitpacked_fast(const uint32_t* src_bits, uint32_t* dst_bits, int width, int height) {
+    morph3x3_simd(src_bits, dst_bits, width, height, 1);
+}
+
+int open_close_bitpacked_simd(const uint32_t* src_bits, uint32_t* out_bits, int width, int height) {
+    const morph_simd_kernels* k = select_kernels();
+    int wpw = words_per_row(width);
+    int rem = width & 31;
+    if (!k->open_close || width <= 0 || height <= 0 || wpw > MORPH_OC_MAX_WPR) return -1;
+    k->open_close(src_bits, out_bits, wpw, rem ? ((1u << rem) - 1u) : 0xFFFFFFFFu, height);
+    return 0;
+}
+
+int morph_batch_pack_simd(const uint32_t* frames_bits, int nframes, int width, int height, uint64_t* sliced) {
+#if defined(MORPH_SIMD_X86)
+    int wpw = words_per_row(width);
+    size_t stride = (size_t)total_words(width, height);
+    uint32_t words[64];
+    uint64_t out[32];
+    if (select_kernels() == &s_kernels_scalar) return -1;
+    for (int y = 0; y < height; y++) {
+        for (int i = 0; i < wpw; i++) {
+            int n = width - (i << 5);
+            for (int f = 0; f < 64; f++) {
+                words[f] = (f < nframes) ? frames_bits[(size_t)f * stride + (size_t)y * wpw + i] : 0u;
+            }
+            batch_pack_block_sse2(words, out);
+            if (n > 32) n = 32;
+            memcpy(sliced + (size_t)y * width + (i << 5), out, (size_t)n * sizeof(uint64_t));
+        }
+    }
+    return 0;
+#else
+    (void)frames_bits; (void)nframes; (void)width; (void)height; (void)sliced;
+    return -1;
+#endif
+}
+
+int morph_batch_unpack_simd(const uint64_t* sliced, int nframes, int width, int height, uint32_t* frames_bits) {
+#if defined(MORPH_SIMD_X86)
+    int wpw = words_per_row(width);
+    size_t stride = (size_t)total_words(width, height);
+    uint64_t blk[32];
+    uint32_t words[64];
+    if (select_kernels() == &s_kernels_scalar) return -1;
+    for (int y = 0; y < height; y++) {
+        for (int i = 0; i < wpw; i++) {
+            int n = width - (i << 5);
+            if (n > 32) n = 32;
+            memcpy(blk, sliced + (size_t)y * width + (i << 5), (size_t)n * sizeof(uint64_t));
+            memset(blk + n, 0, (size_t)(32 - n) * sizeof(uint64_t));
+            batch_unpack_block_sse2(blk, words);
+            for (int f = 0; f < nframes; f++) {
+                frames_bits[(size_t)f * stride + (size_t)y * wpw + i] = words[f];
+            }
+        }
+    }
+    return 0;
+#else
+    (void)sliced; (void)nframes; (void)width; (void)height; (void)frames_bits;
+    return -1;
+#endif
+}
+
+int open_close_bitsliced_simd(const uint64_t* src, uint64_t* out, int width, int height, uint64_t* work) {
+#if defined(MORPH_SIMD_X86)
+    if (select_kernels() != &s_kernels_avx2 || width <= 0 || height <= 0) return -1;
+    open_close_bitsliced_avx2(src, out, width, height, work);
+    return 0;
+#else
+    (void)src; (void)out; (void)width; (void)height; (void)work;
+    return -1;
+#endif
+}
+
+void pack_gray_threshold_to_bits(const uint8_t* gray, int width, int height, int stride_bytes,
+                                 uint8_t threshold, uint32_t* dst_bits) {
+    morph_pack32_fn pack32 = select_kernels()->pack32;
+    int wpw = words_per_row(width);
+    int full = width >> 5;          // 满 32 像素的 word 数
+    int rem = width & 31;           // 行尾不足 32 像素的部分
+    uint8_t tailbuf[32];
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = gray + (size_t)y * stride_bytes;
+        uint32_t* d = dst_bits + (size_t)y * wpw;
+        for (int i = 0; i < full; i++) {
+            d[i] = pack32(row + (i << 5), threshold);
+        }
+        if (rem) {
+            // 行尾拷到补 0 的暂存区再比较，不越界读取（0 不会大于任何阈值）
+            memcpy(tailbuf, row + (full << 5), (size_t)rem);
+            memset(tailbuf + rem, 0, (size_t)(32 - rem));
+            d[full] = pack32(tailbuf, threshold);
+        }
+    }
+}
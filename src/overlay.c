@@ -0,0 +1,146 @@
+#include "overlay.h"
+#include <string.h>
+
+void overlay_clear(overlay_list* l)
+{
+    l->n_items = 0;
+    l->n_lines = 0;
+    l->n_pts = 0;
+}
+
+int overlay_add_points(overlay_list* l, uint8_t color, const uint16_t (*pts)[2], uint16_t count)
+{
+    overlay_item* it;
+    uint16_t i;
+    if (l->n_items >= OVERLAY_MAX_ITEMS || count > OVERLAY_MAX_POINTS - l->n_pts) return -1;
+    it = &l->items[l->n_items++];
+    it->kind = OVERLAY_POINTS;
+    it->color = color;
+    it->x = 0;
+    it->y = 0;
+    it->first = l->n_pts;
+    it->count = count;
+    for (i = 0; i < count; i++)
+    {
+        l->pts[l->n_pts + i][0] = (uint8_t)pts[i][0];
+        l->pts[l->n_pts + i][1] = (uint8_t)pts[i][1];
+    }
+    l->n_pts = (uint16_t)(l->n_pts + count);
+    return 0;
+}
+
+int overlay_add_row_line(overlay_list* l, uint8_t color, const uint8_t* cols)
+{
+    overlay_item* it;
+    if (l->n_items >= OVERLAY_MAX_ITEMS || l->n_lines >= OVERLAY_MAX_LINES) return -1;
+    it = &l->items[l->n_items++];
+    it->kind = OVERLAY_ROW_LINE;
+    it->color = color;
+    it->x = 0;
+    it->y = 0;
+    it->first = l->n_lines;
+    it->count = image_h;
+    memcpy(l->lines[l->n_lines++], cols, image_h);
+    return 0;
+}
+
+int overlay_add_marker(overlay_list* l, uint8_t color, int x, int y)
+{
+    overlay_item* it;
+    if (l->n_items >= OVERLAY_MAX_ITEMS) return -1;
+    it = &l->items[l->n_items++];
+    it->kind = OVERLAY_MARKER;
+    it->color = color;
+    it->x = (int16_t)x;
+    it->y = (int16_t)y;
+    it->first = 0;
+    it->count = 9;
+    return 0;
+}
+
+// 逐像素回调式展开，两种输出共用
+typedef struct {
+    overlay_pixel* px;
+    int cap;
+    int n;
+    uint8_t* img;
+    int stride;
+} overlay_sink;
+
+static void overlay_emit(overlay_sink* s, int x, int y, uint8_t color)
+{
+    if (s->img)
+    {
+        s->img[y * s->stride + x] = color;
+        return;
+    }
+    if (s->n < s->cap)
+    {
+        s->px[s->n].x = (uint8_t)x;
+        s->px[s->n].y = (uint8_t)y;
+        s->px[s->n].color = color;
+    }
+    s->n++;
+}
+
+static void overlay_walk(const overlay_list* l, overlay_sink* s)
+{
+    int k, i, dx, dy;
+    for (k = 0; k < l->n_items; k++)
+    {
+        const overlay_item* it = &l->items[k];
+        switch (it->kind)
+        {
+        case OVERLAY_POINTS:
+            for (i = 0; i < it->count; i++)
+            {
+                const uint8_t* p = l->pts[it->first + i];
+                if (p[0] < image_w && p[1] < image_h) overlay_emit(s, p[0], p[1], it->color);
+            }
+            break;
+        case OVERLAY_ROW_LINE:
+            for (i = 0; i < image_h; i++)
+            {
+                uint8_t col = l->lines[it->first][i];
+                if (col < image_w) overlay_emit(s, col, image_h - 1 - i, it->color);
+            }
+            break;
+        case OVERLAY_MARKER:
+            // 与原 draw_edge 相同：按一维下标 row*image_w+col 判断越界，界内折算回行列
+            for (dy = 1; dy >= -1; dy--)
+            {
+                for (dx = -1; dx <= 1; dx++)
+                {
+                    int idx = (it->y + dy) * image_w + (it->x + dx);
+                    if (idx >= 0 && idx < image_h * image_w) overlay_emit(s, idx % image_w, idx / image_w, it->color);
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+int overlay_rasterize(const overlay_list* l, overlay_pixel* out, int cap)
+{
+    overlay_sink s;
+    s.px = out;
+    s.cap = cap;
+    s.n = 0;
+    s.img = NULL;
+    s.stride = 0;
+    overlay_walk(l, &s);
+    return (s.n > cap) ? -1 : s.n;
+}
+
+void overlay_paint_indices(const overlay_list* l, uint8_t* out, int stride)
+{
+    overlay_sink s;
+    s.px = NULL;
+    s.cap = 0;
+    s.n = 0;
+    s.img = out;
+    s.stride = stride;
+    overlay_walk(l, &s);
+}
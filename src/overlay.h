@@ -0,0 +1,93 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+/*
+  标注显示列表（overlay）：流水线输出的 imo 保持为干净的 0/255 二值图，
+  八邻域点、左右边线、中线、拐点等标注以稀疏图元的形式另外给出，需要时再画。
+
+  设计说明：
+  - 图元三种：点集（八邻域追踪点）、逐行折线（每行一个列值，行号从下往上，同 l_border / center_line）、
+    3×3 标记（拐点）。颜色就是原先写进 imo 的标注索引 1..7，GUI / video_processor 各自按调色板上色。
+  - 列表是自包含的值类型（数据拷贝在结构体内，约 2KB），可以直接复制到别的线程上慢慢画，
+    不引用 PipelineContext 的数组，下一帧覆盖上下文也不影响已取走的列表。
+  - 画的顺序即图元顺序，后画覆盖先画；overlay_paint_indices 在 u8 标注图上的结果与原 draw_edge 逐字节一致
+    （标记沿用原来按一维下标越界丢弃的写法）。
+  - overlay_rasterize 把列表展开成按顺序排列的 (x, y, color) 像素，渲染端只需遍历这些像素（约 1k 个），
+    不再对 188×120 全图逐像素 switch。
+*/
+
+#include <stdint.h>
+#include "image.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OVERLAY_MAX_ITEMS  8
+#define OVERLAY_MAX_POINTS (2 * (USE_num))
+#define OVERLAY_MAX_LINES  3
+#define OVERLAY_MAX_PIXELS (OVERLAY_MAX_POINTS + OVERLAY_MAX_LINES * image_h + 9 * (OVERLAY_MAX_ITEMS))
+
+// 流水线的标注方式（PipelineContext.overlay_mode）
+typedef enum {
+    OVERLAY_MODE_LIST = 0, // 默认：只生成显示列表，imo 保持干净二值图
+    OVERLAY_MODE_OFF,      // 无界面回放：不生成列表，省去标注开销
+    OVERLAY_MODE_PAINT     // 兼容：生成列表并按原方式把标注索引画进 imo
+} overlay_mode;
+
+// 标注颜色索引（与原 imo 标注值一致）
+typedef enum {
+    OVERLAY_COLOR_LEFT_POINTS = 1,   // 左八邻域点
+    OVERLAY_COLOR_RIGHT_POINTS = 2,  // 右八邻域点
+    OVERLAY_COLOR_CENTER = 3,        // 中线
+    OVERLAY_COLOR_LEFT_BORDER = 4,   // 左边线
+    OVERLAY_COLOR_RIGHT_BORDER = 5,  // 右边线
+    OVERLAY_COLOR_CORNER = 6,        // 拐点
+    OVERLAY_COLOR_CORNER_FILTERED = 7 // 滤波后的拐点
+} overlay_color;
+
+typedef enum {
+    OVERLAY_POINTS = 0, // pts[first, first+count)
+    OVERLAY_ROW_LINE,   // lines[first]，image_h 个列值，第 r 个画在第 image_h-1-r 行
+    OVERLAY_MARKER      // 以 (x, y) 为中心的 3×3
+} overlay_kind;
+
+typedef struct {
+    uint8_t kind;   // overlay_kind
+    uint8_t color;  // overlay_color
+    int16_t x, y;   // MARKER 中心（图像坐标，y 向下，可在图外）
+    uint16_t first;
+    uint16_t count;
+} overlay_item;
+
+typedef struct overlay_list {
+    uint8_t n_items;
+    uint8_t n_lines;
+    uint16_t n_pts;
+    overlay_item items[OVERLAY_MAX_ITEMS];
+    uint8_t pts[OVERLAY_MAX_POINTS][2];          // [x, y]
+    uint8_t lines[OVERLAY_MAX_LINES][image_h];   // 列值，行号从下往上
+} overlay_list;
+
+typedef struct {
+    uint8_t x, y, color;
+} overlay_pixel;
+
+void overlay_clear(overlay_list* l);
+
+// 追加图元，空间不足返回 -1（列表不变）
+int overlay_add_points(overlay_list* l, uint8_t color, const uint16_t (*pts)[2], uint16_t count);
+int overlay_add_row_line(overlay_list* l, uint8_t color, const uint8_t* cols);
+int overlay_add_marker(overlay_list* l, uint8_t color, int x, int y);
+
+// 展开为按绘制顺序排列的像素（已裁剪到图内）；返回像素数，cap 不足返回 -1
+int overlay_rasterize(const overlay_list* l, overlay_pixel* out, int cap);
+
+// 把标注索引画进 u8 图（image_w×image_h，行跨度 stride 字节）
+void overlay_paint_indices(const overlay_list* l, uint8_t* out, int stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OVERLAY_H
@@ -0,0 +1,149 @@
+#ifndef PIPELINE_CONTEXT_H
+#define PIPELINE_CONTEXT_H
+
+/*
+  图像处理流水线上下文（PipelineContext）
+
+  设计说明：
+  - image_process() 原先依赖的所有文件级全局状态（八邻域点集、生长方向、左右边线、丢线信息、
+    元素识别标志、卡尔曼滤波状态、形态学位打包缓冲）统一收拢到本结构体中。
+  - 输入/输出图像不属于上下文，由调用者通过 image_process_ctx(ctx, in, out) 显式传入，
+    因此多个上下文可以在不同线程上同时处理不同的帧（离线回放时每个核一个上下文）。
+  - image_process() / process_original_to_imo() 保留为默认上下文上的薄封装，行为与原来一致。
+*/
+
+#include <stdint.h>
+#include "image.h"
+#include "growth_match.h"
+#include "border_stats.h"
+#include "image_view.h"
+#include "overlay.h"
+#include "stage_timing.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIPELINE_MORPH_WORDS (((image_w + 31) >> 5) * image_h) // 位打包缓冲 word 数（188x120 → 720）
+
+// 八邻域一步开始时的状态（时域复用从这里接着追踪）
+typedef struct {
+    uint16_t l, r;  // 左右已有点数
+    uint8_t cl[2];  // 左中心点 [x, y]
+    uint8_t cr[2];  // 右中心点 [x, y]
+} trace_step;
+
+typedef struct PipelineContext {
+    // ---- 形态学位打包缓冲（原 morph_binary_bitpacked.c 中的 s_buf1..3） ----
+    uint32_t morph_packed[PIPELINE_MORPH_WORDS];
+    uint32_t morph_tmp[PIPELINE_MORPH_WORDS];
+    uint32_t morph_out[PIPELINE_MORPH_WORDS];
+
+    // ---- 八邻域起点 ----
+    uint8_t start_point_l[2]; // 左边起点的x，y值
+    uint8_t start_point_r[2]; // 右边起点的x，y值
+
+    // ---- 八邻域点集与生长方向 ----
+    uint16_t points_l[USE_num][2]; // 左线
+    uint16_t points_r[USE_num][2]; // 右线
+    uint16_t dir_r[USE_num];       // 右边生长方向
+    uint16_t dir_l[USE_num];       // 左边生长方向
+    uint16_t data_stastics_l;      // 左边找到点的个数
+    uint16_t data_stastics_r;      // 右边找到点的个数
+    uint8_t hightest;              // 最高点
+
+    // ---- 边线与丢线信息（行号从下往上数） ----
+    uint8_t l_border[image_h];    // 左线数组
+    uint8_t r_border[image_h];    // 右线数组
+    uint8_t center_line[image_h]; // 中线数组
+    border_lost_mask left_lost;   // 左线丢失掩码（bit r = 第 r 行丢线，追踪时同步维护）
+    border_lost_mask right_lost;  // 右线丢失掩码
+    uint8_t last_left_lost_down;      // 记录左边下方最后一次左线丢失的位置 注意1这是由于局限的 这里主要是为了后续直线判断
+    uint8_t last_right_lost_down;     // 记录右边下方最后一次右线丢失的位置  注意2这是索引 实际丢线行数值要再+1
+    uint8_t last_left_lost_midstart;  // 记录中间段丢线开始位置
+    uint8_t last_right_lost_midstart; // 记录中间段丢线开始位置
+    uint8_t last_left_lost_midend;    // 记录中间段丢线结束位置
+    uint8_t last_right_lost_midend;   // 记录中间段丢线结束位置
+    uint8_t last_left_lost_up;        // 记录左边上方最后一次左线丢失的位置（初值 image_h-1）
+    uint8_t last_right_lost_up;       // 记录右边上方最后一次右线丢失的位置 注意3这是索引 实际丢线行数为image_h - last_right_lost_up
+    uint8_t left_lost_num;            // 左线丢失总行数（初值 image_h）
+    uint8_t right_lost_num;           // 右线丢失总行数（初值 image_h）
+
+    // ---- 元素识别 ----
+    uint8_t cross_flag;
+    uint8_t left_straight, right_straight, straight;
+    uint8_t island_flag;
+    uint8_t first_corner;
+    uint8_t second_corner;
+    uint8_t count_down;                  // 第一角点倒计时（跨帧状态）
+    uint8_t firstcorner_pos[2];          // [x, y]
+    uint8_t firstcorner_pos_filtered[2]; // 滤波后的位置 [x, y]（流水线未接入卡尔曼滤波，恒为 0）
+    uint8_t secondcorner_pos[2];
+    uint8_t secondcorner_pos_filtered[2];
+    border_slope slope_last;             // calculate_border_variance 只有一个点时沿用的上次斜率（定点 profile 下 Q16.16）
+    BorderStats border_stats;            // 本帧左右边线（十字补线后）与中线的前缀和
+    growth_matcher element_matcher;      // 元素识别序列模式（pipeline_context_init 时编译）
+
+    // ---- 时域复用（可选，temporal_enabled=1 开启） ----
+    // 完整追踪时记下八邻域每一步开始时的状态（左右点数与两个中心点），下一帧：
+    // 起点搜索读过的行段与上一帧相同则沿用起点；八邻域按步检查上一帧每一步读过的 3×3 邻域，
+    // 从第一个有像素变化的步开始用正常的追踪接着走（之前的点集、生长方向逐点一致，直接沿用），
+    // 一步都没变时整帧沿用。结果与完整搜索逐点一致（replay_check --temporal 校验）。
+    // 默认关闭：赛道底部随车身移动几乎每帧都变，能沿用的前缀通常很短；
+    // 开启前先用 bench_image_internal --filter image_process 在实际录像上对比 image_process_temporal 与沿用步数。
+    uint8_t temporal_enabled;
+    uint8_t temporal_valid;                          // temporal_prev / temporal_steps 是否有效
+    uint8_t temporal_found;                          // 上一帧是否找到起点
+    uint16_t temporal_nsteps;                        // 上一帧八邻域实际执行的步数
+    uint32_t temporal_prev[PIPELINE_MORPH_WORDS];    // 上一帧（填黑框后）的位图
+    trace_step temporal_steps[USE_num];              // 上一帧八邻域每一步开始时的状态
+    uint32_t temporal_hits;                          // 整帧沿用的帧数
+    uint32_t temporal_partial;                       // 沿用部分步、其余接着追踪的帧数
+    uint32_t temporal_misses;                        // 从头追踪的帧数
+    uint32_t temporal_steps_reused;                  // 累计沿用的步数
+    uint32_t temporal_steps_traced;                  // 累计实际执行的步数
+
+    // ---- 标注 ----
+    uint8_t overlay_mode;  // overlay_mode：默认 OVERLAY_MODE_LIST（imo 为干净二值图，标注在 overlay 中）
+    overlay_list overlay;  // 本帧标注显示列表
+
+#ifdef IMAGEPROC_STAGE_TIMING
+    // ---- 分阶段计时（编译期可移除，见 stage_timing.h） ----
+    stage_timing timing;
+#endif
+
+    // ---- 日志 ----
+    uint8_t log_enabled; // 0 = 不写动态日志（批量回放时可关闭）
+    int log_frame;       // 写入动态日志时使用的帧索引，-1 表示当前帧
+    uint8_t log_dir_arrays; // 1 = 边线按旧格式写 dir_l/dir_r 数组；0（默认）= 写 chain_l/chain_r 链码文本
+} PipelineContext;
+
+// 初始化上下文：清零全部状态并设置与原全局变量一致的初值
+void pipeline_context_init(PipelineContext* ctx);
+
+// 默认上下文（供 image_process()/process_original_to_imo() 等旧接口使用，非线程安全）
+PipelineContext* pipeline_default_context(void);
+
+// 在指定上下文上处理一帧：in 为 image_w×image_h 的 0/255 二值图，out 为同尺寸的输出 imo（可与 in 相同）
+void image_process_ctx(PipelineContext* ctx, const uint8_t* in, uint8_t* out);
+
+// 灰度直入：gray 为 image_w×image_h 灰度图（行跨度 stride 字节），灰度 > threshold 为白，打包后直接进入流水线
+void image_process_gray_ctx(PipelineContext* ctx, const uint8_t* gray, int stride, uint8_t threshold, uint8_t* out);
+
+// 从已打包的位图开始处理一帧：bits 为 image_h 行 × words_per_row(image_w) 的位打包输入（bit=1 为白）
+void image_process_packed_ctx(PipelineContext* ctx, const uint32_t* bits, uint8_t* out);
+
+// 从已做完开→闭运算的位图开始处理一帧（跳过形态学），供离线回放批量位切片形态学后逐帧使用
+void image_process_morphed_ctx(PipelineContext* ctx, const uint32_t* morphed, uint8_t* out);
+
+// 视图直入：按 in 的格式 / 行跨度就地读取，结果按 out 的行跨度直接写入（见 image_view.h）；参数非法返回 -1
+int image_process_view_ctx(PipelineContext* ctx, const image_view* in, uint8_t threshold, const image_out_view* out);
+
+// 边线 [begin,end) 的直线拟合方差（直线检测内部使用，基准测试直接调用）；只有一个点时沿用 ctx->slope_last
+border_variance calculate_border_variance(PipelineContext* ctx, uint8_t begin, uint8_t end, const border_prefix *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIPELINE_CONTEXT_H
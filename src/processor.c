@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stddef.h>
 #include "image.h"
+#include "pipeline_context.h"
 #ifdef PROCESSOR_VERIFY_BINARY
 #include <assert.h>
 #endif
@@ -17,28 +18,44 @@
 #endif
 #endif
 
-// 默认实现：按契约 original 已是 0/255；默认直接拷贝到 imo。
+// 默认实现：按契约 original 已是 0/255；在默认上下文上运行流水线，结果直接写入 imo_out。
 // 可选：定义 SANITIZE_INPUT 时，对非 0/255 的输入做阈值归一化。
 void process_original_to_imo(const uint8_t * RESTRICT original,
                              uint8_t * RESTRICT imo_out,
                              int width,
                              int height) {
     if (width <= 0 || height <= 0) return;
+    // 流水线按固定的 IMAGE_W×IMAGE_H 连续布局读写
+    if (width != IMAGE_W || height != IMAGE_H) return;
 
-    // 将输入 original 拷贝到全局 Grayscale（image_process 使用该缓冲作为输入）
-    for (int y = 0; y < height; ++y) {
-        memcpy(Grayscale[y], original + y * width, (size_t)width);
-    }
+    // 调用你的流水线（默认上下文，直接读 original、写 imo_out，不再经由全局 Grayscale/imo 中转）
+    image_process_ctx(pipeline_default_context(), original, imo_out);
+}
 
-    // 调用你的流水线
-    image_process();
+void process_gray_to_imo(const uint8_t * RESTRICT gray,
+                         int stride,
+                         uint8_t threshold,
+                         uint8_t * RESTRICT imo_out,
+                         int width,
+                         int height) {
+    if (width != IMAGE_W || height != IMAGE_H || stride < width) return;
+    image_process_gray_ctx(pipeline_default_context(), gray, stride, threshold, imo_out);
+}
 
-    // 若调用者传入的 imo_out 不是全局 imo，则把结果复制回去
-    if (imo_out != &imo[0][0]) {
-        for (int y = 0; y < height; ++y) {
-            memcpy(imo_out + y * width, &imo[y][0], (size_t)width);
-        }
-    }
+void process_packed_to_imo(const uint32_t * RESTRICT bits,
+                           uint8_t * RESTRICT imo_out,
+                           int width,
+                           int height) {
+    if (width != IMAGE_W || height != IMAGE_H) return;
+    image_process_packed_ctx(pipeline_default_context(), bits, imo_out);
 }
 
+int process_view_to_imo(const image_view *in,
+                        uint8_t threshold,
+                        const image_out_view *out) {
+    return image_process_view_ctx(pipeline_default_context(), in, threshold, out);
+}
 
+const overlay_list *process_last_overlay(void) {
+    return &pipeline_default_context()->overlay;
+}
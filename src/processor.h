@@ -1,7 +1,7 @@
 // 用户自定义 original->imo 处理函数声明
 // 约定：
 // - original: 输入的二值图像，值域严格使用 0(黑) 或 255(白)
-// - imo: 输出数组，0=黑、255=白；1/2/3/4/5 等保留作标注颜色索引
+// - imo: 输出数组，0=黑、255=白；标注（边线、中线、拐点）默认不画进 imo，见 process_last_overlay()
 // - width/height: 图像尺寸，当前为 188x120（可按需通用）
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
@@ -9,6 +9,8 @@
 #include <stdint.h>
 
 #include "global_image_buffer.h"
+#include "image_view.h"
+#include "overlay.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,6 +21,31 @@ void process_original_to_imo(const uint8_t *original,
                              int width,
                              int height);
 
+// 灰度直入版：gray 为灰度图（行跨度 stride 字节，可大于 width），灰度 > threshold 视为白。
+// 阈值比较与位打包在一个 SIMD 内核里完成，不再生成中间的 0/255 二值图。
+void process_gray_to_imo(const uint8_t *gray,
+                         int stride,
+                         uint8_t threshold,
+                         uint8_t *imo_out,
+                         int width,
+                         int height);
+
+// 位打包直入版：bits 为 height 行、每行 (width+31)/32 个 word 的位图（bit=1 为白，最左像素在 bit0），
+// 例如 area_downscale_threshold_rows 的输出；跳过阈值化与打包直接进入形态学
+void process_packed_to_imo(const uint32_t *bits,
+                           uint8_t *imo_out,
+                           int width,
+                           int height);
+
+// 视图版：输入为任意行跨度 / 像素格式的只读视图（cv::Mat ROI、GdkPixbuf 行指针等），
+// 输出直接写入调用者的视图（188x120，行跨度可大于宽度），不经过任何全局缓冲；参数非法返回 -1
+int process_view_to_imo(const image_view *in,
+                        uint8_t threshold,
+                        const image_out_view *out);
+
+// 默认上下文最近一帧的标注显示列表（imo 本身只含 0/255，标注按需用 overlay_rasterize 画出）
+const overlay_list *process_last_overlay(void);
+
 #ifdef __cplusplus
 }
 #endif
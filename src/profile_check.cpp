@@ -0,0 +1,187 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+#include "processor.h"
+#include "area_downscale.h"
+#include "morph_binary_bitpacked.h"
+#include "pipeline_context.h"
+
+namespace fs = std::filesystem;
+
+// 数值 profile 对比工具（浮点 / 定点，见 fixed_point.h）
+// 同一份源码分别链接 image_internal_float 与 image_internal_fixed，生成 profile_check_float / profile_check_fixed：
+//   profile_check_<p> <data_dir> <out.csv>     递归处理 data_dir 下全部视频，逐帧记录元素识别决策
+//   profile_check_<p> --compare <a.csv> <b.csv> 逐帧比较两份 CSV，任一决策翻转时退出码为 1
+// 每个视频使用一份新初始化的默认上下文（跨帧状态不串到下一个视频），关闭动态日志与标注。
+// 缩放与二值化与 video_processor 相同（区域平均 + 阈值 128 直接打包）。
+
+static const int TARGET_W = 188;
+static const int TARGET_H = 120;
+static const uint8_t BINARY_THRESHOLD = 128;
+
+#ifdef IMAGEPROC_FIXED_POINT
+static const char *PROFILE_NAME = "fixed";
+#else
+static const char *PROFILE_NAME = "float";
+#endif
+
+// 逐帧比较的决策字段（CSV 中 video、frame 之后的列）
+static const char *DECISION_FIELDS[] = {
+    "left_straight", "right_straight", "straight", "cross_flag", "island_flag",
+    "first_corner", "firstcorner_x", "firstcorner_y",
+};
+static const int DECISION_COUNT = (int)(sizeof(DECISION_FIELDS) / sizeof(DECISION_FIELDS[0]));
+
+static bool is_video(const fs::path &p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return ext == ".mp4" || ext == ".avi" || ext == ".mkv" || ext == ".mov";
+}
+
+static bool frame_to_packed(const cv::Mat &src, std::vector<uint32_t> &packed) {
+    area_src_format fmt;
+    switch (src.channels()) {
+    case 1: fmt = AREA_SRC_GRAY; break;
+    case 3: fmt = AREA_SRC_BGR; break;
+    case 4: fmt = AREA_SRC_BGRA; break;
+    default: return false;
+    }
+    packed.resize((size_t)total_words(TARGET_W, TARGET_H));
+    return src.depth() == CV_8U &&
+           area_downscale_threshold_rows(src.data, src.cols, src.rows, (int)src.step, fmt, BINARY_THRESHOLD,
+                                         packed.data(), TARGET_W, TARGET_H, 0, TARGET_H) == 0;
+}
+
+static int run_profile(const fs::path &dataDir, const fs::path &outCsv) {
+    std::vector<fs::path> videos;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dataDir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file() && is_video(it->path())) videos.push_back(it->path());
+    }
+    if (ec) {
+        std::cerr << "错误: 无法遍历目录: " << dataDir << std::endl;
+        return 3;
+    }
+    std::sort(videos.begin(), videos.end());
+
+    std::ofstream ofs(outCsv, std::ios::trunc);
+    if (!ofs) {
+        std::cerr << "错误: 无法写入: " << outCsv << std::endl;
+        return 3;
+    }
+    ofs << "video,frame";
+    for (int i = 0; i < DECISION_COUNT; ++i) ofs << ',' << DECISION_FIELDS[i];
+    ofs << '\n';
+
+    std::vector<uint32_t> packed;
+    std::vector<uint8_t> imo((size_t)TARGET_W * TARGET_H);
+    long long total = 0;
+    for (const fs::path &v : videos) {
+        cv::VideoCapture cap(v.string());
+        if (!cap.isOpened()) {
+            std::cerr << "警告: 无法打开视频，跳过: " << v << std::endl;
+            continue;
+        }
+        PipelineContext *ctx = pipeline_default_context();
+        pipeline_context_init(ctx);
+        ctx->log_enabled = 0;
+        ctx->overlay_mode = OVERLAY_MODE_OFF; // 只比较决策，不生成标注
+
+        const std::string name = fs::relative(v, dataDir, ec).generic_string();
+        cv::Mat frame;
+        int idx = 0;
+        while (cap.read(frame)) {
+            ++idx;
+            if (!frame_to_packed(frame, packed)) {
+                std::cerr << "错误: 帧缩放失败: " << name << " 帧 " << idx << std::endl;
+                return 4;
+            }
+            process_packed_to_imo(packed.data(), imo.data(), TARGET_W, TARGET_H);
+            ofs << name << ',' << idx << ',' << (int)ctx->left_straight << ',' << (int)ctx->right_straight << ','
+                << (int)ctx->straight << ',' << (int)ctx->cross_flag << ',' << (int)ctx->island_flag << ','
+                << (int)ctx->first_corner << ',' << (int)ctx->firstcorner_pos[0] << ','
+                << (int)ctx->firstcorner_pos[1] << '\n';
+        }
+        std::cout << "[" << PROFILE_NAME << "] " << name << ": " << idx << " 帧" << std::endl;
+        total += idx;
+    }
+    std::cout << "[" << PROFILE_NAME << "] 共 " << videos.size() << " 个视频, " << total << " 帧 -> " << outCsv
+              << std::endl;
+    return 0;
+}
+
+// video,frame → 决策列（原样保留为字符串）
+static bool load_csv(const fs::path &p, std::map<std::pair<std::string, int>, std::vector<std::string>> &rows) {
+    std::ifstream ifs(p);
+    if (!ifs) return false;
+    std::string line;
+    std::getline(ifs, line); // 表头
+    while (std::getline(ifs, line)) {
+        if (line.empty()) continue;
+        std::vector<std::string> cols;
+        std::stringstream ss(line);
+        std::string c;
+        while (std::getline(ss, c, ',')) cols.push_back(c);
+        if ((int)cols.size() != 2 + DECISION_COUNT) continue;
+        rows[{cols[0], std::stoi(cols[1])}] = std::vector<std::string>(cols.begin() + 2, cols.end());
+    }
+    return true;
+}
+
+static int run_compare(const fs::path &a, const fs::path &b) {
+    std::map<std::pair<std::string, int>, std::vector<std::string>> ra, rb;
+    if (!load_csv(a, ra) || !load_csv(b, rb)) {
+        std::cerr << "错误: 无法读取 CSV" << std::endl;
+        return 3;
+    }
+    std::vector<long long> flips(DECISION_COUNT, 0);
+    long long frames = 0, missing = 0, shown = 0;
+    for (const auto &kv : ra) {
+        auto it = rb.find(kv.first);
+        if (it == rb.end()) {
+            ++missing;
+            continue;
+        }
+        ++frames;
+        for (int i = 0; i < DECISION_COUNT; ++i) {
+            if (kv.second[i] == it->second[i]) continue;
+            ++flips[i];
+            if (shown++ < 50) {
+                std::cout << kv.first.first << " 帧 " << kv.first.second << ": " << DECISION_FIELDS[i] << " "
+                          << kv.second[i] << " -> " << it->second[i] << std::endl;
+            }
+        }
+    }
+    missing += (long long)rb.size() - frames;
+
+    long long total_flips = 0;
+    std::cout << "对比帧数: " << frames << "（仅一侧存在: " << missing << "）" << std::endl;
+    for (int i = 0; i < DECISION_COUNT; ++i) {
+        std::cout << "  " << DECISION_FIELDS[i] << ": " << flips[i] << " 次翻转" << std::endl;
+        total_flips += flips[i];
+    }
+    return (total_flips || missing) ? 1 : 0;
+}
+
+static void print_usage() {
+    std::cerr << "用法: profile_check_<profile> <data_dir> <out.csv>" << std::endl;
+    std::cerr << "      profile_check_<profile> --compare <a.csv> <b.csv>" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 4 && std::string(argv[1]) == "--compare") {
+        return run_compare(argv[2], argv[3]);
+    }
+    if (argc != 3) {
+        print_usage();
+        return 2;
+    }
+    return run_profile(argv[1], argv[2]);
+}
@@ -0,0 +1,577 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include "area_downscale.h"
+#include "morph_binary_bitpacked.h"
+#include "pipeline_context.h"
+#include "frame_archive.h"
+#include "chain_code.h"
+
+namespace fs = std::filesystem;
+
+// 录像回放等价校验：逐帧重跑流水线，与车上记录的 dir_l / dir_r / cross_flag / first_corner / 左右边线比较
+//   replay_check [data_dir] [--jobs N] [--png-dir DIR] [--threshold T] [--temporal] [--batch] [--golden DIR] [--write DIR]
+// - 一个子目录即一次录像（run）：帧来源优先用 frames_index.csv 的 png_path 指向的 PNG 序列
+//   （按文件名在 <run>/frames_png、<run>、<png-dir>/<run> 下查找，无损）；其次是 <run>/frames.ipf 归档
+//   （video_processor --archive 由 output.mp4 生成，mmap 后按帧取指针直接进流水线，不再解码），最后解码 <run>/output.mp4。
+//   位图归档已按录制时的阈值打包，--threshold 只对灰度归档与 PNG / 视频生效；增量压缩的归档按帧序原地解码。
+// - 期望值取自 <run>/frames_index.csv 与 <run>/aligned.csv 中存在的列（列名可带动态日志的中文前缀，
+//   如 "左 生长dir_l"；userlog 默认写的链码列 "左 链码chain_l" 经 chain_parse 还原成 dir_l），缺的列不比；--golden DIR 时改用 DIR/<run>.csv（由 --write 生成）作为期望值，
+//   用于性能改写前后的逐帧等价校验（车上固件与桌面版本不一致时，录像本身的记录只能作参考）。
+// - 每个 run 一个上下文、在各自线程上按帧序处理（跨帧状态与车上一致），全部 run 并行（--jobs，默认 CPU 核数）。
+// - --batch：每读满 64 帧用 morph_open_close_batch 一次算完开→闭，再逐帧 image_process_morphed_ctx；
+//   结果与逐帧路径一致。AVX2 下逐帧单遍内核已比整批（含两次转置）快，默认不开，主要用于校验批量路径。
+// - 报告每个 run 的首个分歧（帧号、字段、下标、期望 / 实际）与各字段分歧帧数，以及总体帧率；有分歧时退出码为 1。
+
+static const int TARGET_W = image_w;
+static const int TARGET_H = image_h;
+
+// 对比字段：CSV 列名为 name，或以 name 结尾且前面是中文前缀 / 空格（动态日志的列名）
+enum FieldId { F_DIR_L = 0, F_DIR_R, F_CROSS_FLAG, F_FIRST_CORNER, F_L_BORDER, F_R_BORDER, F_COUNT };
+static const char *FIELD_NAMES[F_COUNT] = {"dir_l", "dir_r", "cross_flag", "first_corner", "l_border", "r_border"};
+// userlog 默认把边线写成链码文本（"左 链码chain_l"），读入时还原成 dir_l / dir_r 数组再比较
+static const char *CHAIN_NAMES[F_COUNT] = {"chain_l", "chain_r", nullptr, nullptr, nullptr, nullptr};
+
+struct Options {
+    fs::path dataDir = "data";
+    fs::path pngDir;
+    fs::path golden;
+    fs::path write;
+    int jobs = 0;
+    int threshold = 128;
+    bool temporal = false;
+    bool batch = false;
+};
+
+// 期望值：frame_id → 各字段原始单元格（空串表示该帧没有记录）
+struct Expected {
+    bool has[F_COUNT] = {};
+    std::map<int, std::vector<std::string>> rows;
+    std::map<int, std::string> png; // frame_id → png_path 的文件名
+};
+
+struct Run {
+    std::string name;
+    fs::path dir;
+    Expected expected;
+    std::vector<std::pair<int, fs::path>> pngs; // 解析出的 PNG 序列（按 frame_id）
+    fs::path archive;
+    fs::path video;
+};
+
+struct Report {
+    bool ok = false;          // 帧来源可用
+    std::string source;
+    std::string error;
+    long long frames = 0;
+    long long compared = 0;   // 有期望值的帧
+    long long diverged[F_COUNT] = {};
+    std::string first;        // 首个分歧的描述
+    double seconds = 0;
+};
+
+// ---------------- CSV ----------------
+
+static std::vector<std::string> parse_csv_line(const std::string &line) {
+    std::vector<std::string> cols;
+    std::string cur;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                cur += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                cur += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            cols.push_back(cur);
+            cur.clear();
+        } else if (c != '\r') {
+            cur += c;
+        }
+    }
+    cols.push_back(cur);
+    return cols;
+}
+
+static bool header_matches(const std::string &h, const std::string &name) {
+    if (h == name) return true;
+    if (h.size() <= name.size() || h.compare(h.size() - name.size(), name.size(), name) != 0) return false;
+    unsigned char prev = (unsigned char)h[h.size() - name.size() - 1];
+    return prev >= 0x80 || prev == ' '; // "左 生长dir_l"；不会误配 "last_left_lost_up" 之类
+}
+
+// 链码文本 → "[d0,d1,...]"（生长方向记录值）；解析失败返回空串，按该帧无记录处理
+static std::string chain_text_to_dirs(const std::string &text) {
+    chain_code c;
+    uint16_t dirs[CHAIN_MAX_POINTS];
+    if (text.empty() || chain_parse(&c, text.c_str()) < 0) return std::string();
+    chain_decode(&c, nullptr, dirs);
+    std::string s = "[";
+    for (uint16_t i = 0; i < c.count; ++i) {
+        if (i) s += ',';
+        s += std::to_string(dirs[i]);
+    }
+    return s + "]";
+}
+
+// 读一份 CSV 中的对比列（已由前面的文件提供的字段不覆盖）
+static bool load_expected(const fs::path &p, Expected &e) {
+    std::ifstream ifs(p);
+    if (!ifs) return false;
+    std::string line;
+    if (!std::getline(ifs, line)) return false;
+    if (line.size() >= 3 && (unsigned char)line[0] == 0xEF) line.erase(0, 3); // UTF-8 BOM
+    std::vector<std::string> header = parse_csv_line(line);
+    int idCol = -1, pngCol = -1;
+    int col[F_COUNT];
+    bool chain[F_COUNT] = {};
+    for (int f = 0; f < F_COUNT; ++f) col[f] = -1;
+    for (int c = 0; c < (int)header.size(); ++c) {
+        if (header[c] == "frame_id") idCol = c;
+        if (header[c] == "png_path") pngCol = c;
+        for (int f = 0; f < F_COUNT; ++f) {
+            if (e.has[f] || col[f] >= 0) continue;
+            if (header_matches(header[c], FIELD_NAMES[f])) {
+                col[f] = c;
+            } else if (CHAIN_NAMES[f] && header_matches(header[c], CHAIN_NAMES[f])) {
+                col[f] = c;
+                chain[f] = true;
+            }
+        }
+    }
+    if (idCol < 0) return false;
+    while (std::getline(ifs, line)) {
+        if (line.empty()) continue;
+        std::vector<std::string> cols = parse_csv_line(line);
+        if ((int)cols.size() <= idCol) continue;
+        int id;
+        try {
+            id = std::stoi(cols[idCol]);
+        } catch (...) {
+            continue;
+        }
+        std::vector<std::string> &row = e.rows[id];
+        row.resize(F_COUNT);
+        for (int f = 0; f < F_COUNT; ++f) {
+            if (col[f] >= 0 && col[f] < (int)cols.size()) row[f] = chain[f] ? chain_text_to_dirs(cols[col[f]]) : cols[col[f]];
+        }
+        if (pngCol >= 0 && pngCol < (int)cols.size() && !e.png.count(id)) {
+            std::string s = cols[pngCol];
+            size_t slash = s.find_last_of("/\\"); // 录制端是 Windows 路径
+            e.png[id] = (slash == std::string::npos) ? s : s.substr(slash + 1);
+        }
+    }
+    for (int f = 0; f < F_COUNT; ++f) e.has[f] = e.has[f] || col[f] >= 0;
+    return true;
+}
+
+// "[1,2,3]" 或 "1" → 整数序列；空串返回 false（该帧无记录）
+static bool parse_values(const std::string &s, std::vector<int> &out) {
+    out.clear();
+    size_t i = s.find_first_not_of(" [");
+    if (i == std::string::npos) return s.find('[') != std::string::npos; // "[]" 为空数组
+    std::stringstream ss(s.substr(i));
+    std::string tok;
+    while (std::getline(ss, tok, ',')) {
+        size_t end = tok.find(']');
+        if (end != std::string::npos) tok.erase(end);
+        if (tok.find_first_not_of(' ') == std::string::npos) continue;
+        try {
+            out.push_back((int)std::stod(tok));
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------- 实际值 ----------------
+
+static std::vector<int> actual_values(const PipelineContext *ctx, int f) {
+    switch (f) {
+    case F_DIR_L: return std::vector<int>(ctx->dir_l, ctx->dir_l + ctx->data_stastics_l);
+    case F_DIR_R: return std::vector<int>(ctx->dir_r, ctx->dir_r + ctx->data_stastics_r);
+    case F_CROSS_FLAG: return {ctx->cross_flag};
+    case F_FIRST_CORNER: return {ctx->first_corner};
+    case F_L_BORDER: return std::vector<int>(ctx->l_border, ctx->l_border + image_h);
+    case F_R_BORDER: return std::vector<int>(ctx->r_border, ctx->r_border + image_h);
+    default: return {};
+    }
+}
+
+static std::string format_values(const std::vector<int> &v) {
+    std::string s = "[";
+    for (size_t i = 0; i < v.size(); ++i) {
+        if (i) s += ',';
+        s += std::to_string(v[i]);
+    }
+    return s + "]";
+}
+
+// ---------------- 回放 ----------------
+
+static bool frame_to_packed(const cv::Mat &src, uint8_t threshold, uint32_t *packed) {
+    area_src_format fmt;
+    switch (src.channels()) {
+    case 1: fmt = AREA_SRC_GRAY; break;
+    case 3: fmt = AREA_SRC_BGR; break;
+    case 4: fmt = AREA_SRC_BGRA; break;
+    default: return false;
+    }
+    return src.depth() == CV_8U && area_downscale_threshold_rows(src.data, src.cols, src.rows, (int)src.step, fmt,
+                                                                 threshold, packed, TARGET_W, TARGET_H, 0, TARGET_H) == 0;
+}
+
+static void replay_run(const Run &run, const Options &opt, Report &rep) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::unique_ptr<PipelineContext> ctx(new PipelineContext);
+    pipeline_context_init(ctx.get());
+    ctx->log_enabled = 0;
+    ctx->overlay_mode = OVERLAY_MODE_OFF;
+    ctx->temporal_enabled = opt.temporal ? 1 : 0;
+
+    std::vector<uint32_t> packed((size_t)total_words(TARGET_W, TARGET_H));
+    std::vector<uint8_t> imo((size_t)TARGET_W * TARGET_H);
+    std::ofstream out;
+    if (!opt.write.empty()) {
+        out.open(opt.write / (run.name + ".csv"), std::ios::trunc);
+        if (!out) {
+            rep.error = "无法写入 " + (opt.write / (run.name + ".csv")).string();
+            return;
+        }
+        out << "frame_id";
+        for (int f = 0; f < F_COUNT; ++f) out << ',' << FIELD_NAMES[f];
+        out << '\n';
+    }
+
+    cv::VideoCapture cap;
+    ipf_reader arc = {};
+    ipf_decoder dec = {};
+    size_t next_png = 0;
+    uint32_t next_arc = 0;
+    bool use_arc = false;
+    if (!run.pngs.empty()) {
+        rep.source = "PNG x" + std::to_string(run.pngs.size());
+    } else if (!run.archive.empty()) {
+        if (ipf_reader_open(&arc, run.archive.string().c_str()) != 0) {
+            rep.error = "无法打开归档 " + run.archive.string();
+            return;
+        }
+        if (arc.width != TARGET_W || arc.height != TARGET_H) {
+            rep.error = "归档尺寸 " + std::to_string(arc.width) + "x" + std::to_string(arc.height) + " 与流水线不符";
+            ipf_reader_close(&arc);
+            return;
+        }
+        if (arc.format == IPF_FORMAT_PACKED && ipf_decoder_init(&dec, &arc) != 0) {
+            rep.error = "内存不足";
+            ipf_reader_close(&arc);
+            return;
+        }
+        use_arc = true;
+        rep.source = run.archive.filename().string() +
+                     (arc.format == IPF_FORMAT_GRAY8 ? "（灰度）" : arc.keyframe_interval ? "（位图，增量）" : "（位图）");
+    } else if (cap.open(run.video.string())) {
+        rep.source = run.video.filename().string();
+    } else {
+        rep.error = "没有可用的帧来源（PNG 序列、frames.ipf 或 output.mp4）";
+        return;
+    }
+    rep.ok = true;
+
+    cv::Mat frame;
+    std::vector<int> want;
+    int video_idx = 0;
+    // 取下一帧的位图：成功返回 1（id、bits 有效，bits 在下一次调用前有效），读完返回 0，出错返回 -1（已填 rep.error）
+    auto next_frame = [&](int &id, const uint32_t *&bits) -> int {
+        bits = packed.data();
+        if (use_arc) {
+            if (next_arc >= arc.frame_count) return 0;
+            const void *p = (arc.format == IPF_FORMAT_PACKED) ? (const void *)ipf_decoder_frame(&dec, next_arc)
+                                                              : ipf_reader_frame(&arc, next_arc);
+            id = (int)++next_arc;
+            if (!p) {
+                rep.error = "归档帧 " + std::to_string(id) + " 无法读取";
+                return -1;
+            }
+            if (arc.format == IPF_FORMAT_PACKED) {
+                bits = static_cast<const uint32_t *>(p); // 关键帧零拷贝指向映像，增量帧指向解码缓冲区
+            } else {
+                pack_gray_threshold_to_bits(static_cast<const uint8_t *>(p), TARGET_W, TARGET_H, TARGET_W,
+                                            (uint8_t)opt.threshold, packed.data());
+            }
+        } else if (!run.pngs.empty()) {
+            if (next_png >= run.pngs.size()) return 0;
+            id = run.pngs[next_png].first;
+            frame = cv::imread(run.pngs[next_png].second.string(), cv::IMREAD_UNCHANGED);
+            ++next_png;
+            if (frame.empty()) {
+                rep.error = "无法读取 " + run.pngs[next_png - 1].second.string();
+                return -1;
+            }
+        } else {
+            if (!cap.read(frame)) return 0;
+            id = ++video_idx;
+        }
+        if (!use_arc && !frame_to_packed(frame, (uint8_t)opt.threshold, packed.data())) {
+            rep.error = "帧 " + std::to_string(id) + " 缩放失败";
+            return -1;
+        }
+        return 1;
+    };
+    // 一帧处理完：写出结果并与期望值比较
+    auto finish_frame = [&](int id) {
+        ++rep.frames;
+        if (out.is_open()) {
+            out << id;
+            for (int f = 0; f < F_COUNT; ++f) {
+                std::vector<int> v = actual_values(ctx.get(), f);
+                if (f == F_CROSS_FLAG || f == F_FIRST_CORNER) out << ',' << v[0];
+                else out << ",\"" << format_values(v) << '"';
+            }
+            out << '\n';
+        }
+
+        auto it = run.expected.rows.find(id);
+        if (it == run.expected.rows.end()) return;
+        bool any = false;
+        for (int f = 0; f < F_COUNT; ++f) {
+            if (!run.expected.has[f] || !parse_values(it->second[f], want)) continue;
+            any = true;
+            std::vector<int> got = actual_values(ctx.get(), f);
+            if (got == want) continue;
+            ++rep.diverged[f];
+            if (rep.first.empty()) {
+                size_t k = 0;
+                while (k < got.size() && k < want.size() && got[k] == want[k]) ++k;
+                std::ostringstream os;
+                os << "帧 " << id << " " << FIELD_NAMES[f] << "[" << k << "]: 期望 "
+                   << (k < want.size() ? std::to_string(want[k]) : std::string("(结束)")) << "，实际 "
+                   << (k < got.size() ? std::to_string(got[k]) : std::string("(结束)")) << "（长度 " << want.size()
+                   << " / " << got.size() << "）";
+                rep.first = os.str();
+            }
+        }
+        rep.compared += any;
+    };
+
+    int id;
+    const uint32_t *bits;
+    if (!opt.batch) {
+        while (next_frame(id, bits) > 0) {
+            image_process_packed_ctx(ctx.get(), bits, imo.data());
+            finish_frame(id);
+        }
+    } else {
+        // 每次读满 64 帧做一次位切片开→闭，再逐帧从形态学之后接着跑（跨帧状态仍按帧序推进）
+        const size_t words = packed.size();
+        std::vector<uint32_t> batch_in(MORPH_BATCH_LANES * words), batch_out(MORPH_BATCH_LANES * words);
+        std::vector<uint64_t> ws(morph_batch_workspace_words(TARGET_W, TARGET_H));
+        int ids[MORPH_BATCH_LANES];
+        bool more = true;
+        while (more) {
+            int nb = 0;
+            while (nb < MORPH_BATCH_LANES && (more = next_frame(id, bits) > 0)) {
+                std::copy(bits, bits + words, batch_in.begin() + (ptrdiff_t)(nb * words));
+                ids[nb++] = id;
+            }
+            if (nb == 0) break;
+            morph_open_close_batch(batch_in.data(), batch_out.data(), nb, TARGET_W, TARGET_H, ws.data());
+            for (int f = 0; f < nb; ++f) {
+                image_process_morphed_ctx(ctx.get(), batch_out.data() + f * words, imo.data());
+                finish_frame(ids[f]);
+            }
+        }
+    }
+    if (use_arc) {
+        ipf_decoder_free(&dec);
+        ipf_reader_close(&arc);
+    }
+    rep.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ---------------- 发现 run ----------------
+
+static void resolve_pngs(Run &run, const Options &opt) {
+    if (run.expected.png.empty()) return;
+    std::vector<fs::path> dirs = {run.dir / "frames_png", run.dir};
+    if (!opt.pngDir.empty()) dirs.push_back(opt.pngDir / run.name);
+    for (const fs::path &d : dirs) {
+        std::vector<std::pair<int, fs::path>> found;
+        std::error_code ec;
+        for (const auto &kv : run.expected.png) {
+            fs::path p = d / kv.second;
+            if (!fs::is_regular_file(p, ec)) break;
+            found.emplace_back(kv.first, p);
+        }
+        if (found.size() == run.expected.png.size()) {
+            run.pngs = std::move(found);
+            return;
+        }
+    }
+}
+
+static std::vector<Run> discover_runs(const Options &opt) {
+    std::vector<Run> runs;
+    std::error_code ec;
+    for (fs::directory_iterator it(opt.dataDir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_directory()) continue;
+        Run run;
+        run.dir = it->path();
+        run.name = it->path().filename().string();
+        run.video = run.dir / "output.mp4";
+        if (!opt.golden.empty()) {
+            load_expected(opt.golden / (run.name + ".csv"), run.expected);
+            // golden 中没有 png_path，帧来源仍按录像目录解析
+            Expected rec;
+            load_expected(run.dir / "frames_index.csv", rec);
+            run.expected.png = std::move(rec.png);
+        } else {
+            load_expected(run.dir / "frames_index.csv", run.expected);
+            load_expected(run.dir / "aligned.csv", run.expected);
+        }
+        resolve_pngs(run, opt);
+        if (fs::is_regular_file(run.dir / "frames.ipf", ec)) run.archive = run.dir / "frames.ipf";
+        // 既无记录也无帧来源的目录（如 11.10 的原始视频）不算 run；有记录但缺帧来源的报告为跳过
+        if (run.pngs.empty() && run.archive.empty() && !fs::exists(run.video, ec) &&
+            !fs::exists(run.dir / "frames_index.csv", ec)) continue;
+        runs.push_back(std::move(run));
+    }
+    std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) { return a.name < b.name; });
+    return runs;
+}
+
+// ---------------- main ----------------
+
+static void print_usage() {
+    std::cerr << "用法: replay_check [data_dir] [--jobs N] [--png-dir DIR] [--threshold T] [--temporal] [--batch]" << std::endl;
+    std::cerr << "                    [--golden DIR] [--write DIR]" << std::endl;
+    std::cerr << "  data_dir     - 录像目录（默认 data），每个子目录一个 run" << std::endl;
+    std::cerr << "  --jobs N     - 并行 run 数，默认等于 CPU 核数" << std::endl;
+    std::cerr << "  --png-dir    - PNG 序列所在目录（<png-dir>/<run>/frame_xxxxxx.png）" << std::endl;
+    std::cerr << "  --threshold  - 二值化阈值（默认 128，灰度 > T 为白）" << std::endl;
+    std::cerr << "  --temporal   - 开启追踪时域复用（校验其与完整搜索逐帧一致）" << std::endl;
+    std::cerr << "  --batch      - 形态学按 64 帧一批走位切片（morph_open_close_batch），校验其与逐帧路径一致" << std::endl;
+    std::cerr << "  --golden DIR - 以 DIR/<run>.csv 为期望值（而不是录像中记录的列）" << std::endl;
+    std::cerr << "  --write DIR  - 把本次结果写成 DIR/<run>.csv，供之后 --golden 使用" << std::endl;
+}
+
+static bool parse_args(int argc, char **argv, Options &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        try {
+            if (a == "--jobs" && i + 1 < argc) opt.jobs = std::stoi(argv[++i]);
+            else if (a == "--png-dir" && i + 1 < argc) opt.pngDir = argv[++i];
+            else if (a == "--threshold" && i + 1 < argc) opt.threshold = std::stoi(argv[++i]);
+            else if (a == "--golden" && i + 1 < argc) opt.golden = argv[++i];
+            else if (a == "--write" && i + 1 < argc) opt.write = argv[++i];
+            else if (a == "--temporal") opt.temporal = true;
+            else if (a == "--batch") opt.batch = true;
+            else if (!a.empty() && a[0] != '-') opt.dataDir = a;
+            else {
+                std::cerr << "未知参数: " << a << std::endl;
+                return false;
+            }
+        } catch (...) {
+            return false;
+        }
+    }
+    if (opt.jobs <= 0) {
+        unsigned hc = std::thread::hardware_concurrency();
+        opt.jobs = hc ? (int)hc : 1;
+    }
+    return opt.threshold >= 0 && opt.threshold <= 255;
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage();
+        return 2;
+    }
+    if (!opt.write.empty()) {
+        std::error_code ec;
+        fs::create_directories(opt.write, ec);
+    }
+
+    std::vector<Run> runs = discover_runs(opt);
+    if (runs.empty()) {
+        std::cerr << "错误: " << opt.dataDir << " 下没有可回放的 run" << std::endl;
+        return 3;
+    }
+
+    std::vector<Report> reports(runs.size());
+    std::atomic<size_t> next{0};
+    std::mutex print_mutex;
+    auto t0 = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next++) < runs.size()) {
+            replay_run(runs[i], opt, reports[i]);
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[" << runs[i].name << "] " << reports[i].frames << " 帧完成" << std::endl;
+        }
+    };
+    const int threads = std::min<int>(opt.jobs, (int)runs.size());
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) pool.emplace_back(worker);
+    for (auto &t : pool) t.join();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    long long total = 0, compared = 0, diverged_runs = 0;
+    bool failed = false;
+    std::cout << std::endl;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const Run &run = runs[i];
+        const Report &r = reports[i];
+        total += r.frames;
+        compared += r.compared;
+        std::cout << run.name << ": ";
+        if (!r.ok) {
+            std::cout << "跳过（" << r.error << "）" << std::endl;
+            continue;
+        }
+        std::cout << r.source << "，" << r.frames << " 帧，对比 " << r.compared << " 帧，"
+                  << (r.seconds > 0 ? (long long)(r.frames / r.seconds) : 0) << " 帧/秒" << std::endl;
+        if (!r.error.empty()) {
+            std::cout << "  错误: " << r.error << std::endl;
+            failed = true;
+        }
+        std::string cols;
+        for (int f = 0; f < F_COUNT; ++f) {
+            if (!run.expected.has[f]) continue;
+            cols += std::string(cols.empty() ? "" : " ") + FIELD_NAMES[f] + "=" + std::to_string(r.diverged[f]);
+        }
+        if (cols.empty()) {
+            std::cout << "  无可对比列" << std::endl;
+            continue;
+        }
+        std::cout << "  分歧帧数: " << cols << std::endl;
+        if (!r.first.empty()) {
+            std::cout << "  首个分歧: " << r.first << std::endl;
+            ++diverged_runs;
+        }
+    }
+    std::cout << "共 " << runs.size() << " 个 run，" << total << " 帧（对比 " << compared << " 帧），"
+              << threads << " 线程，总体 " << (wall > 0 ? (long long)(total / wall) : 0) << " 帧/秒" << std::endl;
+    if (diverged_runs) std::cout << diverged_runs << " 个 run 存在分歧" << std::endl;
+    return (diverged_runs || failed) ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L // clock_gettime / CLOCK_MONOTONIC（C11 严格模式下默认不可见）
+#endif
+
+#include "stage_timing.h"
+#include "dynamic_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static const char* const s_stage_names[STAGE_TIMING_COLUMNS] = {
+    "morph", "draw_rectan", "temporal", "start_point", "search_l_r", "lost_lines", "cross_detect",
+    "straight_detect", "firstcorner_detect", "center_line", "unpack", "draw_edge", "userlog",
+    "total", "trace_iters",
+};
+
+uint64_t stage_timing_now_ns(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (uint64_t)(c.QuadPart / f.QuadPart) * 1000000000ull +
+           (uint64_t)(c.QuadPart % f.QuadPart) * 1000000000ull / (uint64_t)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void stage_timing_reset(stage_timing* t)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+void stage_timing_end(stage_timing* t)
+{
+    t->cur[STAGE_TIMING_TOTAL] = (uint32_t)(STAGE_TIMING_NOW() - t->t0);
+    memcpy(t->ring[t->frames & (STAGE_TIMING_RING - 1)], t->cur, sizeof(t->cur));
+    t->frames++;
+}
+
+const char* stage_timing_name(int column)
+{
+    if (column < 0 || column >= STAGE_TIMING_COLUMNS) return NULL;
+    return s_stage_names[column];
+}
+
+static int cmp_u32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// 最近秩：第 ceil(q·n/100) 小的值
+static uint32_t rank_pct(const uint32_t* sorted, int n, int q)
+{
+    int k = (n * q + 99) / 100;
+    return sorted[(k > 0 ? k : 1) - 1];
+}
+
+int stage_timing_summary(const stage_timing* t, stage_timing_stat* out)
+{
+    uint32_t v[STAGE_TIMING_RING];
+    int n = (t->frames < STAGE_TIMING_RING) ? (int)t->frames : STAGE_TIMING_RING;
+    int c, i;
+    for (c = 0; c < STAGE_TIMING_COLUMNS; c++)
+    {
+        out[c].count = (uint32_t)n;
+        if (n == 0)
+        {
+            out[c].p50 = out[c].p99 = out[c].max = 0;
+            continue;
+        }
+        for (i = 0; i < n; i++) v[i] = t->ring[i][c];
+        qsort(v, (size_t)n, sizeof(v[0]), cmp_u32);
+        out[c].p50 = rank_pct(v, n, 50);
+        out[c].p99 = rank_pct(v, n, 99);
+        out[c].max = v[n - 1];
+    }
+    return n;
+}
+
+void stage_timing_log(const stage_timing* t, int frame_index)
+{
+    stage_timing_stat s[STAGE_TIMING_COLUMNS];
+    uint32_t p50[STAGE_TIMING_COLUMNS], p99[STAGE_TIMING_COLUMNS], max[STAGE_TIMING_COLUMNS];
+    int c;
+    if (t->frames == 0) return;
+    log_add_uint32_array("耗时 本帧stage_" STAGE_TIMING_UNIT, t->ring[(t->frames - 1) & (STAGE_TIMING_RING - 1)],
+                         STAGE_TIMING_COLUMNS, frame_index);
+    if (t->frames % STAGE_TIMING_RING) return;
+    stage_timing_summary(t, s);
+    for (c = 0; c < STAGE_TIMING_COLUMNS; c++)
+    {
+        p50[c] = s[c].p50;
+        p99[c] = s[c].p99;
+        max[c] = s[c].max;
+    }
+    log_add_uint32_array("耗时 窗口p50", p50, STAGE_TIMING_COLUMNS, frame_index);
+    log_add_uint32_array("耗时 窗口p99", p99, STAGE_TIMING_COLUMNS, frame_index);
+    log_add_uint32_array("耗时 窗口max", max, STAGE_TIMING_COLUMNS, frame_index);
+}
+
+int stage_timing_write_csv(const stage_timing* t, const char* path)
+{
+    stage_timing_stat s[STAGE_TIMING_COLUMNS];
+    FILE* fp;
+    int c;
+    fp = fopen(path, "w");
+    if (!fp) return -1;
+    stage_timing_summary(t, s);
+    fprintf(fp, "stage,unit,count,p50,p99,max\n");
+    for (c = 0; c < STAGE_TIMING_COLUMNS; c++)
+    {
+        fprintf(fp, "%s,%s,%u,%u,%u,%u\n", s_stage_names[c], (c == STAGE_TIMING_TRACE_ITERS) ? "iter" : STAGE_TIMING_UNIT,
+                (unsigned)s[c].count, (unsigned)s[c].p50, (unsigned)s[c].p99, (unsigned)s[c].max);
+    }
+    return (fclose(fp) == 0) ? 0 : -1;
+}
@@ -0,0 +1,144 @@
+#ifndef STAGE_TIMING_H
+#define STAGE_TIMING_H
+
+/*
+  流水线分阶段计时（可在编译期整体移除）
+
+  设计说明：
+  - 定义 IMAGEPROC_STAGE_TIMING（CMake 选项 -DIMAGEPROC_STAGE_TIMING=ON）时，PipelineContext 带一个 stage_timing，
+    image_process 在形态学、填黑框、找起点、八邻域、丢线、十字、直线、第一角点、中线、解包、标注、userlog
+    各阶段之间打点，并统计八邻域循环次数；未定义时下面的 STAGE_TIMING_* 宏展开为空，上下文里也没有该字段，
+    热路径上不留任何指令。
+  - 打点只做一次取时钟与一次减法：阶段耗时 = 本次打点 - 上次打点，同一阶段多次经过时累加。
+    时钟默认为单调时钟（纳秒，POSIX clock_gettime / Windows QPC）；定义 IMAGEPROC_STAGE_TIMING_TSC 时在 x86 上
+    改读 TSC（单位为周期）；嵌入式可自行定义 STAGE_TIMING_NOW()（如 DWT->CYCCNT）与 STAGE_TIMING_UNIT。
+  - 每帧一条记录写入固定大小的环形缓冲（STAGE_TIMING_RING 帧），只保留最近一个窗口，内存固定。
+  - 汇总：stage_timing_summary 对环内各列求 p50 / p99 / max（最近秩法）；
+    stage_timing_log 每帧把各阶段耗时写进动态日志，每满一个窗口再写一次 p50 / p99 / max；
+    stage_timing_write_csv 把汇总写成单独的 CSV（video_processor --timing-csv）。
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    STAGE_MORPH = 0,      // open_close_bitpacked_fused
+    STAGE_DRAW_RECTAN,    // image_draw_rectan_bits
+    STAGE_TEMPORAL,       // 时域复用：起点行段比对 / 保存上一帧位图
+    STAGE_START_POINT,    // get_start_point_bits
+    STAGE_SEARCH_L_R,     // search_l_r_bits（含边线同步提取，即原 get_left / get_right）
+    STAGE_LOST_LINES,     // get_lost_lines
+    STAGE_CROSS,          // cross_detect
+    STAGE_STRAIGHT,       // border_stats_build + straight_detect
+    STAGE_FIRSTCORNER,    // firstcorner_detect
+    STAGE_CENTER_LINE,    // 求中线 + 中线前缀和
+    STAGE_UNPACK,         // 位图解包到 imo
+    STAGE_DRAW_EDGE,      // 标注（显示列表 / 画进 imo）
+    STAGE_USERLOG,        // userlog
+    STAGE_COUNT
+} pipeline_stage;
+
+// 每帧记录的列：各阶段耗时，之后是整帧耗时与八邻域循环次数
+#define STAGE_TIMING_TOTAL       (STAGE_COUNT)
+#define STAGE_TIMING_TRACE_ITERS (STAGE_COUNT + 1)
+#define STAGE_TIMING_COLUMNS     (STAGE_COUNT + 2)
+
+#ifndef STAGE_TIMING_RING
+#define STAGE_TIMING_RING 256 // 环形缓冲帧数（2 的幂）
+#endif
+
+#ifndef STAGE_TIMING_NOW
+  #if defined(IMAGEPROC_STAGE_TIMING_TSC) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+    #if defined(_MSC_VER)
+      #include <intrin.h>
+    #else
+      #include <x86intrin.h>
+    #endif
+    #define STAGE_TIMING_NOW()  ((uint64_t)__rdtsc())
+    #define STAGE_TIMING_UNIT   "cycles"
+  #else
+    #define STAGE_TIMING_NOW()  stage_timing_now_ns()
+    #define STAGE_TIMING_UNIT   "ns"
+  #endif
+#endif
+#ifndef STAGE_TIMING_UNIT
+#define STAGE_TIMING_UNIT "ticks"
+#endif
+
+typedef struct {
+    uint32_t ring[STAGE_TIMING_RING][STAGE_TIMING_COLUMNS];
+    uint32_t frames;                    // 累计记录帧数（环内有效 min(frames, STAGE_TIMING_RING) 帧）
+    uint32_t cur[STAGE_TIMING_COLUMNS]; // 本帧累加中
+    uint64_t t0;                        // 本帧起点
+    uint64_t last;                      // 上一次打点
+} stage_timing;
+
+typedef struct {
+    uint32_t count; // 参与统计的帧数
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t max;
+} stage_timing_stat;
+
+/* 兼容 C89/C99 的 inline 定义 */
+#if (defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L)) || defined(__cplusplus)
+  #define STAGE_TIMING_INLINE static inline
+#else
+  #define STAGE_TIMING_INLINE static
+#endif
+
+// 单调时钟（纳秒）
+uint64_t stage_timing_now_ns(void);
+
+void stage_timing_reset(stage_timing* t);
+
+STAGE_TIMING_INLINE void stage_timing_begin(stage_timing* t)
+{
+    int i;
+    for (i = 0; i < STAGE_TIMING_COLUMNS; i++) t->cur[i] = 0;
+    t->t0 = STAGE_TIMING_NOW();
+    t->last = t->t0;
+}
+
+STAGE_TIMING_INLINE void stage_timing_mark(stage_timing* t, int stage)
+{
+    uint64_t now = STAGE_TIMING_NOW();
+    t->cur[stage] += (uint32_t)(now - t->last);
+    t->last = now;
+}
+
+// 结束本帧：写入整帧耗时并压入环形缓冲
+void stage_timing_end(stage_timing* t);
+
+// 各列名称（阶段名、"total"、"trace_iters"），column 越界返回 NULL
+const char* stage_timing_name(int column);
+
+// 对环内最近 min(frames, STAGE_TIMING_RING) 帧求各列 p50 / p99 / max，out 需 STAGE_TIMING_COLUMNS 项；返回帧数
+int stage_timing_summary(const stage_timing* t, stage_timing_stat* out);
+
+// 写动态日志：每帧各列原始值；每满一个窗口（frames 为 STAGE_TIMING_RING 的倍数）再写 p50 / p99 / max
+void stage_timing_log(const stage_timing* t, int frame_index);
+
+// 汇总写成 CSV（stage,unit,count,p50,p99,max），无法写入返回 -1
+int stage_timing_write_csv(const stage_timing* t, const char* path);
+
+#ifdef IMAGEPROC_STAGE_TIMING
+  #define STAGE_TIMING_BEGIN(t)        stage_timing_begin(t)
+  #define STAGE_TIMING_MARK(t, stage)  stage_timing_mark((t), (stage))
+  #define STAGE_TIMING_TRACE_STEP(t)   ((t)->cur[STAGE_TIMING_TRACE_ITERS]++)
+  #define STAGE_TIMING_END(t)          stage_timing_end(t)
+#else
+  #define STAGE_TIMING_BEGIN(t)        ((void)0)
+  #define STAGE_TIMING_MARK(t, stage)  ((void)0)
+  #define STAGE_TIMING_TRACE_STEP(t)   ((void)0)
+  #define STAGE_TIMING_END(t)          ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STAGE_TIMING_H
@@ -1,18 +1,57 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
+#include <iomanip>
+#include <fstream>
 #include <filesystem>
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 #include "processor.h"
 #include "global_image_buffer.h"
+#include "morph_binary_bitpacked.h"
+#include "area_downscale.h"
+#include "pipeline_context.h"
+#include "frame_archive.h"
 
 namespace fs = std::filesystem;
 
 // 小契约：
-// 输入：mp4 文件路径，输出目录，可选是否仅导出 PNG 或同时调用原有处理逻辑
-// 输出：将每一帧写出为 PNG（frame_000001.png 等）；另外按 188x120 的尺寸二值化到 original 并调用 process_original_to_imo 生成 imo，可选落盘
+// 输入：mp4 文件路径，输出目录，可选是否调用原有处理逻辑
+// 输出：由全分辨率帧一步区域平均+阈值化（128）得到 188x120 位图，调用 process_packed_to_imo 生成 imo；
+//       --export-imo 时把 imo 可视化（二值底图 + 标注）按帧序编码成一个视频（默认 <output_dir>/imo.avi）。
+//       逐帧 PNG 需显式 --png：frame_000001.png 等原始帧，--export-imo 时另有 imo_000001.png
 // 异常：当视频无法打开、写盘失败、OpenCV 不存在时退出非 0
+// --video <path>：标注视频路径（隐含 --export-imo）；--codec mjpg|ffv1 选编码（ffv1 无损，默认 mjpg），
+//   --side-by-side 时左边原始帧、右边按原始帧高度最近邻放大的 imo 可视化
+// --check-morph：对每帧的 188x120 二值图同时运行四遍 open_close_bitpacked 与单遍 open_close_bitpacked_fused，
+//   逐位比较，存在不一致帧时退出码为 7（用于在 data/ 下的全部录像上做差分校验）
+// --temporal：开启追踪的时域复用（起点行段没变则沿用起点，八邻域沿用邻域没变的前缀步、从第一个变化的步接着追踪），
+//   结果与完整搜索逐点一致；结束时打印沿用的帧数与步数占比，默认关闭
+// --timing-csv <path>：以 -DIMAGEPROC_STAGE_TIMING=ON 构建时，结束后把最近窗口的分阶段 p50/p99/max 写成 CSV
+// --archive <out.ipf>：把每帧 188x120 位图按帧序写成 .ipf 归档（见 frame_archive.h），回放时 mmap 直接取帧，
+//   不再解码视频；加 --archive-gray 则存 8 位灰度（回放时再阈值化，可换阈值）；
+//   加 --archive-delta N 则位图按与上一帧的 XOR 游程编码存放，每 N 帧一个关键帧
+// --bench：无界面、不写任何文件，在当前线程上逐帧 解码 → 缩放/二值化 → process_packed_to_imo，
+//   分别报告三段的 p50/p90/p99/max 与延迟直方图，以及持续帧率（此时 output_dir 可省略）；
+//   加 --predecode 则先把整段视频解码并二值化到内存（每帧 2880 字节），再单独测流水线的纯吞吐
+//
+// 流水线结构（--threads N）：
+//   解码线程 → 有界队列 → N 个工作线程（缩放/二值化/处理/可视化/PNG 编码）→ 按帧序写盘线程 → 视频编码线程
+// - process_packed_to_imo 在默认上下文上按帧序串行执行（跨帧状态与串行路径一致），
+//   耗时的 PNG 编码与视频帧拼接在工作线程中并行完成；写盘线程只负责按序落盘，输出与串行路径逐字节一致。
+// - cv::VideoWriter 只能顺序写，独占一个编码线程，写盘线程按帧序把拼好的帧交给它。
+// - 解码队列与待写盘窗口都有上限，任何一级变慢都会反压到上游，内存占用有界。
+
+static const int TARGET_W = 188;
+static const int TARGET_H = 120;
 
 static void ensure_dir(const fs::path &p) {
     std::error_code ec;
@@ -24,55 +63,547 @@ static void ensure_dir(const fs::path &p) {
     }
 }
 
-static void resize_and_binarize(const cv::Mat &src, std::vector<std::vector<uint8_t>> &original,
+// 二值化阈值：灰度 > BINARY_THRESHOLD 为白
+static const uint8_t BINARY_THRESHOLD = 128;
+
+static area_src_format frame_format(const cv::Mat &src) {
+    switch (src.channels()) {
+    case 1: return AREA_SRC_GRAY;
+    case 3: return AREA_SRC_BGR;
+    case 4: return AREA_SRC_BGRA;
+    default: throw std::runtime_error("不支持的帧通道数: " + std::to_string(src.channels()));
+    }
+}
+
+// 缩放并二值化：直接从全分辨率 BGR/灰度帧区域平均到 target_w×target_h 并阈值打包，
+// 不做全分辨率的颜色转换；帧间已经由工作线程并行，这里单线程处理整帧
+static void resize_and_binarize(const cv::Mat &src, std::vector<uint32_t> &packed,
                                 int target_w, int target_h) {
-    cv::Mat gray = (src.channels() == 1) ? src : cv::Mat();
-    if (gray.empty()) {
-        cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+    const area_src_format fmt = frame_format(src);
+    packed.resize((size_t)total_words(target_w, target_h));
+    if (src.depth() != CV_8U ||
+        area_downscale_threshold_rows(src.data, src.cols, src.rows, (int)src.step, fmt, BINARY_THRESHOLD,
+                                      packed.data(), target_w, target_h, 0, target_h) != 0) {
+        throw std::runtime_error("帧缩放失败");
     }
-    cv::Mat resized;
-    cv::resize(gray, resized, cv::Size(target_w, target_h), 0, 0, cv::INTER_LINEAR);
+}
 
-    original.assign(target_h, std::vector<uint8_t>(target_w, 255));
-    for (int y = 0; y < target_h; ++y) {
-        const uint8_t *row = resized.ptr<uint8_t>(y);
-        for (int x = 0; x < target_w; ++x) {
-            original[y][x] = (row[x] > 128 ? 255 : 0);
+// 缩小到 target_w×target_h 灰度（--archive-gray），行跨度 = target_w
+static void resize_to_gray(const cv::Mat &src, std::vector<uint8_t> &gray, int target_w, int target_h) {
+    const area_src_format fmt = frame_format(src);
+    gray.resize((size_t)target_w * target_h);
+    if (src.depth() != CV_8U ||
+        area_downscale_gray_rows(src.data, src.cols, src.rows, (int)src.step, fmt,
+                                 gray.data(), target_w, target_h, target_w, 0, target_h) != 0) {
+        throw std::runtime_error("帧缩放失败");
+    }
+}
+
+// 将 imo（0/255 二值图）与标注显示列表可视化为彩色图
+// （二值底图 0=黑、其余=白；标注 1=红，2=橙，3=黄，4=绿，5=青，其余=白）
+static void render_imo_bgr(const uint8_t *imo_buf, const overlay_list &overlay, cv::Mat &viz) {
+    // 颜色映射表
+    static const cv::Vec3b colorMap[] = {
+        {0,0,0}, {0,0,255}, {0,165,255}, {0,255,255},
+        {0,255,0}, {255,255,0}, {255,255,255}  // 索引0-5+默认
+    };
+    viz.create(TARGET_H, TARGET_W, CV_8UC3);
+    for (int y = 0; y < TARGET_H; ++y) {
+        cv::Vec3b *row = viz.ptr<cv::Vec3b>(y);
+        const uint8_t *src = imo_buf + (size_t)y * TARGET_W;
+        for (int x = 0; x < TARGET_W; ++x) {
+            row[x] = src[x] ? colorMap[6] : colorMap[0];
         }
     }
+    // 只画标注像素（约 1k 个），不再对整幅图逐像素查表
+    overlay_pixel px[OVERLAY_MAX_PIXELS];
+    int n = overlay_rasterize(&overlay, px, OVERLAY_MAX_PIXELS);
+    for (int i = 0; i < n; ++i) {
+        uint8_t v = px[i].color;
+        viz.at<cv::Vec3b>(px[i].y, px[i].x) = (v <= 5) ? colorMap[v] : colorMap[6];  // 6、7 →白色
+    }
+}
+
+// --video 的一帧：imo 可视化；side_by_side 时左边原始帧、右边按原始帧高度最近邻放大的可视化
+static void compose_video_frame(const cv::Mat &src, const cv::Mat &viz, bool side_by_side, cv::Mat &out) {
+    if (!side_by_side) {
+        out = viz.clone(); // viz 是工作线程复用的缓冲区
+        return;
+    }
+    cv::Mat left, right;
+    if (src.channels() == 1) {
+        cv::cvtColor(src, left, cv::COLOR_GRAY2BGR);
+    } else if (src.channels() == 4) {
+        cv::cvtColor(src, left, cv::COLOR_BGRA2BGR);
+    } else {
+        left = src;
+    }
+    const int w = std::max(1, (TARGET_W * src.rows + TARGET_H / 2) / TARGET_H);
+    cv::resize(viz, right, cv::Size(w, src.rows), 0, 0, cv::INTER_NEAREST);
+    cv::hconcat(left, right, out);
 }
 
-static void save_png(const fs::path &outPath, const cv::Mat &img) {
+static void encode_png(const cv::Mat &img, std::vector<uchar> &out, const std::string &what) {
     std::vector<int> params = {cv::IMWRITE_PNG_COMPRESSION, 3};
-    if (!cv::imwrite(outPath.string(), img, params)) {
+    if (!cv::imencode(".png", img, out, params)) {
+        throw std::runtime_error("编码 PNG 失败: " + what);
+    }
+}
+
+static void write_file(const fs::path &outPath, const std::vector<uchar> &bytes) {
+    std::ofstream ofs(outPath, std::ios::binary | std::ios::trunc);
+    if (!ofs || !ofs.write(reinterpret_cast<const char *>(bytes.data()), (std::streamsize)bytes.size())) {
         throw std::runtime_error("写入 PNG 失败: " + outPath.string());
     }
 }
 
+// 形态学差分校验：四遍 open_close_bitpacked 与单遍 open_close_bitpacked_fused 逐位比较，一致返回 true
+static bool check_morph_frame(const std::vector<uint32_t> &packed) {
+    const int n = total_words(TARGET_W, TARGET_H);
+    std::vector<uint32_t> tmp(n), ref(n), fused(n);
+    open_close_bitpacked(packed.data(), tmp.data(), ref.data(), TARGET_W, TARGET_H);
+    open_close_bitpacked_fused(packed.data(), tmp.data(), fused.data(), TARGET_W, TARGET_H);
+    return ref == fused;
+}
+
+// ---------------- 流水线基础设施 ----------------
+
+// 有界阻塞队列：push 在队列满时阻塞（反压），close 后 push 返回 false，pop 在取空后返回 false
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : cap(capacity ? capacity : 1) {}
+
+    bool push(T &&item) {
+        std::unique_lock<std::mutex> lock(m);
+        not_full.wait(lock, [&] { return closed || q.size() < cap; });
+        if (closed) return false;
+        q.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(m);
+        not_empty.wait(lock, [&] { return closed || !q.empty(); });
+        if (q.empty()) return false;
+        item = std::move(q.front());
+        q.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(m);
+        closed = true;
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+private:
+    size_t cap;
+    std::deque<T> q;
+    bool closed = false;
+    std::mutex m;
+    std::condition_variable not_full, not_empty;
+};
+
+// 按帧序放行：wait(idx) 阻塞直到轮到 idx，advance() 放行下一帧
+class OrderedTurnstile {
+public:
+    explicit OrderedTurnstile(int first) : next(first) {}
+
+    bool wait(int idx) {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&] { return aborted || next == idx; });
+        return !aborted;
+    }
+
+    void advance() {
+        std::lock_guard<std::mutex> lock(m);
+        ++next;
+        cv.notify_all();
+    }
+
+    void abort() {
+        std::lock_guard<std::mutex> lock(m);
+        aborted = true;
+        cv.notify_all();
+    }
+
+private:
+    int next;
+    bool aborted = false;
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+struct FrameJob {
+    int idx = 0;
+    cv::Mat frame;
+};
+
+struct FrameResult {
+    int idx = 0;
+    std::vector<uchar> frame_png;
+    std::vector<uchar> imo_png;
+    cv::Mat video_frame;          // --video：拼好的一帧（imo 可视化，或与原始帧并排）
+    std::vector<uint8_t> archive; // --archive：该帧的归档数据（位图或灰度）
+};
+
+// 按帧序重排的写盘窗口：工作线程乱序提交，写盘线程按 idx 递增取出
+// 只有 idx < next + window 的结果可以进入窗口，next 本身永远可以进入，因此不会死锁
+class OrderedSink {
+public:
+    OrderedSink(int first, int window) : next(first), win(window > 0 ? window : 1) {}
+
+    bool push(FrameResult &&r) {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&] { return aborted || r.idx < next + win; });
+        if (aborted) return false;
+        pending.emplace(r.idx, std::move(r));
+        cv.notify_all();
+        return true;
+    }
+
+    // 取出下一帧；全部写完（或中止）时返回 false
+    bool pop_next(FrameResult &r) {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&] {
+            return aborted || pending.count(next) || (total >= 0 && next > total);
+        });
+        if (aborted || !pending.count(next)) return false;
+        auto it = pending.find(next);
+        r = std::move(it->second);
+        pending.erase(it);
+        ++next;
+        cv.notify_all();
+        return true;
+    }
+
+    // 解码结束后告知最后一帧的序号
+    void finish(int last_idx) {
+        std::lock_guard<std::mutex> lock(m);
+        total = last_idx;
+        cv.notify_all();
+    }
+
+    void abort() {
+        std::lock_guard<std::mutex> lock(m);
+        aborted = true;
+        cv.notify_all();
+    }
+
+private:
+    int next;
+    int win;
+    int total = -1;
+    bool aborted = false;
+    std::map<int, FrameResult> pending;
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+struct Options {
+    fs::path input;
+    fs::path outDir;
+    bool exportImo = false;
+    bool checkMorph = false;
+    bool temporal = false;
+    fs::path timingCsv;
+    fs::path archive;
+    bool archiveGray = false;
+    int archiveDelta = 0;
+    bool bench = false;
+    bool predecode = false;
+    bool png = false;
+    fs::path video;
+    std::string codec = "mjpg";
+    bool sideBySide = false;
+    int threads = 0;
+};
+
+static void print_usage() {
+    std::cerr << "用法: video_processor <input.mp4> <output_dir> [--export-imo] [--threads N] [--check-morph] [--temporal] [--timing-csv <path>] [--archive <out.ipf> [--archive-gray | --archive-delta N]]" << std::endl;
+    std::cerr << "                       [--png] [--video <path>] [--codec mjpg|ffv1] [--side-by-side]" << std::endl;
+    std::cerr << "      video_processor <input.mp4> --bench [--predecode] [--temporal] [--timing-csv <path>]" << std::endl;
+    std::cerr << "  input.mp4    - 输入视频文件路径" << std::endl;
+    std::cerr << "  output_dir   - 输出目录路径" << std::endl;
+    std::cerr << "  --export-imo - (可选) 处理并导出 imo 可视化（默认编码为 <output_dir>/imo.avi）" << std::endl;
+    std::cerr << "  --png        - (可选) 逐帧导出 PNG（原始帧；--export-imo 时另有 imo 图）" << std::endl;
+    std::cerr << "  --video      - (可选) imo 可视化视频路径（隐含 --export-imo）" << std::endl;
+    std::cerr << "  --codec      - (可选) 视频编码：mjpg（默认）或 ffv1（无损）" << std::endl;
+    std::cerr << "  --side-by-side - (可选) 视频中原始帧与 imo 可视化左右并排（隐含 --export-imo）" << std::endl;
+    std::cerr << "  --threads N  - (可选) 工作线程数，默认等于 CPU 核数；1 为串行处理" << std::endl;
+    std::cerr << "  --check-morph - (可选) 逐帧校验单遍形态学与四遍版本结果一致" << std::endl;
+    std::cerr << "  --temporal   - (可选) 开启追踪时域复用（沿用上一帧邻域没变的八邻域前缀步）" << std::endl;
+    std::cerr << "  --timing-csv - (可选) 导出分阶段耗时 p50/p99/max（需 --export-imo 或 --bench，且以 -DIMAGEPROC_STAGE_TIMING=ON 构建）" << std::endl;
+    std::cerr << "  --bench      - (可选) 基准模式：不写任何文件，报告解码 / 预处理 / 流水线延迟分布与持续帧率" << std::endl;
+    std::cerr << "  --predecode  - (可选) 基准模式下先整段解码并二值化到内存，再单独测流水线吞吐" << std::endl;
+    std::cerr << "  --archive    - (可选) 把 188x120 位图按帧序写入 .ipf 归档，供 replay_check 等 mmap 回放" << std::endl;
+    std::cerr << "  --archive-gray - (可选) 归档存 8 位灰度而不是位图" << std::endl;
+    std::cerr << "  --archive-delta N - (可选) 位图归档做时域增量压缩，每 N 帧一个关键帧（如 30）" << std::endl;
+}
+
+static bool parse_args(int argc, char **argv, Options &opt) {
+    if (argc < 2) return false;
+    opt.input = argv[1];
+    int i = 2;
+    if (i < argc && std::string(argv[i]).rfind("--", 0) != 0) opt.outDir = argv[i++];
+    for (; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--export-imo") {
+            opt.exportImo = true;
+        } else if (a == "--check-morph") {
+            opt.checkMorph = true;
+        } else if (a == "--temporal") {
+            opt.temporal = true;
+        } else if (a == "--timing-csv" && i + 1 < argc) {
+            opt.timingCsv = argv[++i];
+        } else if (a == "--png") {
+            opt.png = true;
+        } else if (a == "--video" && i + 1 < argc) {
+            opt.video = argv[++i];
+        } else if (a == "--codec" && i + 1 < argc) {
+            opt.codec = argv[++i];
+            if (opt.codec != "mjpg" && opt.codec != "ffv1") return false;
+        } else if (a == "--side-by-side") {
+            opt.sideBySide = true;
+        } else if (a == "--bench") {
+            opt.bench = true;
+        } else if (a == "--predecode") {
+            opt.predecode = true;
+        } else if (a == "--archive" && i + 1 < argc) {
+            opt.archive = argv[++i];
+        } else if (a == "--archive-gray") {
+            opt.archiveGray = true;
+        } else if (a == "--archive-delta" && i + 1 < argc) {
+            try {
+                opt.archiveDelta = std::stoi(argv[++i]);
+            } catch (...) {
+                return false;
+            }
+            if (opt.archiveDelta <= 0) return false;
+        } else if (a == "--threads" && i + 1 < argc) {
+            try {
+                opt.threads = std::stoi(argv[++i]);
+            } catch (...) {
+                return false;
+            }
+            if (opt.threads <= 0) return false;
+        } else {
+            std::cerr << "未知参数: " << a << std::endl;
+            return false;
+        }
+    }
+    // 基准模式不写任何文件；其余模式必须给出输出目录
+    if (opt.bench) {
+        if (opt.exportImo || opt.checkMorph || !opt.archive.empty() || opt.png || !opt.video.empty() || opt.sideBySide)
+            return false;
+    } else if (opt.outDir.empty() || opt.predecode) {
+        return false;
+    }
+    if (!opt.video.empty() || opt.sideBySide) opt.exportImo = true;
+    // --export-imo 未指定去向时编码成视频；PNG 只在 --png 时导出
+    if (opt.exportImo && opt.video.empty() && (!opt.png || opt.sideBySide)) opt.video = opt.outDir / "imo.avi";
+    if (!opt.bench && !opt.png && !opt.exportImo && !opt.checkMorph && opt.archive.empty()) {
+        std::cerr << "未指定任何输出（--png / --export-imo / --video / --archive / --check-morph）" << std::endl;
+        return false;
+    }
+    if ((opt.archiveGray || opt.archiveDelta) && opt.archive.empty()) return false;
+    if (opt.archiveGray && opt.archiveDelta) return false; // 增量压缩只用于位图
+    if (opt.threads <= 0) {
+        unsigned hc = std::thread::hardware_concurrency();
+        opt.threads = hc ? (int)hc : 1;
+    }
+    return true;
+}
+
+// ---------------- 基准模式 ----------------
+
+// 一段的逐帧延迟（纳秒）
+struct LatencySeries {
+    const char *name;
+    std::vector<uint64_t> ns;
+};
+
+// 最近秩百分位（与 stage_timing 相同）：第 ceil(q·n/100) 小的值
+static uint64_t rank_pct(const std::vector<uint64_t> &sorted, int q) {
+    size_t k = (sorted.size() * (size_t)q + 99) / 100;
+    return sorted[(k > 0 ? k : 1) - 1];
+}
+
+// 直方图桶：0 = [0,1) µs，k ≥ 1 = [2^(k-1), 2^k) µs
+static int latency_bucket(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int b = 0;
+    while (us) {
+        us >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+static void print_latency_report(std::vector<LatencySeries> &series) {
+    const int BUCKETS = 40;
+    std::vector<std::vector<size_t>> hist(series.size(), std::vector<size_t>(BUCKETS, 0));
+    int lo = BUCKETS, hi = -1;
+    std::printf("阶段                帧数        p50        p90        p99        max       均值  (µs)\n");
+    for (size_t s = 0; s < series.size(); ++s) {
+        std::vector<uint64_t> v = series[s].ns;
+        if (v.empty()) continue;
+        std::sort(v.begin(), v.end());
+        uint64_t sum = 0;
+        for (uint64_t x : v) {
+            sum += x;
+            int b = std::min(latency_bucket(x), BUCKETS - 1);
+            hist[s][b]++;
+            lo = std::min(lo, b);
+            hi = std::max(hi, b);
+        }
+        std::printf("%-12s %10zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", series[s].name, v.size(),
+                    rank_pct(v, 50) / 1e3, rank_pct(v, 90) / 1e3, rank_pct(v, 99) / 1e3, v.back() / 1e3,
+                    (double)sum / v.size() / 1e3);
+    }
+    std::printf("\n延迟直方图（帧数）\n区间 (µs)         "); // 中文按两列宽手工对齐
+    for (const LatencySeries &l : series) std::printf(" %12s", l.name);
+    std::printf("\n");
+    for (int b = lo; b <= hi; ++b) {
+        const unsigned long long b0 = b ? (1ull << (b - 1)) : 0, b1 = 1ull << b;
+        std::printf("[%6llu, %6llu)  ", b0, b1);
+        for (size_t s = 0; s < series.size(); ++s) std::printf(" %12zu", hist[s][b]);
+        std::printf("\n");
+    }
+}
+
+// 无界面基准：解码 → 缩放/二值化 → process_packed_to_imo，在当前线程上串行逐帧计时，不写任何文件。
+// predecode 时先只做前两段并把位图（每帧 2880 字节，而不是全分辨率帧）存进内存，再单独跑流水线，
+// 得到不受解码影响的纯吞吐
+static int run_benchmark(cv::VideoCapture &cap, bool predecode) {
+    using clock = std::chrono::steady_clock;
+    auto ns_between = [](clock::time_point a, clock::time_point b) {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count();
+    };
+    auto seconds_since = [](clock::time_point a) {
+        return std::chrono::duration<double>(clock::now() - a).count();
+    };
+    const size_t words = (size_t)total_words(TARGET_W, TARGET_H);
+    LatencySeries decode{"decode", {}}, preprocess{"preprocess", {}}, pipeline{"pipeline", {}};
+    std::vector<uint32_t> packed;
+    std::vector<uint32_t> stored; // --predecode：全部帧的位图
+    std::vector<uint8_t> imo_buf((size_t)TARGET_W * TARGET_H);
+    cv::Mat frame;
+
+    std::cout << (predecode ? "预解码..." : "开始基准...") << std::endl;
+    const auto wall0 = clock::now();
+    while (true) {
+        const auto t0 = clock::now();
+        if (!cap.read(frame)) break;
+        const auto t1 = clock::now();
+        try {
+            resize_and_binarize(frame, packed, TARGET_W, TARGET_H);
+        } catch (const std::exception &e) {
+            std::cerr << "错误: " << e.what() << std::endl;
+            return 6;
+        }
+        const auto t2 = clock::now();
+        decode.ns.push_back(ns_between(t0, t1));
+        preprocess.ns.push_back(ns_between(t1, t2));
+        if (predecode) {
+            stored.insert(stored.end(), packed.begin(), packed.end());
+            continue;
+        }
+        process_packed_to_imo(packed.data(), imo_buf.data(), TARGET_W, TARGET_H);
+        pipeline.ns.push_back(ns_between(t2, clock::now()));
+    }
+    const double wall = seconds_since(wall0);
+    const size_t frames = decode.ns.size();
+    if (frames == 0) {
+        std::cerr << "错误: 没有解码出任何帧" << std::endl;
+        return 4;
+    }
+
+    double pipeline_wall = 0;
+    if (predecode) {
+        std::cout << "预解码完成: " << frames << " 帧，" << stored.size() * sizeof(uint32_t) / 1024 << " KiB，开始流水线基准..."
+                  << std::endl;
+        const auto p0 = clock::now();
+        for (size_t f = 0; f < frames; ++f) {
+            const auto t0 = clock::now();
+            process_packed_to_imo(stored.data() + f * words, imo_buf.data(), TARGET_W, TARGET_H);
+            pipeline.ns.push_back(ns_between(t0, clock::now()));
+        }
+        pipeline_wall = seconds_since(p0);
+    }
+
+    std::cout << std::endl;
+    std::vector<LatencySeries> series = {decode, preprocess, pipeline};
+    print_latency_report(series);
+    std::cout << std::endl;
+    if (predecode) {
+        std::cout << "解码 + 预处理: " << frames << " 帧，" << wall << " 秒，" << frames / wall << " 帧/秒" << std::endl;
+        std::cout << "流水线纯吞吐: " << frames << " 帧，" << pipeline_wall << " 秒，" << frames / pipeline_wall << " 帧/秒"
+                  << std::endl;
+    } else {
+        std::cout << "持续帧率（解码 + 预处理 + 流水线）: " << frames << " 帧，" << wall << " 秒，" << frames / wall
+                  << " 帧/秒" << std::endl;
+    }
+    return 0;
+}
+
+// --timing-csv：把最近窗口的分阶段耗时写成 CSV；失败返回 false
+// 时域复用统计：整帧沿用 / 部分沿用 / 从头追踪的帧数，以及沿用步数占八邻域总步数的比例
+static void print_temporal_stats(const PipelineContext *ctx) {
+    const uint64_t steps = (uint64_t)ctx->temporal_steps_reused + ctx->temporal_steps_traced;
+    std::cout << "时域复用: 整帧沿用 " << ctx->temporal_hits << " 帧，部分沿用 " << ctx->temporal_partial << " 帧，从头追踪 "
+              << ctx->temporal_misses << " 帧；沿用步数 " << std::fixed << std::setprecision(1)
+              << (steps ? 100.0 * ctx->temporal_steps_reused / steps : 0.0) << "%" << std::endl;
+}
+
+static bool write_stage_timing(const Options &opt, const PipelineContext *ctx) {
+#ifdef IMAGEPROC_STAGE_TIMING
+    if (opt.timingCsv.empty()) return true;
+    if (stage_timing_write_csv(&ctx->timing, opt.timingCsv.string().c_str()) != 0) {
+        std::cerr << "错误: 无法写入: " << opt.timingCsv << std::endl;
+        return false;
+    }
+    std::cout << "分阶段计时: 最近 " << std::min<uint32_t>(ctx->timing.frames, STAGE_TIMING_RING) << " 帧 -> "
+              << opt.timingCsv << std::endl;
+#else
+    (void)opt;
+    (void)ctx;
+#endif
+    return true;
+}
+
 int main(int argc, char **argv) {
-    if (argc < 3) {
-        std::cerr << "用法: video_processor <input.mp4> <output_dir> [--export-imo]" << std::endl;
-        std::cerr << "  input.mp4   - 输入视频文件路径" << std::endl;
-        std::cerr << "  output_dir  - 输出目录路径" << std::endl;
-        std::cerr << "  --export-imo - (可选) 同时导出处理后的imo图像" << std::endl;
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage();
         return 2;
     }
-    
-    const fs::path input = argv[1];
-    const fs::path outDir = argv[2];
-    const bool exportImo = (argc >= 4 && std::string(argv[3]) == "--export-imo");
-    
+
+    const fs::path &input = opt.input;
+    const fs::path &outDir = opt.outDir;
+    const bool exportImo = opt.exportImo;
+    const bool checkMorph = opt.checkMorph;
+    const bool archive = !opt.archive.empty();
+    const bool png = opt.png;
+    const bool video = !opt.video.empty();
+
     // 验证输入文件
     if (!fs::exists(input)) {
         std::cerr << "错误: 输入文件不存在: " << input << std::endl;
         return 1;
     }
 
-    try {
-        ensure_dir(outDir);
-    } catch (const std::exception &e) {
-        std::cerr << "错误: " << e.what() << std::endl;
-        return 3;
+    if (!opt.bench) {
+        try {
+            ensure_dir(outDir);
+        } catch (const std::exception &e) {
+            std::cerr << "错误: " << e.what() << std::endl;
+            return 3;
+        }
     }
 
     cv::VideoCapture cap(input.string());
@@ -80,103 +611,306 @@ int main(int argc, char **argv) {
         std::cerr << "错误: 无法打开视频: " << input << std::endl;
         return 4;
     }
-    
+
     // 获取视频信息
     int total_frames = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_COUNT));
     double fps = cap.get(cv::CAP_PROP_FPS);
     int width = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
     int height = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT));
-    
+
     std::cout << "视频信息:" << std::endl;
     std::cout << "  分辨率: " << width << "x" << height << std::endl;
     std::cout << "  帧率: " << fps << " fps" << std::endl;
     std::cout << "  总帧数: " << total_frames << std::endl;
-    std::cout << "  输出目录: " << outDir << std::endl;
-    if (exportImo) {
-        std::cout << "  处理模式: 导出原始帧 + imo处理结果" << std::endl;
+    if (opt.bench) {
+        std::cout << "  处理模式: 基准（不写文件" << (opt.predecode ? "，预解码" : "") << "）" << std::endl;
     } else {
-        std::cout << "  处理模式: 仅导出原始帧" << std::endl;
+        std::cout << "  输出目录: " << outDir << std::endl;
+        if (exportImo) {
+            std::cout << "  处理模式: 处理并导出 imo" << std::endl;
+        } else {
+            std::cout << "  处理模式: 不运行流水线" << std::endl;
+        }
+        if (png) {
+            std::cout << "  PNG 导出: 原始帧" << (exportImo ? " + imo" : "") << std::endl;
+        }
+        if (video) {
+            std::cout << "  标注视频: " << opt.video << "（" << (opt.codec == "ffv1" ? "FFV1 无损" : "MJPG")
+                      << (opt.sideBySide ? "，与原始帧并排" : "") << "）" << std::endl;
+        }
+        std::cout << "  工作线程: " << opt.threads << std::endl;
+    }
+    if (checkMorph) {
+        std::cout << "  形态学校验: 开启" << std::endl;
+    }
+    PipelineContext *ctx = pipeline_default_context();
+    ctx->temporal_enabled = opt.temporal ? 1 : 0;
+    if (opt.temporal) {
+        std::cout << "  时域复用: 开启" << std::endl;
+    }
+    if (!opt.timingCsv.empty()) {
+#ifdef IMAGEPROC_STAGE_TIMING
+        stage_timing_reset(&ctx->timing);
+        std::cout << "  分阶段计时: " << opt.timingCsv << std::endl;
+#else
+        std::cerr << "警告: 未以 IMAGEPROC_STAGE_TIMING 构建，忽略 --timing-csv" << std::endl;
+#endif
+    }
+    ipf_writer arc;
+    if (archive) {
+        const ipf_format fmt = opt.archiveGray ? IPF_FORMAT_GRAY8 : IPF_FORMAT_PACKED;
+        if (ipf_writer_open(&arc, opt.archive.string().c_str(), fmt, TARGET_W, TARGET_H) != 0) {
+            std::cerr << "错误: 无法创建归档: " << opt.archive << std::endl;
+            return 8;
+        }
+        if (opt.archiveDelta && ipf_writer_set_delta(&arc, (uint32_t)opt.archiveDelta) != 0) {
+            ipf_writer_close(&arc);
+            std::cerr << "错误: 无法开启归档增量压缩" << std::endl;
+            return 8;
+        }
+        std::cout << "  帧归档: " << opt.archive << (opt.archiveGray ? "（灰度）" : "（位图）");
+        if (opt.archiveDelta) std::cout << "，增量压缩，每 " << opt.archiveDelta << " 帧一个关键帧";
+        std::cout << std::endl;
     }
     std::cout << std::endl;
 
-    const int TARGET_W = 188;
-    const int TARGET_H = 120;
+    if (opt.bench) {
+        int rc = run_benchmark(cap, opt.predecode);
+        if (rc == 0 && !write_stage_timing(opt, ctx)) rc = 6;
+        if (rc == 0 && opt.temporal) {
+            print_temporal_stats(ctx);
+        }
+        return rc;
+    }
 
-    cv::Mat frame;
-    int idx = 0;
     int progress_interval = std::max(1, total_frames / 20); // 每5%显示一次进度
-    
+
     std::cout << "开始处理..." << std::endl;
-    
-    while (true) {
-        if (!cap.read(frame)) break;
-        ++idx;
-        
-        // 显示进度
-        if (idx % progress_interval == 0 || idx == total_frames) {
-            int progress = (idx * 100) / std::max(1, total_frames);
-            std::cout << "\r进度: " << progress << "% (" << idx << "/" << total_frames << ")" << std::flush;
-        }
-
-        // 导出原始帧 PNG（按原分辨率）
-        char namebuf[64];
-        std::snprintf(namebuf, sizeof(namebuf), "frame_%06d.png", idx);
-        fs::path outPng = outDir / namebuf;
-        try {
-            save_png(outPng, frame);
-        } catch (const std::exception &e) {
-            std::cerr << "\n错误: " << e.what() << std::endl;
-            return 5;
+
+    const int workers = opt.threads;
+    BoundedQueue<FrameJob> jobs((size_t)workers * 2);
+    OrderedTurnstile turnstile(1);
+    OrderedSink sink(1, workers * 4);
+    BoundedQueue<cv::Mat> video_frames(8);
+
+    // 第一个错误决定退出码（5=原始帧写入失败，6=imo 生成/写入失败，8=归档写入失败，9=视频写入失败）
+    std::mutex err_mutex;
+    int exit_code = 0;
+    std::string err_msg;
+    auto fail = [&](int code, const std::string &msg) {
+        {
+            std::lock_guard<std::mutex> lock(err_mutex);
+            if (exit_code == 0) {
+                exit_code = code;
+                err_msg = msg;
+            }
         }
+        jobs.close();
+        turnstile.abort();
+        sink.abort();
+        video_frames.close();
+    };
 
-        // 转换成 188x120 二值 original，并调用现有 C 处理逻辑，选择性落盘
-        if (exportImo) {
-            std::vector<std::vector<uint8_t>> original;
-            resize_and_binarize(frame, original, TARGET_W, TARGET_H);
-            
-            // 拷贝到全局 original_bi_image
-            for (int y = 0; y < TARGET_H; ++y) {
-                memcpy(original_bi_image[y], original[y].data(), TARGET_W);
+    std::atomic<int> morph_checked{0};
+    std::atomic<int> morph_mismatch{0};
+
+    // 工作线程：缩放/二值化 → 按帧序调用 process_packed_to_imo → 并行可视化与 PNG 编码
+    auto worker = [&]() {
+        FrameJob job;
+        std::vector<uint32_t> packed;
+        std::vector<uint8_t> gray;
+        std::vector<uint8_t> imo_buf((size_t)TARGET_W * TARGET_H);
+        overlay_list overlay;
+        cv::Mat viz;
+        while (jobs.pop(job)) {
+            FrameResult res;
+            res.idx = job.idx;
+
+            // 转换成 188x120 位图，直接交给 C 处理逻辑（不再生成中间的灰度图与 0/255 二值图）
+            if (opt.archiveGray) {
+                // 灰度归档：先缩小到灰度，位图由灰度阈值打包得到（与一步阈值化逐位相同）
+                try {
+                    resize_to_gray(job.frame, gray, TARGET_W, TARGET_H);
+                } catch (const std::exception &e) {
+                    fail(8, e.what());
+                    return;
+                }
+                res.archive = gray;
+                if (exportImo || checkMorph) {
+                    packed.resize((size_t)total_words(TARGET_W, TARGET_H));
+                    pack_gray_threshold_to_bits(gray.data(), TARGET_W, TARGET_H, TARGET_W, BINARY_THRESHOLD,
+                                                packed.data());
+                }
+            } else if (exportImo || checkMorph || archive) {
+                try {
+                    resize_and_binarize(job.frame, packed, TARGET_W, TARGET_H);
+                } catch (const std::exception &e) {
+                    fail(6, e.what());
+                    return;
+                }
+                if (archive) {
+                    const uint8_t *p = reinterpret_cast<const uint8_t *>(packed.data());
+                    res.archive.assign(p, p + packed.size() * sizeof(uint32_t));
+                }
             }
-            
-            // 清空全局 imo
-            for (int y = 0; y < TARGET_H; ++y) {
-                for (int x = 0; x < TARGET_W; ++x) {
-                    imo[y][x] = 255;
+            if (checkMorph) {
+                morph_checked++;
+                if (!check_morph_frame(packed)) {
+                    morph_mismatch++;
+                    std::cerr << "\n形态学不一致: 帧 " << job.idx << std::endl;
                 }
             }
-            
-            process_original_to_imo(&original_bi_image[0][0], &imo[0][0], TARGET_W, TARGET_H);
-            process_original_to_imo(&original_bi_image[0][0], &imo[0][0], TARGET_W, TARGET_H);
-            
-            // 将 imo 可视化落盘为彩色 PNG（0=黑，1=红，2=橙，3=黄，4=绿，5=青，255=白）
-            cv::Mat viz(TARGET_H, TARGET_W, CV_8UC3);
-            // 颜色映射表
-            static const cv::Vec3b colorMap[] = {
-                {0,0,0}, {0,0,255}, {0,165,255}, {0,255,255}, 
-                {0,255,0}, {255,255,0}, {255,255,255}  // 索引0-5+默认
-            };
-            
-            for (int y = 0; y < TARGET_H; ++y) {
-                cv::Vec3b *row = viz.ptr<cv::Vec3b>(y);
-                for (int x = 0; x < TARGET_W; ++x) {
-                    uint8_t v = imo[y][x];
-                    row[x] = (v <= 5) ? colorMap[v] : colorMap[6];  // 255或其他→白色
+            if (exportImo) {
+                // 流水线跨帧有状态（默认上下文），必须按帧序串行调用
+                if (!turnstile.wait(job.idx)) return;
+                process_packed_to_imo(packed.data(), imo_buf.data(), TARGET_W, TARGET_H);
+                overlay = *process_last_overlay(); // 下一帧会覆盖上下文中的列表，放行前取走
+                turnstile.advance();
+            }
+
+            char namebuf[64];
+            if (png) {
+                std::snprintf(namebuf, sizeof(namebuf), "frame_%06d.png", job.idx);
+                try {
+                    encode_png(job.frame, res.frame_png, namebuf);
+                } catch (const std::exception &e) {
+                    fail(5, e.what());
+                    return;
                 }
             }
-            std::snprintf(namebuf, sizeof(namebuf), "imo_%06d.png", idx);
-            fs::path outImo = outDir / namebuf;
-            try {
-                save_png(outImo, viz);
-            } catch (const std::exception &e) {
-                std::cerr << "\n错误: " << e.what() << std::endl;
-                return 6;
+
+            if (exportImo) {
+                render_imo_bgr(imo_buf.data(), overlay, viz);
+                if (png) {
+                    std::snprintf(namebuf, sizeof(namebuf), "imo_%06d.png", job.idx);
+                    try {
+                        encode_png(viz, res.imo_png, namebuf);
+                    } catch (const std::exception &e) {
+                        fail(6, e.what());
+                        return;
+                    }
+                }
+                if (video) compose_video_frame(job.frame, viz, opt.sideBySide, res.video_frame);
             }
+            job.frame.release();
+
+            if (!sink.push(std::move(res))) return;
         }
+    };
+
+    // 写盘线程：按帧序落盘并显示进度
+    int written = 0;
+    auto writer = [&]() {
+        FrameResult res;
+        while (sink.pop_next(res)) {
+            int idx = res.idx;
+            // 显示进度
+            if (idx % progress_interval == 0 || idx == total_frames) {
+                int progress = (idx * 100) / std::max(1, total_frames);
+                std::cout << "\r进度: " << progress << "% (" << idx << "/" << total_frames << ")" << std::flush;
+            }
+
+            // 导出原始帧 PNG（按原分辨率）
+            char namebuf[64];
+            if (png) {
+                std::snprintf(namebuf, sizeof(namebuf), "frame_%06d.png", idx);
+                try {
+                    write_file(outDir / namebuf, res.frame_png);
+                } catch (const std::exception &e) {
+                    fail(5, e.what());
+                    return;
+                }
+            }
+
+            if (png && exportImo) {
+                std::snprintf(namebuf, sizeof(namebuf), "imo_%06d.png", idx);
+                try {
+                    write_file(outDir / namebuf, res.imo_png);
+                } catch (const std::exception &e) {
+                    fail(6, e.what());
+                    return;
+                }
+            }
+            if (archive && ipf_writer_add(&arc, res.archive.data()) != 0) {
+                fail(8, "写入归档失败: " + opt.archive.string());
+                return;
+            }
+            if (video && !video_frames.push(std::move(res.video_frame))) return;
+            written = idx;
+        }
+    };
+
+    // 视频编码线程：按帧序写入 cv::VideoWriter，帧尺寸取第一帧（部分容器读不到准确的分辨率）
+    cv::VideoWriter vw;
+    auto encoder = [&]() {
+        cv::Mat frame;
+        while (video_frames.pop(frame)) {
+            if (!vw.isOpened()) {
+                const int fourcc = (opt.codec == "ffv1") ? cv::VideoWriter::fourcc('F', 'F', 'V', '1')
+                                                         : cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+                if (!vw.open(opt.video.string(), fourcc, fps > 0 ? fps : 30.0, frame.size(), true)) {
+                    fail(9, "无法创建视频: " + opt.video.string());
+                    return;
+                }
+            }
+            vw.write(frame);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < workers; ++i) pool.emplace_back(worker);
+    std::thread writer_thread(writer);
+    std::thread encoder_thread;
+    if (video) encoder_thread = std::thread(encoder);
+
+    // 解码（当前线程）：队列满时阻塞，形成反压
+    int idx = 0;
+    while (true) {
+        FrameJob job;
+        if (!cap.read(job.frame)) break;
+        job.idx = ++idx;
+        if (!jobs.push(std::move(job))) break;
     }
-    
+    jobs.close();
+    sink.finish(idx);
+
+    for (auto &t : pool) t.join();
+    writer_thread.join();
+    video_frames.close();
+    if (encoder_thread.joinable()) encoder_thread.join();
+    vw.release();
+
+    // 出错时同样关闭归档：写盘线程按帧序追加，已写入的前缀帧仍可回放
+    if (archive && ipf_writer_close(&arc) != 0 && exit_code == 0) {
+        exit_code = 8;
+        err_msg = "写入归档失败: " + opt.archive.string();
+    }
+
+    if (exit_code != 0) {
+        std::cerr << "\n错误: " << err_msg << std::endl;
+        return exit_code;
+    }
+
     std::cout << "\n完成！" << std::endl;
-    std::cout << "导出帧数: " << idx << std::endl;
+    std::cout << "导出帧数: " << written << std::endl;
     std::cout << "输出目录: " << outDir << std::endl;
+    if (video) {
+        std::cout << "标注视频: " << opt.video << std::endl;
+    }
+    if (archive) {
+        std::error_code ec;
+        const auto bytes = fs::file_size(opt.archive, ec);
+        std::cout << "帧归档: " << written << " 帧 -> " << opt.archive;
+        if (!ec && written > 0) std::cout << "（平均 " << bytes / (uintmax_t)written << " 字节/帧）";
+        std::cout << std::endl;
+    }
+    if (checkMorph) {
+        std::cout << "形态学校验: " << morph_checked << " 帧，不一致 " << morph_mismatch << " 帧" << std::endl;
+        if (morph_mismatch > 0) return 7;
+    }
+    if (opt.temporal && exportImo) {
+        print_temporal_stats(ctx);
+    }
+    if (exportImo && !write_stage_timing(opt, ctx)) return 6;
     return 0;
 }